@@ -0,0 +1,150 @@
+/*
+ * co_table_accuracy.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Host check of the MQ-9 CO table (HAL/Sensors/MQ9/co_sensor.c) against the curve it
+ *  tabulates, in double precision: every ADC code with Ro from 1 kohm to 100 kohm, integer Rs
+ *  and Rs/Ro included. Fails if an error goes past the bound documented in co_sensor.c. The
+ *  timings are host figures, the table lookup against the pow/log10 it replaces.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "co_sensor.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*datasheet CO curve in log10 coordinates, point 1 and slope (the former g_COCurve)*/
+#define CURVE_X					2.3
+#define CURVE_Y					0.20
+#define CURVE_SLOPE				(-0.45)
+
+#define RATIO_MIN				0.27		/*table span*/
+#define RATIO_MAX				17.3
+#define RO_MIN_OHMS				1000
+#define RO_MAX_OHMS				100000
+#define RO_STEP_OHMS			250
+#define BENCH_CALLS				2000000
+
+/*bounds documented in co_sensor.c*/
+#define HIGH_MAX_REL			0.018		/*50 .. 10000 ppm*/
+#define MIDDLE_MAX_REL			0.062		/*10 .. 50 ppm*/
+#define LOW_MAX_PPM				1.0			/*1 .. 10 ppm*/
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static int g_failures = 0;
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+/*the sensor is read from the ADC background sampling on the target, not used here*/
+boolean ADC_getSample(const ADC_SingleEndedIp channel_number, uint16 * value){
+	(void)channel_number;
+	*value = 512;
+	return TRUE;
+}
+
+void GPIO_setupPinDirection(uint8 port_num, uint8 pin_num, GPIO_PinDirectionType direction){
+	(void)port_num;
+	(void)pin_num;
+	(void)direction;
+}
+
+uint8 GPIO_readPin(uint8 port_num, uint8 pin_num){
+	(void)port_num;
+	(void)pin_num;
+	return LOGIC_LOW;
+}
+
+static double curvePpm(double ratio){
+	return pow(10, ((log10(ratio) - CURVE_Y) / CURVE_SLOPE) + CURVE_X);
+}
+
+static void check(const char * name, double error, double bound){
+	if(error > bound){
+		printf("FAIL %s: %.6g over %.6g\n", name, error, bound);
+		g_failures++;
+	}
+}
+
+static void accuracy(void){
+	double high_rel = 0, middle_rel = 0, low_ppm = 0, ratio, reference, error;
+	uint32 ro, rs, points = 0, outside = 0;
+	uint16 raw, ppm;
+
+	for(ro = RO_MIN_OHMS; ro <= RO_MAX_OHMS; ro += RO_STEP_OHMS){
+		for(raw = 1; raw < 1023; raw++){
+			rs = MQ_resistance(raw);
+			ppm = MQ_getCOppm(rs, ro);
+			ratio = (double)RL_OHMS * (1023 - raw) / raw / ro;
+			if((ratio < RATIO_MIN) || (ratio > RATIO_MAX)){
+				outside++;
+				continue;
+			}
+			points++;
+			reference = curvePpm(ratio);
+			error = fabs(ppm - reference);
+			if(reference >= 50){
+				high_rel = (error / reference > high_rel) ? error / reference : high_rel;
+			}
+			else if(reference >= 10){
+				middle_rel = (error / reference > middle_rel) ? error / reference : middle_rel;
+			}
+			else if(reference >= 1){
+				low_ppm = (error > low_ppm) ? error : low_ppm;
+			}
+		}
+	}
+	check("50 .. 10000 ppm", high_rel, HIGH_MAX_REL);
+	check("10 .. 50 ppm", middle_rel, MIDDLE_MAX_REL);
+	check("1 .. 10 ppm", low_ppm, LOW_MAX_PPM);
+	printf("%lu readings in the table span, %lu outside (Ro %u .. %u ohms, every ADC code)\n",
+			(unsigned long)points, (unsigned long)outside, RO_MIN_OHMS, RO_MAX_OHMS);
+	printf("    50 .. 10000 ppm     max error %.2f %%\n", high_rel * 100);
+	printf("    10 .. 50 ppm        max error %.2f %%\n", middle_rel * 100);
+	printf("     1 .. 10 ppm        max error %.2f ppm\n", low_ppm);
+}
+
+/*outside the span: the first entry below it, 0 above*/
+static void limits(void){
+	check("below the table", MQ_getCOppm(RO_MIN_OHMS / 10, RO_MIN_OHMS) != 10227, 0);
+	check("above the table", MQ_getCOppm(RO_MIN_OHMS * 20, RO_MIN_OHMS) != 0, 0);
+	check("no calibration", MQ_getCOppm(RO_MIN_OHMS, 0) != 0, 0);
+}
+
+static void benchmark(void){
+	volatile uint32 sink = 0;
+	volatile double sink_float = 0;
+	clock_t start;
+	uint32 i;
+
+	start = clock();
+	for(i = 0; i < BENCH_CALLS; i++){
+		sink += MQ_getCOppm(MQ_resistance(1 + i % 1022), 10000);
+	}
+	printf("MQ_resistance + MQ_getCOppm  %6.1f ns/call (host)\n",
+			(double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / BENCH_CALLS);
+	start = clock();
+	for(i = 0; i < BENCH_CALLS; i++){
+		sink_float += curvePpm((double)RL_OHMS * (1022 - i % 1022) / (1 + i % 1022) / 10000);
+	}
+	printf("float pow/log10 curve        %6.1f ns/call (host)\n",
+			(double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / BENCH_CALLS);
+}
+
+int main(void){
+	accuracy();
+	limits();
+	benchmark();
+	printf("%s\n", (g_failures == 0) ? "PASS" : "FAIL");
+	return (g_failures == 0) ? 0 : 1;
+}
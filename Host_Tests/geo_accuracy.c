@@ -0,0 +1,248 @@
+/*
+ * geo_accuracy.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Host check of Utils/geo against double precision references on the same sphere, over
+ *  random pairs up to 85 degrees of latitude (fixed seed, the output is reproducible).
+ *  Fails if an error goes past the bound documented in geo.h. The timings are host figures,
+ *  only their ratios carry over to the target.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "geo.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define EARTH_RADIUS_CM			637100880.0
+#define PAIRS_PER_SCALE			200000
+#define BENCH_CALLS				2000000
+
+/*bounds documented in geo.h*/
+#define DISTANCE_MAX_REL		0.005		/*GEO_distance(), plus 2 cm*/
+#define EQUIRECT_MAX_REL		0.0006		/*up to GEO_EQUIRECT_MAX_DELTA, plus 2 cm*/
+#define EQUIRECT_200KM_REL		0.0002		/*up to 200 km and 60 degrees of latitude, plus 2 cm*/
+#define HAVERSINE_90_CM			200000.0	/*up to 90 degrees apart*/
+#define HAVERSINE_150_CM		500000.0	/*up to 150 degrees apart*/
+#define BEARING_CLOSE_DEG		0.05		/*10 m to 100 km apart, up to 70 degrees of latitude*/
+#define BEARING_MAX_DEG			0.25		/*over 10 m apart*/
+#define TRIG_MAX_LSB			2.5
+#define ATAN2_MAX_DEG			0.004
+#define HYPOT_MAX_REL			0.0002
+#define ODOMETER_MAX_REL		0.0003
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static int g_failures = 0;
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+static double radians(double degrees){
+	return degrees * M_PI / 180.0;
+}
+
+static double coordinate(sint32 units){
+	return units / 1e7;
+}
+
+static double random01(void){
+	return rand() / (double)RAND_MAX;
+}
+
+/*central angle (radians) of the two points*/
+static double centralAngle(const GEO_Point * from, const GEO_Point * to){
+	double a = sin(radians(coordinate(to->latitude) - coordinate(from->latitude)) / 2);
+	double b = sin(radians(coordinate(to->longitude) - coordinate(from->longitude)) / 2);
+	double h = a * a + cos(radians(coordinate(from->latitude))) * cos(radians(coordinate(to->latitude))) * b * b;
+
+	return 2 * atan2(sqrt(h), sqrt(1 - h));
+}
+
+static double bearing(const GEO_Point * from, const GEO_Point * to){
+	double lat1 = radians(coordinate(from->latitude)), lat2 = radians(coordinate(to->latitude));
+	double dlon = radians(coordinate(to->longitude) - coordinate(from->longitude));
+	double degrees = atan2(sin(dlon) * cos(lat2), cos(lat1) * sin(lat2) - sin(lat1) * cos(lat2) * cos(dlon))
+			* 180.0 / M_PI;
+
+	return (degrees < 0) ? degrees + 360.0 : degrees;
+}
+
+static void check(const char * name, double error, double bound){
+	if(error > bound){
+		printf("FAIL %s: %.6g over %.6g\n", name, error, bound);
+		g_failures++;
+	}
+}
+
+static void randomPair(double scale_deg, GEO_Point * from, GEO_Point * to){
+	double lat1, lon1, lat2, lon2;
+
+	do{
+		lat1 = (random01() * 2 - 1) * 80;
+		lon1 = (random01() * 2 - 1) * 180;
+		lat2 = lat1 + (random01() * 2 - 1) * scale_deg;
+		lon2 = lon1 + (random01() * 2 - 1) * scale_deg;
+	}while((lat2 > 85) || (lat2 < -85));
+	if(lon2 > 180){
+		lon2 -= 360;
+	}
+	if(lon2 < -180){
+		lon2 += 360;
+	}
+	from->latitude = (sint32)lrint(lat1 * 1e7);
+	from->longitude = (sint32)lrint(lon1 * 1e7);
+	to->latitude = (sint32)lrint(lat2 * 1e7);
+	to->longitude = (sint32)lrint(lon2 * 1e7);
+}
+
+static void distanceAndBearing(void){
+	static const double scales_deg[] = {1e-4, 1e-2, 1, 2, 3.9, 4.1, 10, 60, 120, 170};
+	GEO_Point from, to;
+	double reference, error, equirect_rel, haversine_cm, bearing_deg, equirect_bound;
+	unsigned scale;
+	int i;
+
+	printf("pairs per scale: %d\n", PAIRS_PER_SCALE);
+	printf("%12s %14s %14s %14s %14s\n", "scale (deg)", "GEO_distance", "equirect", "haversine", "bearing");
+	printf("%12s %14s %14s %14s %14s\n", "", "max rel (%)", "max rel (%)", "max abs (m)", "max (deg)");
+	for(scale = 0; scale < sizeof(scales_deg) / sizeof(scales_deg[0]); scale++){
+		double distance_rel = 0;
+
+		equirect_rel = 0;
+		haversine_cm = 0;
+		bearing_deg = 0;
+		for(i = 0; i < PAIRS_PER_SCALE; i++){
+			randomPair(scales_deg[scale], &from, &to);
+			reference = centralAngle(&from, &to) * EARTH_RADIUS_CM;
+
+			error = fabs(GEO_distance(&from, &to) - reference);
+			check("distance", error, DISTANCE_MAX_REL * reference + 2);
+			if((reference > 1000) && (error / reference > distance_rel)){
+				distance_rel = error / reference;
+			}
+			if((labs(to.latitude - from.latitude) <= GEO_EQUIRECT_MAX_DELTA)
+					&& (labs(to.longitude - from.longitude) <= GEO_EQUIRECT_MAX_DELTA)){
+				error = fabs(GEO_equirectDistance(&from, &to) - reference);
+				equirect_bound = (((reference <= 20000000.0) && (labs(from.latitude) <= 60 * GEO_DEG)
+						&& (labs(to.latitude) <= 60 * GEO_DEG)) ? EQUIRECT_200KM_REL : EQUIRECT_MAX_REL) * reference + 2;
+				check("equirect distance", error, equirect_bound);
+				if((reference > 1000) && (error / reference > equirect_rel)){
+					equirect_rel = error / reference;
+				}
+			}
+			if(centralAngle(&from, &to) <= radians(150)){
+				error = fabs(GEO_haversineDistance(&from, &to) - reference);
+				check("haversine distance", error,
+						(centralAngle(&from, &to) <= radians(90)) ? HAVERSINE_90_CM : HAVERSINE_150_CM);
+				if(error > haversine_cm){
+					haversine_cm = error;
+				}
+			}
+			if(reference > 1000){
+				error = fabs(GEO_bearing(&from, &to) / 100.0 - bearing(&from, &to));
+				if(error > 180){
+					error = 360 - error;
+				}
+				check("bearing", error, ((reference <= 10000000.0) && (labs(from.latitude) <= 70 * GEO_DEG)
+						&& (labs(to.latitude) <= 70 * GEO_DEG)) ? BEARING_CLOSE_DEG : BEARING_MAX_DEG);
+				if(error > bearing_deg){
+					bearing_deg = error;
+				}
+			}
+		}
+		printf("%12.4f %14.5f %14.5f %14.1f %14.4f\n", scales_deg[scale], distance_rel * 100, equirect_rel * 100,
+				haversine_cm / 100, bearing_deg);
+	}
+}
+
+static void trigonometry(void){
+	double error, cos_lsb = 0, atan2_deg = 0, hypot_rel = 0;
+	sint32 angle, x, y;
+	int i;
+
+	for(angle = -1800000000; angle < 1800000000; angle += 99991){
+		error = fabs(GEO_cos(angle) - cos(radians(coordinate(angle))) * 32768);
+		cos_lsb = (error > cos_lsb) ? error : cos_lsb;
+		error = fabs(GEO_sin(angle) - sin(radians(coordinate(angle))) * 32768);
+		cos_lsb = (error > cos_lsb) ? error : cos_lsb;
+	}
+	for(i = 0; i < 1000000; i++){
+		y = (rand() % 2000001) - 1000000;
+		x = (rand() % 2000001) - 1000000;
+		error = fabs(GEO_atan2(y, x) / 1e7 - atan2(y, x) * 180.0 / M_PI);
+		atan2_deg = (error > atan2_deg) ? error : atan2_deg;
+		if((x != 0) || (y != 0)){
+			error = fabs(GEO_hypot(x, y) - hypot(x, y)) / hypot(x, y);
+			hypot_rel = (error > hypot_rel) ? error : hypot_rel;
+		}
+	}
+	check("cos/sin", cos_lsb, TRIG_MAX_LSB);
+	check("atan2", atan2_deg, ATAN2_MAX_DEG);
+	check("hypot", hypot_rel, HYPOT_MAX_REL);
+	printf("GEO_cos/GEO_sin max error %.2f LSB (Q15)\n", cos_lsb);
+	printf("GEO_atan2 max error %.6f deg\n", atan2_deg);
+	printf("GEO_hypot max error %.5f %%\n", hypot_rel * 100);
+}
+
+/*36000 steps of about 25 m heading north east, against the sum of the exact step lengths*/
+static void odometer(void){
+	GEO_Odometer odometer;
+	GEO_Point position = {473000000, 85000000};
+	GEO_Point previous;
+	double total_cm = 0, counted_cm, error;
+	int i;
+
+	GEO_odometerInit(&odometer, 500);
+	GEO_odometerUpdate(&odometer, &position);
+	for(i = 0; i < 36000; i++){
+		previous = position;
+		position.latitude += 200 + rand() % 50;
+		position.longitude += 150;
+		total_cm += centralAngle(&previous, &position) * EARTH_RADIUS_CM;
+		GEO_odometerUpdate(&odometer, &position);
+	}
+	counted_cm = odometer.total_m * 100.0 + odometer.remainder_cm;
+	error = (total_cm - counted_cm) / total_cm;
+	check("odometer", fabs(error), ODOMETER_MAX_REL);
+	printf("GEO_odometerUpdate %.2f m counted of %.2f m (%.4f %% short)\n", counted_cm / 100, total_cm / 100,
+			error * 100);
+}
+
+static void benchmark(const char * name, uint32 (*distance)(const GEO_Point *, const GEO_Point *), sint32 step){
+	GEO_Point from = {473000000, 85000000}, to = {473100000, 85200000};
+	volatile uint32 sink = 0;
+	clock_t start = clock();
+	int i;
+
+	for(i = 0; i < BENCH_CALLS; i++){
+		to.latitude += step;
+		sink += distance(&from, &to);
+	}
+	printf("%-24s %6.1f ns/call (host)\n", name, (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / BENCH_CALLS);
+}
+
+static uint32 bearingCall(const GEO_Point * from, const GEO_Point * to){
+	return GEO_bearing(from, to);
+}
+
+int main(void){
+	srand(1);
+	distanceAndBearing();
+	trigonometry();
+	odometer();
+	benchmark("GEO_equirectDistance", GEO_equirectDistance, 1);
+	benchmark("GEO_haversineDistance", GEO_haversineDistance, 100);
+	benchmark("GEO_bearing", bearingCall, 1);
+	printf("%s\n", (g_failures == 0) ? "PASS" : "FAIL");
+	return (g_failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,488 @@
+/*
+ * gsm_data_loopback.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Host runs of the data transports (HAL/SIM900A_GSM gsm_gprs.c and gsm_http.c, built
+ *  unchanged) against the scripted SIM900 of sim900/, which carries the socket data and the
+ *  HTTP POSTs to listeners of this program on 127.0.0.1. Each profile runs 10 minutes of
+ *  virtual time: numbered records are sent one at a time, each again until the transport
+ *  reports it sent, then the traffic drains. The GPRS listener closes the socket every
+ *  close_every records, the HTTP listener answers 500 to every close_every-th POST, so the
+ *  reconnection and the failure paths run as well. A profile fails if a record reported
+ *  sent never reached the listener, a record arrives corrupt or before an earlier one, a
+ *  POST is not the one the driver configured (path, content type), a record is never
+ *  sent, or, on a modem that neither fails nor drops, a record arrives twice or a command times out. Every profile
+ *  runs in a child process since the driver state is static, PROFILE=<index> runs a single one.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "gsm.h"
+#include "sim900.h"
+#include "host.h"
+#include "uart_arbiter.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define TRAFFIC_MS				(10UL * 60 * 1000)
+#define DRAIN_MAX_MS			(10UL * 60 * 1000)	/*a few set-up failures in a row back off 2 min*/
+#define INIT_MAX_MS				30000
+#define MAX_RECORDS				1000
+#define RECORD_MARK				0xA5
+#define RECORD_OVERHEAD			5		/*mark, sequence number (2), payload length, checksum*/
+#define RECORD_MAX_PAYLOAD		56
+#define LOOPBACK_HOST			"127.0.0.1"
+#define LOOPBACK_PATH			"/t"
+#define STREAM_SIZE				1024
+#define REQUEST_SIZE			1024
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+/*a record is generated every send_period_ms, see the file header for close_every*/
+typedef struct{
+	const char * name;
+	SIM900_ConfigType modem;
+	boolean http;
+	uint16 send_period_ms;
+	uint16 close_every;
+}PROFILE_ConfigType;
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static const PROFILE_ConfigType g_profiles[] = {
+	{"GPRS",                {30, 20, 0, 0, 0, 0, 0, 0, 21, NULL_PTR, 300, 200}, FALSE, 2000, 25},
+	{"GPRS errors + drops", {50, 40, 0, 0, 5, 2, 0, 0, 22, NULL_PTR, 300, 200}, FALSE, 3000, 25},
+	{"HTTP",                {30, 20, 0, 0, 0, 0, 0, 0, 23, NULL_PTR, 500, 300}, TRUE,  3000, 20},
+	{"HTTP errors + drops", {50, 40, 0, 0, 5, 2, 0, 0, 24, NULL_PTR, 500, 300}, TRUE,  4000, 20},
+};
+
+static const PROFILE_ConfigType * g_profile;
+static boolean g_lossless;
+
+/*transport configurations, built once the listener ports are known*/
+static char g_gprs_host[] = LOOPBACK_HOST;
+static char g_http_url[32];
+static GPRS_ConfigType g_gprs_config = {"internet", g_gprs_host, 0};
+static HTTP_ConfigType g_http_config = {"internet", g_http_url};
+
+/*sender*/
+static uint8 g_record[RECORD_OVERHEAD + RECORD_MAX_PAYLOAD];
+static uint16 g_generated;
+static uint16 g_next;							/*record being sent*/
+static boolean g_in_flight;
+static uint32 g_generated_ms[MAX_RECORDS];
+static uint32 g_max_latency_ms;
+static uint32 g_send_failures;
+
+/*listeners*/
+static int g_listen_fd = -1;
+static int g_connection_fd = -1;
+static uint8 g_stream[STREAM_SIZE];				/*GPRS socket data not yet parsed*/
+static uint16 g_stream_length;
+static uint16 g_connection_records;
+static char g_request[REQUEST_SIZE];			/*HTTP request being received*/
+static uint16 g_request_length;
+static uint16 g_received[MAX_RECORDS];
+static sint32 g_last_received = -1;
+static uint32 g_closes;
+static uint32 g_requests;
+static uint32 g_rejected;
+static uint32 g_corrupt;
+static uint32 g_out_of_order;
+static uint32 g_bad_requests;
+
+static GSM_CmdStatus g_init_status;
+static int g_failures;
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+/*the line stays with the modem, there is no GPS in these runs*/
+void ARBITER_awaitUrc(uint8 driver, boolean waiting){
+	(void)driver;
+	(void)waiting;
+}
+
+static void fail(const char * what, unsigned long count){
+	if(count > 0){
+		printf("    FAIL %s: %lu\n", what, count);
+		g_failures++;
+	}
+}
+
+static uint8 recordPayloadLength(uint16 sequence){
+	return 8 + (sequence % (RECORD_MAX_PAYLOAD - 7));
+}
+
+static uint8 recordBuild(uint16 sequence, uint8 * record){
+	uint8 length = recordPayloadLength(sequence);
+	uint8 checksum = 0;
+	uint8 i;
+
+	record[0] = RECORD_MARK;
+	record[1] = (uint8)sequence;
+	record[2] = (uint8)(sequence >> 8);
+	record[3] = length;
+	for(i = 0; i < length; i++){
+		record[4 + i] = (uint8)(sequence * 7 + i);
+	}
+	for(i = 0; i < length + 4; i++){
+		checksum ^= record[i];
+	}
+	record[length + 4] = checksum;
+	return length + RECORD_OVERHEAD;
+}
+
+/*whole record at data, 0 if it is not one the sender built*/
+static boolean recordCheck(const uint8 * data, uint16 length){
+	uint8 record[RECORD_OVERHEAD + RECORD_MAX_PAYLOAD];
+	uint16 sequence;
+
+	if((length < RECORD_OVERHEAD) || (data[0] != RECORD_MARK)){
+		return FALSE;
+	}
+	sequence = data[1] | (data[2] << 8);
+	return (sequence < g_generated) && (length == recordBuild(sequence, record)) && (memcmp(data, record, length) == 0);
+}
+
+static void recordReceived(const uint8 * data){
+	uint16 sequence = data[1] | (data[2] << 8);
+
+	if(sequence < g_last_received){
+		g_out_of_order++;
+	}
+	g_last_received = sequence;
+	g_received[sequence]++;
+}
+
+static int listenerOpen(unsigned * port){
+	struct sockaddr_in address;
+	socklen_t length = sizeof(address);
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if((fd < 0) || (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0) || (listen(fd, 4) != 0) ||
+			(getsockname(fd, (struct sockaddr *)&address, &length) != 0)){
+		return -1;
+	}
+	fcntl(fd, F_SETFL, O_NONBLOCK);
+	*port = ntohs(address.sin_port);
+	return fd;
+}
+
+static void connectionClose(void){
+	close(g_connection_fd);
+	g_connection_fd = -1;
+}
+
+/*
+ * Description :
+ * GPRS listener: the socket data is parsed into records as it comes, the socket is closed
+ * after close_every of them (the modem announces CLOSED and the driver reconnects).
+ */
+static void gprsListen(void){
+	ssize_t length;
+	uint16 record_length;
+	int fd = accept(g_listen_fd, NULL_PTR, NULL_PTR);
+
+	if(fd >= 0){
+		if(g_connection_fd >= 0){
+			connectionClose(); /*the modem opened a new socket, the old one is finished*/
+		}
+		fcntl(fd, F_SETFL, O_NONBLOCK);
+		g_connection_fd = fd;
+		g_stream_length = 0;
+		g_connection_records = 0;
+	}
+	if(g_connection_fd < 0){
+		return;
+	}
+	length = recv(g_connection_fd, &g_stream[g_stream_length], sizeof(g_stream) - g_stream_length, 0);
+	if(length == 0){
+		connectionClose(); /*AT+CIPSHUT*/
+		return;
+	}
+	if(length < 0){
+		return;
+	}
+	g_stream_length += length;
+	while((g_stream_length >= 4) && (g_stream_length >= g_stream[3] + RECORD_OVERHEAD)){
+		record_length = g_stream[3] + RECORD_OVERHEAD;
+		if(!recordCheck(g_stream, record_length)){
+			g_corrupt++;
+			g_stream_length = 0; /*out of step, wait for the next socket*/
+			return;
+		}
+		recordReceived(g_stream);
+		g_stream_length -= record_length;
+		memmove(g_stream, &g_stream[record_length], g_stream_length);
+		if(++g_connection_records == g_profile->close_every){
+			connectionClose();
+			g_closes++;
+			return;
+		}
+	}
+}
+
+/*
+ * Description :
+ * HTTP listener: one POST per connection, answered once its Content-Length bytes arrived,
+ * with 500 (record not taken) to every close_every-th one.
+ */
+static void httpListen(void){
+	static const char ok_reply[] = "HTTP/1.0 200 OK\r\nContent-Length: 2\r\n\r\nOK";
+	static const char error_reply[] = "HTTP/1.0 500 Internal Server Error\r\nContent-Length: 0\r\n\r\n";
+	ssize_t length;
+	char * body;
+	char * content_type;
+	unsigned content_length;
+	boolean rejected;
+	int fd = accept(g_listen_fd, NULL_PTR, NULL_PTR);
+
+	if(fd >= 0){
+		if(g_connection_fd >= 0){
+			connectionClose();
+		}
+		fcntl(fd, F_SETFL, O_NONBLOCK);
+		g_connection_fd = fd;
+		g_request_length = 0;
+	}
+	if(g_connection_fd < 0){
+		return;
+	}
+	length = recv(g_connection_fd, &g_request[g_request_length], sizeof(g_request) - 1 - g_request_length, 0);
+	if(length <= 0){
+		if(length == 0){
+			connectionClose();
+		}
+		return;
+	}
+	g_request_length += length;
+	g_request[g_request_length] = '\0';
+	body = strstr(g_request, "\r\n\r\n");
+	content_type = strstr(g_request, "\r\nContent-Length: ");
+	if((body == NULL_PTR) || (content_type == NULL_PTR) || (sscanf(content_type, "\r\nContent-Length: %u", &content_length) != 1)
+			|| (g_request_length < (body + 4 - g_request) + content_length)){
+		return; /*not all there yet*/
+	}
+	body += 4;
+	g_requests++;
+	content_type = strstr(g_request, "\r\nContent-Type: ");
+	if((strncmp(g_request, "POST " LOOPBACK_PATH " HTTP/1.", 13) != 0) || (content_type == NULL_PTR) ||
+			(strncmp(&content_type[16], HTTP_CONTENT_TYPE "\r\n", strlen(HTTP_CONTENT_TYPE) + 2) != 0)){
+		g_bad_requests++;
+	}
+	rejected = (g_requests % g_profile->close_every) == 0;
+	if(!recordCheck((const uint8 *)body, content_length)){
+		g_corrupt++;
+	}
+	else if(!rejected){
+		recordReceived((const uint8 *)body);
+	}
+	g_rejected += rejected;
+	send(g_connection_fd, rejected ? error_reply : ok_reply, rejected ? sizeof(error_reply) - 1 : sizeof(ok_reply) - 1,
+			MSG_NOSIGNAL);
+	connectionClose();
+}
+
+static void sendDone(boolean sent){
+	uint32 latency_ms;
+
+	g_in_flight = FALSE;
+	if(!sent){
+		g_send_failures++;
+		return; /*the same record goes again*/
+	}
+	latency_ms = SYSTICK_elapsedMs(g_generated_ms[g_next]);
+	if(latency_ms > g_max_latency_ms){
+		g_max_latency_ms = latency_ms;
+	}
+	g_next++;
+}
+
+/*one pass of the main loop: the transport, the listener and the next record*/
+static void pass(void){
+	uint8 length;
+
+	GSM_task();
+	if(g_profile->http){
+		HTTP_task();
+		httpListen();
+	}
+	else{
+		GPRS_task();
+		gprsListen();
+	}
+	if(!g_in_flight && (g_next < g_generated)){
+		length = recordBuild(g_next, g_record);
+		g_in_flight = g_profile->http ? HTTP_post(g_record, length, sendDone) : GPRS_send(g_record, length, sendDone);
+	}
+	HOST_advanceMs(1);
+}
+
+static void initDone(GSM_CmdStatus status){
+	g_init_status = status;
+}
+
+/*ATE0 as GSM_init(), submitted so the clock can move while it runs*/
+static boolean modemInit(void){
+	uint32 start_ms = SYSTICK_getMs();
+
+	do{
+		if(SYSTICK_elapsedMs(start_ms) >= INIT_MAX_MS){
+			return FALSE;
+		}
+		g_init_status = GSM_CMD_PENDING;
+		GSM_submitCmd(NO_ECHO_CMD, NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR, initDone);
+		while(g_init_status == GSM_CMD_PENDING){
+			GSM_task();
+			HOST_advanceMs(1);
+		}
+	}while(g_init_status != GSM_CMD_OK);
+	return TRUE;
+}
+
+static void report(uint32 drain_ms){
+	GSM_EngineStats engine;
+	SIM900_Stats modem;
+	unsigned long received = 0, duplicated = 0, sent_lost = 0;
+	uint32 commands;
+	uint16 sequence;
+
+	GSM_getStats(&engine);
+	SIM900_getStats(&modem);
+	commands = engine.completed + engine.failed + engine.timeouts;
+	for(sequence = 0; sequence < g_generated; sequence++){
+		received += (g_received[sequence] > 0);
+		duplicated += (g_received[sequence] > 1);
+		sent_lost += (sequence < g_next) && (g_received[sequence] == 0);
+	}
+
+	printf("  virtual time %lu s (drained in %lu s)\n", (unsigned long)(SYSTICK_getMs() / 1000),
+			(unsigned long)(drain_ms / 1000));
+	printf("  engine: %u OK, %u errors, %u timeouts (%u late results discarded), %u URCs, latency avg %lu ms max %u ms\n",
+			engine.completed, engine.failed, engine.timeouts, engine.late_results, engine.urcs,
+			(unsigned long)((commands > 0) ? engine.total_latency_ms / commands : 0), engine.max_latency_ms);
+	printf("  modem: %lu commands, %lu errors and %lu drops injected, %lu unknown, %lu sockets opened,"
+			" %lu closed by the listener, %lu bytes sent, %lu POSTs\n", (unsigned long)modem.commands,
+			(unsigned long)modem.errors, (unsigned long)modem.dropped, (unsigned long)modem.unknown,
+			(unsigned long)modem.tcp_connects, (unsigned long)modem.tcp_closed, (unsigned long)modem.tcp_bytes,
+			(unsigned long)modem.http_posts);
+	printf("  records: %u generated, %u reported sent, %lu send failures, generated to sent max %lu ms\n",
+			g_generated, g_next, (unsigned long)g_send_failures, (unsigned long)g_max_latency_ms);
+	printf("  listener: %lu received, %lu more than once, %lu corrupt, %lu out of order, %lu sockets closed,"
+			" %lu POSTs (%lu answered 500, %lu not as configured)\n", received, duplicated, (unsigned long)g_corrupt,
+			(unsigned long)g_out_of_order, (unsigned long)g_closes, (unsigned long)g_requests,
+			(unsigned long)g_rejected, (unsigned long)g_bad_requests);
+
+	fail("records reported sent that never reached the listener", sent_lost);
+	fail("corrupt records", g_corrupt);
+	fail("records out of order", g_out_of_order);
+	fail("POSTs not as configured", g_bad_requests);
+	fail("records never sent", g_generated - g_next);
+	fail("modem model errors", modem.unknown);
+	if(g_lossless){
+		fail("records received twice from a lossless modem", duplicated);
+		fail("commands timed out on a lossless modem", engine.timeouts); /*the set-up clean-up steps may fail*/
+	}
+}
+
+static void runProfile(const PROFILE_ConfigType * profile){
+	uint32 next_record_ms, drain_start_ms;
+	unsigned port;
+
+	g_profile = profile;
+	g_lossless = (profile->modem.error_pct == 0) && (profile->modem.drop_pct == 0);
+	g_listen_fd = listenerOpen(&port);
+	if(g_listen_fd < 0){
+		fail("no loopback listener", 1);
+		return;
+	}
+	g_gprs_config.port = port;
+	snprintf(g_http_url, sizeof(g_http_url), "http://" LOOPBACK_HOST ":%u" LOOPBACK_PATH, port);
+
+	SYSTICK_init();
+	SIM900_init(&profile->modem);
+	USART_init(NULL_PTR);
+	if(!modemInit()){
+		fail("modem initialization", 1);
+		return;
+	}
+	if(profile->http){
+		HTTP_init(&g_http_config);
+	}
+	else{
+		GPRS_init(&g_gprs_config);
+	}
+	GSM_resetStats();
+
+	next_record_ms = SYSTICK_getMs();
+	while(SYSTICK_getMs() < TRAFFIC_MS){
+		if(((sint32)(SYSTICK_getMs() - next_record_ms) >= 0) && (g_generated < MAX_RECORDS)){
+			g_generated_ms[g_generated++] = SYSTICK_getMs();
+			next_record_ms += profile->send_period_ms;
+		}
+		pass();
+	}
+	drain_start_ms = SYSTICK_getMs();
+	while((g_in_flight || (g_next < g_generated)) && (SYSTICK_elapsedMs(drain_start_ms) < DRAIN_MAX_MS)){
+		pass();
+	}
+	HOST_advanceMs(1000); /*the last data reaches the listener*/
+	if(profile->http){
+		httpListen();
+	}
+	else{
+		gprsListen();
+	}
+	report(SYSTICK_elapsedMs(drain_start_ms));
+}
+
+int main(void){
+	unsigned profile, failed = 0;
+	int status;
+	pid_t pid;
+
+	for(profile = 0; profile < sizeof(g_profiles) / sizeof(g_profiles[0]); profile++){
+		const PROFILE_ConfigType * config = &g_profiles[profile];
+
+		if((getenv("PROFILE") != NULL_PTR) && (atoi(getenv("PROFILE")) != (int)profile)){
+			continue; /*PROFILE=<index> runs a single profile*/
+		}
+		printf("%s: latency %u+-%u ms, network %u+-%u ms, %u %% errors, %u %% drops, a record every %u ms,"
+				" %s every %u\n", config->name, config->modem.latency_ms, config->modem.jitter_ms,
+				config->modem.net_latency_ms, config->modem.net_jitter_ms, config->modem.error_pct,
+				config->modem.drop_pct, config->send_period_ms,
+				config->http ? "500 answered" : "socket closed by the listener", config->close_every);
+		fflush(stdout);
+		pid = fork();
+		if(pid == 0){
+			runProfile(config);
+			fflush(stdout);
+			_exit(g_failures > 0);
+		}
+		waitpid(pid, &status, 0);
+		failed += !WIFEXITED(status) || (WEXITSTATUS(status) != 0);
+	}
+	printf("%s\n", (failed == 0) ? "PASS" : "FAIL");
+	return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,512 @@
+/*
+ * gsm_stress.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Host stress runs of the AT engine (HAL/SIM900A_GSM gsm.c, gsm_urc.c, gsm_outbox.c, built
+ *  unchanged) against the scripted SIM900 of sim900/. Each profile runs 30 minutes of virtual
+ *  time: SMS posted to the outbox and SMS arriving with +CMTI, taken with the batch inbox flow
+ *  of APP/app.c (AT+CMGL "ALL", AT+CMGDA "DEL READ", AT+CMGD per message after a failure),
+ *  then lets the traffic drain. A profile fails if an incoming message is lost or decoded
+ *  twice, an outbox entry never ends, a SENT message never reached the modem, or, on a
+ *  modem that neither fails nor drops (late answers included), an SMS is not sent exactly
+ *  once or a command fails. Every profile runs in
+ *  a child process since the driver state is static, PROFILE=<index> runs a single one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "gsm.h"
+#include "sim900.h"
+#include "host.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define TRAFFIC_MS				(30UL * 60 * 1000)
+#define DRAIN_MAX_MS			(10UL * 60 * 1000)
+#define INIT_MAX_MS				30000
+#define MAX_MESSAGES			2000
+#define CONTACTS				16
+#define NO_ID					0xFFFF
+
+/*as in APP/app.h*/
+#define INBOX_QUEUE_SIZE		2
+#define INBOX_RETRY_MS			5000
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+/*
+ * stall_pct of the main loop passes take up to stall_max_ms more than 1 ms, the SMS are posted
+ * and arrive every period on average (uniform from 0 to twice the period), at most
+ * receive_limit of them arrive.
+ */
+typedef struct{
+	const char * name;
+	SIM900_ConfigType modem;
+	uint16 stall_max_ms;
+	uint8 stall_pct;
+	uint16 send_period_ms;
+	uint16 receive_period_ms;
+	uint16 receive_limit;
+}PROFILE_ConfigType;
+
+typedef struct{
+	char sender_number[DIAL_NO_LENGTH];
+	char message[REC_MSG_MAX_LENGTH];
+}INBOX_Entry;
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static void smsSent(const char * number, const char * text);
+
+static const PROFILE_ConfigType g_profiles[] = {
+	{"nominal",        {30, 20, 3000, 2000, 0, 0, 0, 0, 11, smsSent},      0, 0, 4000, 5000, MAX_MESSAGES},
+	{"slow modem",     {400, 300, 6000, 4000, 0, 0, 0, 0, 12, smsSent},    0, 0, 15000, 8000, MAX_MESSAGES},
+	{"errors + drops", {50, 40, 3000, 2000, 5, 2, 0, 0, 13, smsSent},      0, 0, 10000, 10000, MAX_MESSAGES},
+	{"busy main loop", {30, 20, 3000, 2000, 0, 0, 0, 0, 14, smsSent},      50, 5, 4000, 5000, MAX_MESSAGES},
+	{"SMS burst",      {30, 20, 3000, 2000, 0, 0, 0, 0, 15, smsSent},      20, 10, 10000, 300, 150},
+	{"late responses", {50, 40, 3000, 2000, 0, 0, 5, 1500, 16, smsSent},   0, 0, 10000, 10000, MAX_MESSAGES},
+};
+
+static uint32 g_random = 1;
+static boolean g_lossless;
+
+/*outgoing SMS*/
+static char g_out_text[MAX_MESSAGES][12];
+static uint8 g_out_contact[MAX_MESSAGES];
+static GSM_OutboxState g_out_state[MAX_MESSAGES];
+static uint16 g_out_modem_count[MAX_MESSAGES];	/*submitted by the modem, retries included*/
+static uint32 g_out_posted_ms[MAX_MESSAGES];
+static uint16 g_out_count;
+static uint16 g_slot_id[GSM_OUTBOX_SIZE];
+static uint32 g_out_max_latency_ms;
+static uint32 g_outbox_full_passes;
+
+/*incoming SMS*/
+static uint32 g_in_delivered_ms[MAX_MESSAGES];
+static uint16 g_in_decoded[MAX_MESSAGES];
+static uint16 g_in_count;
+static uint32 g_in_max_latency_ms;
+static uint32 g_in_total_latency_ms;
+
+/*inbox flow of APP/app.c*/
+static INBOX_Entry g_inbox_queue[INBOX_QUEUE_SIZE];
+static uint8 g_inbox_head;
+static uint8 g_inbox_count;
+static uint8 g_inbox_taken[INBOX_QUEUE_SIZE];
+static uint8 g_inbox_taken_count;
+static uint8 g_inbox_delete_count;
+static boolean g_inbox_deleting;
+static boolean g_inbox_delete_read;
+static boolean g_inbox_scan_request = TRUE;
+static boolean g_inbox_scanning;
+static boolean g_inbox_check_storage;
+static boolean g_inbox_retry_wait;
+static uint32 g_inbox_retry_ms;
+static uint32 g_inbox_listings;
+
+static GSM_CmdStatus g_init_status;
+static int g_failures;
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+static uint32 randomBelow(uint32 range){
+	g_random ^= g_random << 13;
+	g_random ^= g_random >> 17;
+	g_random ^= g_random << 5;
+	return (range == 0) ? 0 : (g_random % range);
+}
+
+static void fail(const char * what, unsigned long count){
+	if(count > 0){
+		printf("    FAIL %s: %lu\n", what, count);
+		g_failures++;
+	}
+}
+
+static void contactNumber(uint8 contact, char * number){
+	sprintf(number, "+2010000000%02u", contact % CONTACTS);
+}
+
+static void smsSent(const char * number, const char * text){
+	char expected[DIAL_NO_LENGTH];
+	unsigned id;
+
+	if((sscanf(text, "out %u", &id) != 1) || (id >= g_out_count)){
+		printf("    FAIL modem sent an unknown SMS \"%s\"\n", text);
+		g_failures++;
+		return;
+	}
+	contactNumber(g_out_contact[id], expected);
+	if(strcmp(number, expected) != 0){
+		printf("    FAIL SMS %u sent to %s instead of %s\n", id, number, expected);
+		g_failures++;
+	}
+	g_out_modem_count[id]++;
+}
+
+static void newMsgNotification(const GSM_UrcData * urc){
+	(void)urc;
+	g_inbox_scan_request = TRUE;
+}
+
+static boolean inboxStore(uint8 index, const char * sender_number){
+	INBOX_Entry * entry;
+
+	if((g_inbox_count == INBOX_QUEUE_SIZE) || (g_inbox_taken_count == INBOX_QUEUE_SIZE)){
+		return FALSE;
+	}
+	entry = &g_inbox_queue[(g_inbox_head + g_inbox_count) % INBOX_QUEUE_SIZE];
+	snprintf(entry->sender_number, sizeof(entry->sender_number), "%s", sender_number);
+	GSM_lineCopy(entry->message, sizeof(entry->message));
+	g_inbox_count++;
+	g_inbox_taken[g_inbox_taken_count++] = index;
+	return TRUE;
+}
+
+static void inboxReadDeleted(GSM_CmdStatus status){
+	if(status == GSM_CMD_TIMEOUT){
+		g_inbox_delete_read = TRUE;
+		return;
+	}
+	g_inbox_scanning = FALSE;
+	if(status != GSM_CMD_OK){
+		g_inbox_delete_count = g_inbox_taken_count;
+	}
+	g_inbox_check_storage = TRUE;
+}
+
+static void inboxListed(GSM_CmdStatus status){
+	if((status == GSM_CMD_OK) && GSM_listAllTaken() && GSM_deleteReadMsgs(inboxReadDeleted)){
+		return;
+	}
+	g_inbox_scanning = FALSE;
+	g_inbox_delete_count = g_inbox_taken_count;
+	g_inbox_check_storage = TRUE;
+	g_inbox_scan_request = TRUE;
+	if(status != GSM_CMD_OK){
+		g_inbox_retry_wait = TRUE;
+		g_inbox_retry_ms = SYSTICK_getMs();
+	}
+}
+
+static void inboxMsgDeleted(GSM_CmdStatus status){
+	g_inbox_deleting = FALSE;
+	if((status == GSM_CMD_ERROR) || (status == GSM_CMD_CMS_ERROR)){
+		g_inbox_retry_wait = TRUE;
+		g_inbox_retry_ms = SYSTICK_getMs();
+		return;
+	}
+	g_inbox_delete_count--;
+}
+
+static void inboxStorageChecked(GSM_CmdStatus status){
+	if((status == GSM_CMD_OK) && (GSM_getStorageUsed() > 0)){
+		g_inbox_scan_request = TRUE;
+	}
+}
+
+static void inboxTask(void){
+	if(g_inbox_delete_count > 0){
+		if(!g_inbox_deleting && (!g_inbox_retry_wait || (SYSTICK_elapsedMs(g_inbox_retry_ms) >= INBOX_RETRY_MS))
+				&& GSM_deleteMsg(g_inbox_taken[g_inbox_delete_count - 1], inboxMsgDeleted)){
+			g_inbox_deleting = TRUE;
+			g_inbox_retry_wait = FALSE;
+		}
+		return;
+	}
+	if(g_inbox_delete_read && GSM_deleteReadMsgs(inboxReadDeleted)){
+		g_inbox_delete_read = FALSE;
+	}
+	if(g_inbox_check_storage && GSM_queryStorage(inboxStorageChecked)){
+		g_inbox_check_storage = FALSE;
+	}
+	if(g_inbox_scan_request && !g_inbox_scanning && (g_inbox_count < INBOX_QUEUE_SIZE)
+			&& (!g_inbox_retry_wait || (SYSTICK_elapsedMs(g_inbox_retry_ms) >= INBOX_RETRY_MS))){
+		g_inbox_taken_count = 0;
+		if(GSM_listMsgs(MSG_STAT_ALL, inboxStore, inboxListed)){
+			g_inbox_scanning = TRUE;
+			g_inbox_scan_request = FALSE;
+			g_inbox_retry_wait = FALSE;
+			g_inbox_listings++;
+		}
+	}
+}
+
+/*the main loop decodes one received command per pass*/
+static void inboxDecode(void){
+	INBOX_Entry * entry;
+	uint32 latency_ms;
+	unsigned id;
+
+	if(g_inbox_count == 0){
+		return;
+	}
+	entry = &g_inbox_queue[g_inbox_head];
+	g_inbox_head = (g_inbox_head + 1) % INBOX_QUEUE_SIZE;
+	g_inbox_count--;
+	if((sscanf(entry->message, "in %u", &id) != 1) || (id >= g_in_count)){
+		printf("    FAIL decoded an unknown SMS \"%s\" from %s\n", entry->message, entry->sender_number);
+		g_failures++;
+		return;
+	}
+	if(g_in_decoded[id]++ == 0){
+		latency_ms = SYSTICK_elapsedMs(g_in_delivered_ms[id]);
+		g_in_total_latency_ms += latency_ms;
+		if(latency_ms > g_in_max_latency_ms){
+			g_in_max_latency_ms = latency_ms;
+		}
+	}
+}
+
+/*final states of the posted SMS, read before their slot can be reused*/
+static void outboxPoll(void){
+	GSM_OutboxState state;
+	uint32 latency_ms;
+	uint8 slot;
+
+	for(slot = 0; slot < GSM_OUTBOX_SIZE; slot++){
+		if(g_slot_id[slot] == NO_ID){
+			continue;
+		}
+		state = GSM_outboxGetState(slot);
+		if((state == GSM_OUTBOX_SENT) || (state == GSM_OUTBOX_FAILED)){
+			g_out_state[g_slot_id[slot]] = state;
+			latency_ms = SYSTICK_elapsedMs(g_out_posted_ms[g_slot_id[slot]]);
+			if((state == GSM_OUTBOX_SENT) && (latency_ms > g_out_max_latency_ms)){
+				g_out_max_latency_ms = latency_ms;
+			}
+			g_slot_id[slot] = NO_ID;
+		}
+	}
+}
+
+/*the next SMS is posted again on every pass until the outbox takes it*/
+static boolean outboxPost(void){
+	char number[DIAL_NO_LENGTH];
+	uint8 slot;
+
+	contactNumber(g_out_contact[g_out_count], number);
+	slot = GSM_outboxPost(number, g_out_text[g_out_count], GSM_PRIORITY_ROUTINE);
+	if(slot == GSM_OUTBOX_NO_SLOT){
+		g_outbox_full_passes++;
+		return FALSE;
+	}
+	g_slot_id[slot] = g_out_count;
+	g_out_state[g_out_count] = GSM_OUTBOX_PENDING;
+	g_out_posted_ms[g_out_count] = SYSTICK_getMs();
+	g_out_count++;
+	return TRUE;
+}
+
+static void incomingSms(void){
+	char number[DIAL_NO_LENGTH];
+	char text[12];
+
+	contactNumber(randomBelow(CONTACTS), number);
+	sprintf(text, "in %u", g_in_count);
+	g_in_delivered_ms[g_in_count++] = SYSTICK_getMs();
+	SIM900_deliverSms(number, text);
+}
+
+static void initDone(GSM_CmdStatus status){
+	g_init_status = status;
+}
+
+/*ATE0 then AT+CMGF=1 as GSM_init(), submitted so the clock can move while they run*/
+static boolean modemInit(void){
+	static const char * const commands[] = {NO_ECHO_CMD, TEXT_MODE_CMD};
+	uint32 start_ms = SYSTICK_getMs();
+	uint8 i = 0;
+
+	while(i < 2){
+		if(SYSTICK_elapsedMs(start_ms) >= INIT_MAX_MS){
+			return FALSE;
+		}
+		g_init_status = GSM_CMD_PENDING;
+		GSM_submitCmd(commands[i], NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR, initDone);
+		while(g_init_status == GSM_CMD_PENDING){
+			GSM_task();
+			HOST_advanceMs(1);
+		}
+		i += (g_init_status == GSM_CMD_OK);
+	}
+	return TRUE;
+}
+
+static boolean drained(void){
+	uint8 slot;
+
+	for(slot = 0; slot < GSM_OUTBOX_SIZE; slot++){
+		if(g_slot_id[slot] != NO_ID){
+			return FALSE;
+		}
+	}
+	return GSM_isIdle() && (g_inbox_count == 0) && !g_inbox_scanning && !g_inbox_scan_request
+			&& (g_inbox_delete_count == 0) && (SIM900_simUsed() == 0);
+}
+
+static void report(const PROFILE_ConfigType * profile, uint32 drain_ms){
+	GSM_EngineStats engine;
+	SIM900_Stats modem;
+	unsigned long lost = 0, duplicated = 0, stuck = 0, sent = 0, failed = 0, sent_lost = 0;
+	unsigned long resent = 0, failed_delivered = 0, not_once = 0;
+	uint32 commands;
+	uint16 id;
+
+	GSM_getStats(&engine);
+	SIM900_getStats(&modem);
+	commands = engine.completed + engine.failed + engine.timeouts;
+	for(id = 0; id < g_in_count; id++){
+		lost += (g_in_decoded[id] == 0);
+		duplicated += (g_in_decoded[id] > 1);
+	}
+	for(id = 0; id < g_out_count; id++){
+		sent += (g_out_state[id] == GSM_OUTBOX_SENT);
+		failed += (g_out_state[id] == GSM_OUTBOX_FAILED);
+		stuck += (g_out_state[id] != GSM_OUTBOX_SENT) && (g_out_state[id] != GSM_OUTBOX_FAILED);
+		sent_lost += (g_out_state[id] == GSM_OUTBOX_SENT) && (g_out_modem_count[id] == 0);
+		resent += (g_out_modem_count[id] > 1);
+		failed_delivered += (g_out_state[id] == GSM_OUTBOX_FAILED) && (g_out_modem_count[id] > 0);
+		not_once += (g_out_modem_count[id] != 1);
+	}
+
+	printf("  virtual time %lu s (drained in %lu s)\n", (unsigned long)(SYSTICK_getMs() / 1000),
+			(unsigned long)(drain_ms / 1000));
+	printf("  engine: %u OK, %u errors, %u timeouts (%u late results discarded), %u URCs, latency avg %lu ms max %u ms\n",
+			engine.completed, engine.failed, engine.timeouts, engine.late_results, engine.urcs,
+			(unsigned long)((commands > 0) ? engine.total_latency_ms / commands : 0), engine.max_latency_ms);
+	printf("  modem: %lu commands, %lu errors, %lu drops and %lu late responses injected, %lu unknown, SIM use max %u/%u\n",
+			(unsigned long)modem.commands, (unsigned long)modem.errors, (unsigned long)modem.dropped, (unsigned long)modem.late,
+			(unsigned long)modem.unknown, modem.sim_used_max, SIM900_SIM_SLOTS);
+	printf("  outgoing: %u posted, %lu sent, %lu failed (%lu of them reached the network), %lu sent more than once"
+			" (%lu acknowledgements dropped), post to SENT max %lu ms, %lu passes with the outbox full\n", g_out_count,
+			sent, failed, failed_delivered, resent, (unsigned long)modem.sms_unacknowledged,
+			(unsigned long)g_out_max_latency_ms, (unsigned long)g_outbox_full_passes);
+	printf("  incoming: %u arrived, %u decoded, %lu listings, arrival to decode avg %lu ms max %lu ms\n",
+			g_in_count, g_in_count - (unsigned)lost, (unsigned long)g_inbox_listings,
+			(unsigned long)((g_in_count > lost) ? g_in_total_latency_ms / (g_in_count - lost) : 0),
+			(unsigned long)g_in_max_latency_ms);
+	printf("  USART: %u bytes lost to a full receive ring, transmit queue high water %u/%u\n",
+			USART_getRxOverflowCount(), USART_getTxHighWaterMark(), USART_TX_BUFFER_MASK);
+
+	fail("incoming SMS lost", lost);
+	fail("incoming SMS decoded twice", duplicated);
+	fail("outbox entries that never ended", stuck);
+	fail("SENT without reaching the modem", sent_lost);
+	fail("modem model errors", modem.unknown);
+	fail("SMS sent again without a dropped acknowledgement",
+			(resent > modem.sms_unacknowledged) ? resent - modem.sms_unacknowledged : 0);
+	fail("SMS lost in the network, the profile offers more than the inbox takes", modem.sms_lost);
+	if(g_lossless){
+		fail("SMS not sent exactly once by a lossless modem", not_once);
+		fail("SMS failed on a lossless modem", failed);
+		fail("commands failed on a lossless modem", engine.failed);
+		if(profile->modem.late_pct == 0){
+			fail("commands timed out on a modem that is never late", engine.timeouts);
+		}
+	}
+}
+
+static void runProfile(const PROFILE_ConfigType * profile){
+	uint32 next_send_ms, next_receive_ms, drain_start_ms;
+	boolean post_waiting = FALSE;
+	uint8 slot;
+
+	g_random = profile->modem.seed * 7919;
+	g_lossless = (profile->modem.error_pct == 0) && (profile->modem.drop_pct == 0);
+	for(slot = 0; slot < GSM_OUTBOX_SIZE; slot++){
+		g_slot_id[slot] = NO_ID;
+	}
+	SYSTICK_init();
+	SIM900_init(&profile->modem);
+	USART_init(NULL_PTR);
+	GSM_setUrcHandler(GSM_URC_CMTI, newMsgNotification);
+	if(!modemInit()){
+		fail("modem initialization", 1);
+		return;
+	}
+	GSM_resetStats();
+
+	next_send_ms = SYSTICK_getMs() + randomBelow(2 * profile->send_period_ms);
+	next_receive_ms = SYSTICK_getMs() + randomBelow(2 * profile->receive_period_ms);
+	while(SYSTICK_getMs() < TRAFFIC_MS){
+		GSM_task();
+		GSM_outboxTask();
+		inboxTask();
+		outboxPoll();
+		if(!post_waiting && ((sint32)(SYSTICK_getMs() - next_send_ms) >= 0) && (g_out_count < MAX_MESSAGES)){
+			sprintf(g_out_text[g_out_count], "out %u", g_out_count);
+			g_out_contact[g_out_count] = randomBelow(CONTACTS);
+			post_waiting = TRUE;
+			next_send_ms += randomBelow(2 * profile->send_period_ms);
+		}
+		if(post_waiting && outboxPost()){
+			post_waiting = FALSE;
+		}
+		if(((sint32)(SYSTICK_getMs() - next_receive_ms) >= 0) && (g_in_count < profile->receive_limit)){
+			incomingSms();
+			next_receive_ms += randomBelow(2 * profile->receive_period_ms);
+		}
+		inboxDecode();
+		HOST_advanceMs(1 + (randomBelow(100) < profile->stall_pct ? randomBelow(profile->stall_max_ms + 1) : 0));
+	}
+
+	drain_start_ms = SYSTICK_getMs();
+	while((post_waiting || !drained()) && (SYSTICK_elapsedMs(drain_start_ms) < DRAIN_MAX_MS)){
+		GSM_task();
+		GSM_outboxTask();
+		inboxTask();
+		outboxPoll();
+		if(post_waiting && outboxPost()){
+			post_waiting = FALSE;
+		}
+		inboxDecode();
+		HOST_advanceMs(1);
+	}
+	report(profile, SYSTICK_elapsedMs(drain_start_ms));
+	fail("traffic left after the drain period", !drained() || post_waiting);
+}
+
+int main(void){
+	unsigned profile, failed = 0;
+	int status;
+	pid_t pid;
+
+	for(profile = 0; profile < sizeof(g_profiles) / sizeof(g_profiles[0]); profile++){
+		const PROFILE_ConfigType * config = &g_profiles[profile];
+
+		if((getenv("PROFILE") != NULL_PTR) && (atoi(getenv("PROFILE")) != (int)profile)){
+			continue; /*PROFILE=<index> runs a single profile*/
+		}
+		printf("%s: latency %u+-%u ms, SMS %u+-%u ms, %u %% errors, %u %% drops, %u %% late by %u ms, stalls up to"
+				" %u ms in %u %% of the passes, SMS out every %u ms, %u in every %u ms\n", config->name,
+				config->modem.latency_ms, config->modem.jitter_ms, config->modem.sms_latency_ms,
+				config->modem.sms_jitter_ms, config->modem.error_pct, config->modem.drop_pct, config->modem.late_pct,
+				config->modem.late_ms, config->stall_max_ms, config->stall_pct,
+				config->send_period_ms, config->receive_limit, config->receive_period_ms);
+		fflush(stdout);
+		pid = fork();
+		if(pid == 0){
+			runProfile(config);
+			fflush(stdout);
+			_exit(g_failures > 0);
+		}
+		waitpid(pid, &status, 0);
+		failed += !WIFEXITED(status) || (WEXITSTATUS(status) != 0);
+	}
+	printf("%s\n", (failed == 0) ? "PASS" : "FAIL");
+	return (failed == 0) ? 0 : 1;
+}
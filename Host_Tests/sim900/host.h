@@ -0,0 +1,23 @@
+/*
+ * host.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Host side of the MCAL modules the GSM driver runs on: a virtual millisecond clock
+ *  (host_systick.c) and the USART wired to the SIM900 model (host_usart.c). The line moves one
+ *  byte each way per millisecond, close to the 9600 baud of the modem (1.04 ms per byte).
+ */
+
+#ifndef HOST_H_
+#define HOST_H_
+
+#include "std_types.h"
+
+/*advance the clock, moving the line and running the modem every millisecond*/
+void HOST_advanceMs(uint32 ms);
+
+/*one byte time of the line: the next queued byte to the modem, the next modem byte to the ring*/
+void HOST_usartTick(void);
+
+#endif /* HOST_H_ */
@@ -0,0 +1,42 @@
+/*
+ * host_systick.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  MCAL/Timer/systick.h on the host: the time only moves with HOST_advanceMs().
+ */
+
+#include "systick.h"
+#include "sim900.h"
+#include "host.h"
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static uint32 g_ms = 0;
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void SYSTICK_init(void){
+	g_ms = 0;
+}
+
+uint32 SYSTICK_getMs(void){
+	return g_ms;
+}
+
+uint32 SYSTICK_elapsedMs(uint32 a_startMs){
+	return g_ms - a_startMs;
+}
+
+void HOST_advanceMs(uint32 ms){
+	while(ms--){
+		g_ms++;
+		SIM900_task(g_ms);
+		HOST_usartTick();
+	}
+}
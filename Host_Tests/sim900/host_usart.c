@@ -0,0 +1,219 @@
+/*
+ * host_usart.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  MCAL/USART/usart.h on the host, wired to the SIM900 model. The receive ring and the
+ *  transmit queue are those of usart.c (same sizes, same overflow and line accounting), the
+ *  two ISRs are HOST_usartTick(). A call that waits on the target (USART_sendByte() with the
+ *  queue full, USART_flush()) advances the virtual clock instead.
+ */
+
+#include "usart.h"
+#include "sim900.h"
+#include "host.h"
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static void (*g_USART_Call_Back_Ptr)(void) = NULL_PTR;
+static void (*g_USART_Rx_Handler_Ptr)(uint8 data) = NULL_PTR;
+
+static uint8 g_rx_buffer[USART_RX_BUFFER_SIZE];
+static uint8 g_rx_head = 0;
+static uint8 g_rx_tail = 0;
+static uint8 g_rx_lines_in = 0;
+static uint8 g_rx_lines_out = 0;
+static uint16 g_rx_overflow_count = 0;
+
+static uint8 g_tx_buffer[USART_TX_BUFFER_SIZE];
+static uint8 g_tx_head = 0;
+static uint8 g_tx_tail = 0;
+static uint8 g_tx_high_water_mark = 0;
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+/*USART_UDRE_vect and USART_RXC_vect*/
+void HOST_usartTick(void){
+	uint8 next_head;
+	uint8 data;
+
+	if(g_tx_head != g_tx_tail){
+		SIM900_receiveByte(g_tx_buffer[g_tx_tail]);
+		g_tx_tail = (g_tx_tail + 1) & USART_TX_BUFFER_MASK;
+	}
+
+	if(!SIM900_transmitByte(&data)){
+		return;
+	}
+	if(g_USART_Rx_Handler_Ptr != NULL_PTR){
+		(*g_USART_Rx_Handler_Ptr)(data);
+		return;
+	}
+	next_head = (g_rx_head + 1) & USART_RX_BUFFER_MASK;
+	if(next_head == g_rx_tail){
+		g_rx_overflow_count++;
+	}
+	else{
+		g_rx_buffer[g_rx_head] = data;
+		g_rx_head = next_head;
+		if(data == USART_LINE_TERMINATOR){
+			g_rx_lines_in++;
+		}
+	}
+	if(g_USART_Call_Back_Ptr != NULL_PTR){
+		(*g_USART_Call_Back_Ptr)();
+	}
+}
+
+void USART_init(const USART_ConfigType * const a_usartConfig){
+	(void)a_usartConfig;
+	g_rx_head = g_rx_tail = 0;
+	g_rx_lines_in = g_rx_lines_out = 0;
+	g_tx_head = g_tx_tail = 0;
+}
+
+void USART_sendByte(uint8 a_data){
+	while(!USART_queueByte(a_data)){
+		HOST_advanceMs(1);
+	}
+}
+
+uint8 USART_receiveByte(void){
+	uint8 data;
+
+	while(USART_rxCount() == 0){
+		HOST_advanceMs(1);
+	}
+	data = USART_rxPeek(0);
+	USART_rxDrop(1);
+	return data;
+}
+
+void USART_sendString(const uint8 * a_txStrPtr){
+	while(*a_txStrPtr != '\0'){
+		USART_sendByte(*a_txStrPtr++);
+	}
+}
+
+boolean USART_queueByte(uint8 a_data){
+	uint8 next_head = (g_tx_head + 1) & USART_TX_BUFFER_MASK;
+	uint8 count;
+
+	if(next_head == g_tx_tail){
+		return FALSE;
+	}
+	g_tx_buffer[g_tx_head] = a_data;
+	g_tx_head = next_head;
+	count = (next_head - g_tx_tail) & USART_TX_BUFFER_MASK;
+	if(count > g_tx_high_water_mark){
+		g_tx_high_water_mark = count;
+	}
+	return TRUE;
+}
+
+uint8 USART_queueString(const uint8 * a_txStrPtr){
+	uint8 i = 0;
+
+	while((a_txStrPtr[i] != '\0') && USART_queueByte(a_txStrPtr[i])){
+		i++;
+	}
+	return i;
+}
+
+uint8 USART_txFree(void){
+	return (USART_TX_BUFFER_MASK - ((g_tx_head - g_tx_tail) & USART_TX_BUFFER_MASK));
+}
+
+void USART_flush(void){
+	while(g_tx_head != g_tx_tail){
+		HOST_advanceMs(1);
+	}
+}
+
+uint8 USART_getTxHighWaterMark(void){
+	return g_tx_high_water_mark;
+}
+
+void USART_receiveString(uint8 * const a_rxStrPtr){
+	uint8 i = 0;
+
+	do{
+		a_rxStrPtr[i] = USART_receiveByte();
+	}
+	while(a_rxStrPtr[i++] != USART_TERMINATOR_CHARACTER);
+	a_rxStrPtr[i - 1] = '\0';
+}
+
+void USART_setCallBackFunction(void (*Fun_Ptr)(void)){
+	g_USART_Call_Back_Ptr = Fun_Ptr;
+}
+
+void USART_setRxHandler(void (*a_handlerPtr)(uint8 data)){
+	g_USART_Rx_Handler_Ptr = a_handlerPtr;
+}
+
+uint8 USART_rxCount(void){
+	return (g_rx_head - g_rx_tail) & USART_RX_BUFFER_MASK;
+}
+
+uint8 USART_rxPeek(uint8 a_offset){
+	return g_rx_buffer[(g_rx_tail + a_offset) & USART_RX_BUFFER_MASK];
+}
+
+void USART_rxDrop(uint8 a_count){
+	uint8 tail = g_rx_tail;
+	uint8 available = USART_rxCount();
+
+	if(a_count > available){
+		a_count = available;
+	}
+	while(a_count--){
+		if(g_rx_buffer[tail] == USART_LINE_TERMINATOR){
+			g_rx_lines_out++;
+		}
+		tail = (tail + 1) & USART_RX_BUFFER_MASK;
+	}
+	g_rx_tail = tail;
+}
+
+uint8 USART_rxLinesPending(void){
+	return (uint8)(g_rx_lines_in - g_rx_lines_out);
+}
+
+uint8 USART_rxLineLength(void){
+	uint8 i;
+	uint8 available;
+
+	if(USART_rxLinesPending() == 0){
+		return 0;
+	}
+	available = USART_rxCount();
+	for(i = 0; i < available; i++){
+		if(USART_rxPeek(i) == USART_LINE_TERMINATOR){
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+void USART_rxConsumeLine(void){
+	USART_rxDrop(USART_rxLineLength());
+}
+
+void USART_rxFlush(void){
+	g_rx_tail = g_rx_head;
+	g_rx_lines_out = g_rx_lines_in;
+}
+
+uint16 USART_getRxOverflowCount(void){
+	return g_rx_overflow_count;
+}
+
+uint16 USART_getRxOverrunCount(void){
+	return 0; /*the host ISR is never late*/
+}
@@ -0,0 +1,760 @@
+/*
+ * sim900.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  The modem only answers: commands end with '\r' ('\n' is ignored), responses are queued as
+ *  whole chunks ("\r\n<line>\r\n" ...) released at their due time, never before the response
+ *  to an earlier command (the module answers one command at a time), and a released chunk is
+ *  handed out one byte per call of SIM900_transmitByte(). A URC is a chunk of its own, so it
+ *  lands between the lines of other responses but never inside one, as on the module.
+ *  The sockets are polled every millisecond: a listener that closed the GPRS socket gives
+ *  CLOSED, the answer to a POST gives +HTTPACTION.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "sim900.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define SIM900_LINE_LENGTH			128
+#define SIM900_OUTPUT_SIZE			8192
+#define SIM900_PENDING_SIZE			64
+#define SIM900_NETWORK_SIZE			256		/*incoming SMS waiting for a free SIM slot (network store)*/
+#define SIM900_CTRL_Z				0x1A
+#define SIM900_ESC					0x1B
+#define SIM900_TIMESTAMP			"\"26/10/18,10:00:00+08\""
+#define SIM900_IP_ADDRESS			"10.64.12.7"	/*answered to AT+CIFSR*/
+#define SIM900_HTTP_REPLY_SIZE		256
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef struct{
+	boolean used;
+	boolean read;
+	char sender[SIM900_NUMBER_LENGTH];
+	char text[SIM900_TEXT_LENGTH];
+}SIM900_Slot;
+
+typedef struct{
+	uint32 due_ms;
+	uint32 sequence;			/*release order among equal due times*/
+	boolean urc;				/*held while the modem takes SMS text, as on the module*/
+	char * text;				/*NULL_PTR: free entry*/
+}SIM900_Pending;
+
+typedef enum{
+	SIM900_COMMAND, SIM900_SMS_TEXT, SIM900_DATA
+}SIM900_InputState;
+
+/*AT+CIPSTATUS states of the bring-up, the socket can be opened in SIM900_IP_STATUS*/
+typedef enum{
+	SIM900_IP_INITIAL, SIM900_IP_START, SIM900_IP_GPRSACT, SIM900_IP_STATUS
+}SIM900_IpState;
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static SIM900_ConfigType g_config;
+static SIM900_Stats g_stats;
+static uint32 g_random;
+static uint32 g_now_ms;
+static uint32 g_sequence;
+static uint32 g_last_due_ms;		/*of the last response, the next one is not released before it*/
+
+static boolean g_echo;
+static SIM900_InputState g_input_state;
+static char g_line[SIM900_LINE_LENGTH];
+static uint8 g_line_length;
+static char g_sms_number[SIM900_NUMBER_LENGTH];
+static char g_sms_text[SIM900_TEXT_LENGTH * 4];
+static uint16 g_sms_length;
+
+static uint8 g_data[SIM900_DATA_SIZE];		/*AT+CIPSEND / AT+HTTPDATA input*/
+static uint16 g_data_length;
+static uint16 g_data_expected;
+static boolean g_data_http;
+
+static SIM900_IpState g_ip_state;
+static int g_socket = -1;
+
+static boolean g_bearer_open;					/*AT+SAPBR=1,1*/
+static boolean g_http_session;					/*AT+HTTPINIT*/
+static char g_http_url[SIM900_LINE_LENGTH];
+static char g_http_content[SIM900_LINE_LENGTH];
+static uint8 g_http_body[SIM900_DATA_SIZE];
+static uint16 g_http_body_length;
+static int g_http_socket = -1;					/*POST waiting for the answer of the listener*/
+static char g_http_reply[SIM900_HTTP_REPLY_SIZE];
+static uint16 g_http_reply_length;
+
+static SIM900_Slot g_sim[SIM900_SIM_SLOTS];
+static SIM900_Slot g_network[SIM900_NETWORK_SIZE];
+static uint16 g_network_head;
+static uint16 g_network_count;
+
+static SIM900_Pending g_pending[SIM900_PENDING_SIZE];
+static uint8 g_output[SIM900_OUTPUT_SIZE];
+static uint32 g_output_head;
+static uint32 g_output_tail;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint32 SIM900_random(uint32 range);
+static boolean SIM900_roll(uint8 percent);
+static uint32 SIM900_delay(uint16 base_ms, uint16 jitter_ms);
+static void SIM900_output(const char * text);
+static void SIM900_schedule(uint32 delay_ms, boolean urc, const char * text);
+static void SIM900_command(void);
+static void SIM900_submitSms(void);
+static void SIM900_list(const char * stat, char * response, uint32 size);
+static void SIM900_store(void);
+static uint8 SIM900_parseIndex(const char * text);
+static void SIM900_startData(uint16 length, boolean http);
+static void SIM900_dataReceived(void);
+static int SIM900_open(const char * host, unsigned port);
+static void SIM900_closeSocket(void);
+static const char * SIM900_connect(const char * address);
+static boolean SIM900_httpPara(const char * text);
+static const char * SIM900_httpPost(void);
+static void SIM900_pollSockets(void);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void SIM900_init(const SIM900_ConfigType * a_configPtr){
+	uint8 i;
+
+	g_config = *a_configPtr;
+	g_random = (g_config.seed != 0) ? g_config.seed : 1;
+	memset(&g_stats, 0, sizeof(g_stats));
+	g_now_ms = 0;
+	g_sequence = 0;
+	g_last_due_ms = 0;
+	g_echo = TRUE; /*power on default, the driver sends ATE0*/
+	g_input_state = SIM900_COMMAND;
+	g_line_length = 0;
+	memset(g_sim, 0, sizeof(g_sim));
+	g_network_head = 0;
+	g_network_count = 0;
+	for(i = 0; i < SIM900_PENDING_SIZE; i++){
+		free(g_pending[i].text);
+		g_pending[i].text = NULL_PTR;
+	}
+	g_output_head = 0;
+	g_output_tail = 0;
+	SIM900_closeSocket();
+	g_ip_state = SIM900_IP_INITIAL;
+	g_bearer_open = FALSE;
+	g_http_session = FALSE;
+	if(g_http_socket >= 0){
+		close(g_http_socket);
+		g_http_socket = -1;
+	}
+}
+
+void SIM900_task(uint32 now_ms){
+	uint8 i, next;
+
+	g_now_ms = now_ms;
+	SIM900_store();
+	SIM900_pollSockets();
+	do{
+		next = SIM900_PENDING_SIZE;
+		for(i = 0; i < SIM900_PENDING_SIZE; i++){
+			if((g_pending[i].text != NULL_PTR) && ((sint32)(g_now_ms - g_pending[i].due_ms) >= 0) &&
+					!(g_pending[i].urc && (g_input_state != SIM900_COMMAND)) &&
+					((next == SIM900_PENDING_SIZE) || ((sint32)(g_pending[i].due_ms - g_pending[next].due_ms) < 0) ||
+					((g_pending[i].due_ms == g_pending[next].due_ms) && (g_pending[i].sequence < g_pending[next].sequence)))){
+				next = i;
+			}
+		}
+		if(next < SIM900_PENDING_SIZE){
+			SIM900_output(g_pending[next].text);
+			free(g_pending[next].text);
+			g_pending[next].text = NULL_PTR;
+		}
+	}while(next < SIM900_PENDING_SIZE);
+}
+
+void SIM900_receiveByte(uint8 data){
+	if(g_echo){
+		g_output[g_output_head++ % SIM900_OUTPUT_SIZE] = data;
+	}
+	if(g_input_state == SIM900_DATA){
+		g_data[g_data_length++] = data;
+		if(g_data_length == g_data_expected){
+			g_input_state = SIM900_COMMAND;
+			SIM900_dataReceived();
+		}
+		return;
+	}
+	if(g_input_state == SIM900_SMS_TEXT){
+		if(data == SIM900_CTRL_Z){
+			g_input_state = SIM900_COMMAND;
+			SIM900_submitSms();
+		}
+		else if(data == SIM900_ESC){
+			g_input_state = SIM900_COMMAND;
+			SIM900_schedule(SIM900_delay(g_config.latency_ms, g_config.jitter_ms), FALSE, "\r\nOK\r\n");
+		}
+		else if(g_sms_length < sizeof(g_sms_text) - 1){
+			g_sms_text[g_sms_length++] = (char)data;
+		}
+		return;
+	}
+	if(data == '\r'){
+		g_line[g_line_length] = '\0';
+		if(g_line_length > 0){
+			SIM900_command();
+		}
+		g_line_length = 0;
+	}
+	else if((data != '\n') && (data != SIM900_ESC) && (g_line_length < SIM900_LINE_LENGTH - 1)){
+		g_line[g_line_length++] = (char)data;
+	}
+}
+
+boolean SIM900_transmitByte(uint8 * data){
+	if(g_output_tail == g_output_head){
+		return FALSE;
+	}
+	*data = g_output[g_output_tail++ % SIM900_OUTPUT_SIZE];
+	return TRUE;
+}
+
+void SIM900_deliverSms(const char * sender, const char * text){
+	SIM900_Slot * sms;
+
+	if(g_network_count == SIM900_NETWORK_SIZE){
+		g_stats.sms_lost++;
+		return;
+	}
+	sms = &g_network[(g_network_head + g_network_count) % SIM900_NETWORK_SIZE];
+	snprintf(sms->sender, sizeof(sms->sender), "%s", sender);
+	snprintf(sms->text, sizeof(sms->text), "%s", text);
+	g_network_count++;
+	SIM900_store();
+}
+
+uint8 SIM900_simUsed(void){
+	uint8 i, used = 0;
+
+	for(i = 0; i < SIM900_SIM_SLOTS; i++){
+		used += g_sim[i].used;
+	}
+	return used;
+}
+
+void SIM900_getStats(SIM900_Stats * stats){
+	*stats = g_stats;
+}
+
+/*xorshift32, uniform in [0, range)*/
+static uint32 SIM900_random(uint32 range){
+	g_random ^= g_random << 13;
+	g_random ^= g_random >> 17;
+	g_random ^= g_random << 5;
+	return (range == 0) ? 0 : (g_random % range);
+}
+
+static boolean SIM900_roll(uint8 percent){
+	return SIM900_random(100) < percent;
+}
+
+static uint32 SIM900_delay(uint16 base_ms, uint16 jitter_ms){
+	sint32 delay_ms = (sint32)base_ms - jitter_ms + (sint32)SIM900_random(2 * (uint32)jitter_ms + 1);
+
+	return (delay_ms < 1) ? 1 : (uint32)delay_ms;
+}
+
+static void SIM900_output(const char * text){
+	while(*text != '\0'){
+		if(g_output_head - g_output_tail == SIM900_OUTPUT_SIZE){
+			printf("sim900: output buffer full\n");
+			return;
+		}
+		g_output[g_output_head++ % SIM900_OUTPUT_SIZE] = (uint8)*text++;
+	}
+}
+
+static void SIM900_schedule(uint32 delay_ms, boolean urc, const char * text){
+	uint8 i;
+
+	for(i = 0; i < SIM900_PENDING_SIZE; i++){
+		if(g_pending[i].text == NULL_PTR){
+			g_pending[i].due_ms = g_now_ms + delay_ms;
+			if(!urc){
+				if((sint32)(g_pending[i].due_ms - g_last_due_ms) < 0){
+					g_pending[i].due_ms = g_last_due_ms;
+				}
+				g_last_due_ms = g_pending[i].due_ms;
+			}
+			g_pending[i].sequence = g_sequence++;
+			g_pending[i].urc = urc;
+			g_pending[i].text = strdup(text);
+			return;
+		}
+	}
+	printf("sim900: too many pending responses\n");
+}
+
+/*
+ * Description :
+ * Complete command line in g_line. An injected error replaces the response and nothing is
+ * carried out; a dropped response is carried out and answered with its data lines only.
+ */
+static void SIM900_command(void){
+	static char response[SIM900_SIM_SLOTS * (SIM900_NUMBER_LENGTH + SIM900_TEXT_LENGTH + 64) + 16];
+	uint32 delay_ms = SIM900_delay(g_config.latency_ms, g_config.jitter_ms);
+	const char * result = "\r\nOK\r\n";
+	const char * urc = NULL_PTR;			/*network event that follows the result*/
+	boolean drop;
+	uint8 index, used;
+	int length;
+	char * end;
+
+	g_stats.commands++;
+	if(strncmp(g_line, "AT+CMGS=\"", 9) == 0){
+		/*the result comes after the text, the error and drop rolls are made then*/
+		end = strchr(&g_line[9], '"');
+		snprintf(g_sms_number, sizeof(g_sms_number), "%.*s", (int)((end != NULL_PTR) ? end - &g_line[9] : 0), &g_line[9]);
+		g_sms_length = 0;
+		g_input_state = SIM900_SMS_TEXT;
+		SIM900_schedule(delay_ms, FALSE, "\r\n> ");
+		return;
+	}
+	if((strncmp(g_line, "AT+CIPSEND=", 11) == 0) || (strncmp(g_line, "AT+HTTPDATA=", 12) == 0)){
+		/*the data follows the prompt, the result comes after it*/
+		length = atoi(&g_line[(g_line[3] == 'C') ? 11 : 12]);
+		if((length <= 0) || (length > SIM900_DATA_SIZE) || ((g_line[3] == 'C') ? (g_socket < 0) : !g_http_session)){
+			SIM900_schedule(delay_ms, FALSE, "\r\nERROR\r\n");
+			return;
+		}
+		SIM900_startData((uint16)length, g_line[3] == 'H');
+		SIM900_schedule(delay_ms, FALSE, (g_line[3] == 'C') ? "\r\n> " : "\r\nDOWNLOAD\r\n");
+		return;
+	}
+	if(SIM900_roll(g_config.error_pct)){
+		g_stats.errors++;
+		SIM900_schedule(delay_ms, FALSE, "\r\nERROR\r\n");
+		return;
+	}
+	drop = SIM900_roll(g_config.drop_pct);
+	if((g_config.late_pct > 0) && SIM900_roll(g_config.late_pct)){
+		g_stats.late++;
+		delay_ms += g_config.late_ms;
+	}
+	response[0] = '\0';
+
+	if((strcmp(g_line, "AT") == 0) || (strcmp(g_line, "AT+CMGF=1") == 0)){
+	}
+	else if(strcmp(g_line, "ATI") == 0){
+		strcpy(response, "\r\nSIM900 R11.0\r\n");
+	}
+	else if(strcmp(g_line, "ATE0") == 0){
+		g_echo = FALSE;
+	}
+	else if(strcmp(g_line, "ATE1") == 0){
+		g_echo = TRUE;
+	}
+	else if(strncmp(g_line, "AT+CMGL=\"", 9) == 0){
+		end = strchr(&g_line[9], '"');
+		if(end != NULL_PTR){
+			*end = '\0';
+		}
+		SIM900_list(&g_line[9], response, sizeof(response));
+	}
+	else if(strncmp(g_line, "AT+CMGR=", 8) == 0){
+		index = SIM900_parseIndex(&g_line[8]);
+		if(index > 0){
+			snprintf(response, sizeof(response), "\r\n+CMGR: \"%s\",\"%s\",\"\"," SIM900_TIMESTAMP "\r\n%s\r\n",
+					g_sim[index - 1].read ? "REC READ" : "REC UNREAD", g_sim[index - 1].sender, g_sim[index - 1].text);
+			g_sim[index - 1].read = TRUE;
+		}
+	}
+	else if(strncmp(g_line, "AT+CMGD=", 8) == 0){
+		index = SIM900_parseIndex(&g_line[8]);
+		if(index > 0){
+			g_sim[index - 1].used = FALSE; /*an empty index is answered OK as well*/
+		}
+	}
+	else if((strcmp(g_line, "AT+CMGDA=\"DEL READ\"") == 0) || (strcmp(g_line, "AT+CMGDA=\"DEL ALL\"") == 0)){
+		for(index = 0; index < SIM900_SIM_SLOTS; index++){
+			if(g_sim[index].read || (g_line[14] == 'A')){
+				g_sim[index].used = FALSE;
+			}
+		}
+	}
+	else if(strcmp(g_line, "AT+CPMS?") == 0){
+		used = SIM900_simUsed();
+		snprintf(response, sizeof(response), "\r\n+CPMS: \"SM\",%u,%u,\"SM\",%u,%u,\"SM\",%u,%u\r\n",
+				used, SIM900_SIM_SLOTS, used, SIM900_SIM_SLOTS, used, SIM900_SIM_SLOTS);
+	}
+	else if(strcmp(g_line, "AT+CIPSHUT") == 0){
+		SIM900_closeSocket();
+		g_ip_state = SIM900_IP_INITIAL;
+		result = "\r\nSHUT OK\r\n";
+	}
+	else if(strncmp(g_line, "AT+CSTT=\"", 9) == 0){
+		if(g_ip_state != SIM900_IP_INITIAL){
+			result = "\r\nERROR\r\n";
+		}
+		else{
+			g_ip_state = SIM900_IP_START;
+		}
+	}
+	else if(strcmp(g_line, "AT+CIICR") == 0){
+		if(g_ip_state != SIM900_IP_START){
+			result = "\r\nERROR\r\n";
+		}
+		else{
+			g_ip_state = SIM900_IP_GPRSACT;
+			delay_ms += SIM900_delay(g_config.net_latency_ms, g_config.net_jitter_ms);
+		}
+	}
+	else if(strcmp(g_line, "AT+CIFSR") == 0){
+		if(g_ip_state < SIM900_IP_GPRSACT){
+			result = "\r\nERROR\r\n";
+		}
+		else{
+			g_ip_state = SIM900_IP_STATUS;
+			result = "\r\n" SIM900_IP_ADDRESS "\r\n"; /*the address is the whole response*/
+		}
+	}
+	else if(strncmp(g_line, "AT+CIPSTART=\"TCP\",\"", 19) == 0){
+		if(g_ip_state != SIM900_IP_STATUS){
+			result = "\r\nERROR\r\n";
+		}
+		else{
+			urc = (g_socket >= 0) ? "\r\nALREADY CONNECT\r\n" : SIM900_connect(&g_line[19]);
+		}
+	}
+	else if(strncmp(g_line, "AT+SAPBR=3,1,\"", 14) == 0){
+		/*CONTYPE and APN, taken as they are*/
+	}
+	else if((strcmp(g_line, "AT+SAPBR=1,1") == 0) || (strcmp(g_line, "AT+SAPBR=0,1") == 0)){
+		if(g_bearer_open == (g_line[9] == '1')){
+			result = "\r\nERROR\r\n"; /*already open / not open*/
+		}
+		else{
+			g_bearer_open = (g_line[9] == '1');
+			delay_ms += g_bearer_open ? SIM900_delay(g_config.net_latency_ms, g_config.net_jitter_ms) : 0;
+		}
+	}
+	else if((strcmp(g_line, "AT+HTTPINIT") == 0) || (strcmp(g_line, "AT+HTTPTERM") == 0)){
+		if(g_http_session == (g_line[7] == 'I')){
+			result = "\r\nERROR\r\n";
+		}
+		else{
+			g_http_session = (g_line[7] == 'I');
+			g_http_url[0] = '\0';
+			g_http_content[0] = '\0';
+			g_http_body_length = 0;
+		}
+	}
+	else if(strncmp(g_line, "AT+HTTPPARA=\"", 13) == 0){
+		if(!g_http_session || !SIM900_httpPara(&g_line[13])){
+			result = "\r\nERROR\r\n";
+		}
+	}
+	else if(strcmp(g_line, "AT+HTTPACTION=1") == 0){
+		if(!g_http_session || (g_http_url[0] == '\0') || (g_http_socket >= 0)){
+			result = "\r\nERROR\r\n";
+		}
+		else{
+			urc = SIM900_httpPost();
+		}
+	}
+	else{
+		g_stats.unknown++;
+		SIM900_schedule(delay_ms, FALSE, "\r\nERROR\r\n");
+		return;
+	}
+
+	if(drop){
+		g_stats.dropped++;
+	}
+	else{
+		strcat(response, result);
+	}
+	if(response[0] != '\0'){
+		SIM900_schedule(delay_ms, FALSE, response);
+	}
+	if(urc != NULL_PTR){
+		/*after the result, the network takes its own time*/
+		SIM900_schedule((((sint32)(g_last_due_ms - g_now_ms) > 0) ? g_last_due_ms - g_now_ms : 0) +
+				SIM900_delay(g_config.net_latency_ms, g_config.net_jitter_ms), TRUE, urc);
+	}
+}
+
+/*Ctrl+Z after the AT+CMGS text: submitted to the network after the SMS latency*/
+static void SIM900_submitSms(void){
+	char response[32];
+	uint32 delay_ms = SIM900_delay(g_config.sms_latency_ms, g_config.sms_jitter_ms);
+
+	if(SIM900_roll(g_config.error_pct)){
+		g_stats.errors++;
+		SIM900_schedule(delay_ms, FALSE, "\r\n+CMS ERROR: 500\r\n");
+		return;
+	}
+	g_sms_text[g_sms_length] = '\0';
+	g_stats.sms_sent++;
+	if(g_config.on_sms_sent != NULL_PTR){
+		g_config.on_sms_sent(g_sms_number, g_sms_text);
+	}
+	if(SIM900_roll(g_config.drop_pct)){
+		g_stats.dropped++; /*sent, the acknowledgement is lost*/
+		g_stats.sms_unacknowledged++;
+		return;
+	}
+	snprintf(response, sizeof(response), "\r\n+CMGS: %lu\r\n\r\nOK\r\n", (unsigned long)(g_stats.sms_sent % 256));
+	SIM900_schedule(delay_ms, FALSE, response);
+}
+
+/*AT+CMGL: every listed unread message becomes read*/
+static void SIM900_list(const char * stat, char * response, uint32 size){
+	uint32 length = 0;
+	uint8 i;
+
+	for(i = 0; i < SIM900_SIM_SLOTS; i++){
+		if(!g_sim[i].used || ((strcmp(stat, "ALL") != 0) &&
+				((strcmp(stat, "REC READ") == 0) != g_sim[i].read))){
+			continue;
+		}
+		length += snprintf(&response[length], size - length, "\r\n+CMGL: %u,\"%s\",\"%s\",\"\"," SIM900_TIMESTAMP "\r\n%s",
+				i + 1, g_sim[i].read ? "REC READ" : "REC UNREAD", g_sim[i].sender, g_sim[i].text);
+		g_sim[i].read = TRUE;
+	}
+	if(length > 0){
+		snprintf(&response[length], size - length, "\r\n");
+	}
+}
+
+/*move the incoming SMS into free SIM slots, each announced with +CMTI*/
+static void SIM900_store(void){
+	char urc[32];
+	uint8 i, used;
+
+	while(g_network_count > 0){
+		for(i = 0; (i < SIM900_SIM_SLOTS) && g_sim[i].used; i++){
+		}
+		if(i == SIM900_SIM_SLOTS){
+			return;
+		}
+		g_sim[i] = g_network[g_network_head];
+		g_sim[i].used = TRUE;
+		g_sim[i].read = FALSE;
+		g_network_head = (g_network_head + 1) % SIM900_NETWORK_SIZE;
+		g_network_count--;
+		g_stats.sms_received++;
+		used = SIM900_simUsed();
+		if(used > g_stats.sim_used_max){
+			g_stats.sim_used_max = used;
+		}
+		snprintf(urc, sizeof(urc), "\r\n+CMTI: \"SM\",%u\r\n", i + 1);
+		SIM900_schedule(0, TRUE, urc);
+	}
+}
+
+/*1-based SIM index of a used slot, 0 if not*/
+static uint8 SIM900_parseIndex(const char * text){
+	int index = atoi(text);
+
+	return ((index >= 1) && (index <= SIM900_SIM_SLOTS) && g_sim[index - 1].used) ? (uint8)index : 0;
+}
+
+static void SIM900_startData(uint16 length, boolean http){
+	g_data_length = 0;
+	g_data_expected = length;
+	g_data_http = http;
+	g_input_state = SIM900_DATA;
+}
+
+/*
+ * Description :
+ * The whole AT+CIPSEND / AT+HTTPDATA data arrived. The socket data goes out at once and is
+ * acknowledged with SEND OK once the network took it, the HTTP body is kept for the POST.
+ */
+static void SIM900_dataReceived(void){
+	uint32 delay_ms = SIM900_delay(g_config.latency_ms, g_config.jitter_ms);
+	boolean drop;
+
+	if(SIM900_roll(g_config.error_pct)){
+		g_stats.errors++;
+		SIM900_schedule(delay_ms, FALSE, g_data_http ? "\r\nERROR\r\n" : "\r\nSEND FAIL\r\n");
+		return;
+	}
+	drop = SIM900_roll(g_config.drop_pct);
+	if(g_data_http){
+		memcpy(g_http_body, g_data, g_data_length);
+		g_http_body_length = g_data_length;
+	}
+	else{
+		if((g_socket < 0) || (send(g_socket, g_data, g_data_length, MSG_NOSIGNAL) != (ssize_t)g_data_length)){
+			SIM900_schedule(delay_ms, FALSE, "\r\nSEND FAIL\r\n");
+			return;
+		}
+		g_stats.tcp_bytes += g_data_length;
+		delay_ms += SIM900_delay(g_config.net_latency_ms, g_config.net_jitter_ms);
+	}
+	if(drop){
+		g_stats.dropped++; /*carried out, the result is lost*/
+		return;
+	}
+	SIM900_schedule(delay_ms, FALSE, g_data_http ? "\r\nOK\r\n" : "\r\nSEND OK\r\n");
+}
+
+/*blocking connect, the listener is local: -1 if it refused*/
+static int SIM900_open(const char * host, unsigned port){
+	struct sockaddr_in address;
+	int fd;
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons((uint16)port);
+	if(inet_pton(AF_INET, host, &address.sin_addr) != 1){
+		return -1;
+	}
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if((fd >= 0) && (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)){
+		close(fd);
+		fd = -1;
+	}
+	return fd;
+}
+
+static void SIM900_closeSocket(void){
+	if(g_socket >= 0){
+		close(g_socket);
+		g_socket = -1;
+	}
+}
+
+/*AT+CIPSTART: "TCP","<host>","<port>" after the first quote of <host>*/
+static const char * SIM900_connect(const char * address){
+	char host[SIM900_LINE_LENGTH];
+	unsigned port;
+
+	if(sscanf(address, "%127[^\"]\",\"%u\"", host, &port) != 2){
+		return "\r\nCONNECT FAIL\r\n";
+	}
+	g_socket = SIM900_open(host, port);
+	if(g_socket < 0){
+		return "\r\nCONNECT FAIL\r\n";
+	}
+	g_stats.tcp_connects++;
+	return "\r\nCONNECT OK\r\n";
+}
+
+/*AT+HTTPPARA: <name>",<value> after the first quote of <name>, the value may be quoted*/
+static boolean SIM900_httpPara(const char * text){
+	char name[16];
+	char value[SIM900_LINE_LENGTH];
+
+	if(sscanf(text, "%15[^\"]\",%127[^\n]", name, value) != 2){
+		return FALSE;
+	}
+	if((value[0] == '"') && (strlen(value) >= 2) && (value[strlen(value) - 1] == '"')){
+		memmove(value, &value[1], strlen(value) - 2);
+		value[strlen(value) - 2] = '\0';
+	}
+	if(strcmp(name, "CID") == 0){
+		return (strcmp(value, "1") == 0);
+	}
+	if(strcmp(name, "URL") == 0){
+		strcpy(g_http_url, value);
+		return TRUE;
+	}
+	if(strcmp(name, "CONTENT") == 0){
+		strcpy(g_http_content, value);
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * Description :
+ * AT+HTTPACTION=1: the body goes to the URL as an HTTP/1.0 POST, with a Content-Type header
+ * only if AT+HTTPPARA="CONTENT" set one. +HTTPACTION comes once the listener answered and
+ * closed (SIM900_pollSockets()), or now with 601 if the bearer or the listener is not there.
+ */
+static const char * SIM900_httpPost(void){
+	char host[SIM900_LINE_LENGTH];
+	char path[SIM900_LINE_LENGTH] = "/";
+	char header[3 * SIM900_LINE_LENGTH];
+	unsigned port = 80;
+	int length;
+
+	if(!g_bearer_open || (sscanf(g_http_url, "http://%127[^:/]:%u%127s", host, &port, path) < 1)){
+		return "\r\n+HTTPACTION: 1,601,0\r\n";
+	}
+	g_http_socket = SIM900_open(host, port);
+	if(g_http_socket < 0){
+		return "\r\n+HTTPACTION: 1,601,0\r\n";
+	}
+	length = snprintf(header, sizeof(header), "POST %s HTTP/1.0\r\nHost: %s\r\n%s%s%sContent-Length: %u\r\n\r\n",
+			path, host, (g_http_content[0] != '\0') ? "Content-Type: " : "", g_http_content,
+			(g_http_content[0] != '\0') ? "\r\n" : "", g_http_body_length);
+	send(g_http_socket, header, length, MSG_NOSIGNAL);
+	send(g_http_socket, g_http_body, g_http_body_length, MSG_NOSIGNAL);
+	g_http_reply_length = 0;
+	g_stats.http_posts++;
+	return NULL_PTR;
+}
+
+/*a closed GPRS socket gives CLOSED, the end of the HTTP answer gives +HTTPACTION*/
+static void SIM900_pollSockets(void){
+	char buffer[64];
+	char urc[48];
+	ssize_t length;
+	unsigned status;
+	char * body;
+
+	if(g_socket >= 0){
+		length = recv(g_socket, buffer, sizeof(buffer), MSG_DONTWAIT); /*data from the listener is not used*/
+		if((length == 0) || ((length < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK))){
+			SIM900_closeSocket();
+			g_stats.tcp_closed++;
+			SIM900_schedule(0, TRUE, "\r\nCLOSED\r\n");
+		}
+	}
+	if(g_http_socket < 0){
+		return;
+	}
+	length = recv(g_http_socket, &g_http_reply[g_http_reply_length], sizeof(g_http_reply) - 1 - g_http_reply_length,
+			MSG_DONTWAIT);
+	if(length > 0){
+		g_http_reply_length += length;
+		return;
+	}
+	if((length < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))){
+		return;
+	}
+	close(g_http_socket);
+	g_http_socket = -1;
+	g_http_reply[g_http_reply_length] = '\0';
+	body = strstr(g_http_reply, "\r\n\r\n");
+	if(sscanf(g_http_reply, "HTTP/1.%*u %u", &status) != 1){
+		status = 601;
+	}
+	snprintf(urc, sizeof(urc), "\r\n+HTTPACTION: 1,%u,%u\r\n", status,
+			(body != NULL_PTR) ? (unsigned)(g_http_reply_length - (body + 4 - g_http_reply)) : 0);
+	SIM900_schedule(SIM900_delay(g_config.net_latency_ms, g_config.net_jitter_ms), TRUE, urc);
+}
@@ -0,0 +1,103 @@
+/*
+ * sim900.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Scripted SIM900A for the host tests, the modem side of the host USART (host_usart.c).
+ *  It answers the AT commands the GSM driver sends (ATE0, ATI, AT+CMGF, AT+CMGS, AT+CMGL,
+ *  AT+CMGD, AT+CMGDA, AT+CPMS?) in order, after a latency with uniform jitter, stores
+ *  incoming SMS in a SIM of SIM900_SIM_SLOTS and announces them with +CMTI, which may land in
+ *  the middle of another command. It can fail commands (+CMS ERROR / ERROR), drop responses
+ *  (the command is carried out, nothing comes back) and answer late, after the driver gave
+ *  up, all from a seeded generator so a run is reproducible.
+ *  The GPRS commands (AT+CIPSHUT, AT+CSTT, AT+CIICR, AT+CIFSR, AT+CIPSTART, AT+CIPSEND) and
+ *  the HTTP ones (AT+SAPBR, AT+HTTPINIT, AT+HTTPPARA, AT+HTTPDATA, AT+HTTPACTION, AT+HTTPTERM)
+ *  are carried out on real TCP sockets of the host, so a listener on 127.0.0.1 receives what
+ *  the driver sends: the socket data as it is, the HTTP body as an HTTP/1.0 POST with the
+ *  URL and content type of AT+HTTPPARA. A socket the listener closes is announced with CLOSED.
+ */
+
+#ifndef SIM900_H_
+#define SIM900_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define SIM900_SIM_SLOTS			30
+#define SIM900_NUMBER_LENGTH		16
+#define SIM900_TEXT_LENGTH			64
+#define SIM900_DATA_SIZE			256		/*longest AT+CIPSEND / AT+HTTPDATA*/
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+/*
+ * latency:		command to first response byte, ms (uniform within +- jitter).
+ * sms_latency:	end of the AT+CMGS text to +CMGS (network submission).
+ * error_pct:	commands answered with an error.
+ * drop_pct:	commands carried out without any response.
+ * late_pct:	commands answered late_ms later than the latency (not AT+CMGS).
+ * on_sms_sent:	every message the modem submitted to the network, retries included.
+ * net_latency:	network side of the data commands: CONNECT OK, SEND OK, +HTTPACTION.
+ */
+typedef struct{
+	uint16 latency_ms;
+	uint16 jitter_ms;
+	uint16 sms_latency_ms;
+	uint16 sms_jitter_ms;
+	uint8 error_pct;
+	uint8 drop_pct;
+	uint8 late_pct;
+	uint16 late_ms;
+	uint32 seed;
+	void (*on_sms_sent)(const char * number, const char * text);
+	uint16 net_latency_ms;
+	uint16 net_jitter_ms;
+}SIM900_ConfigType;
+
+typedef struct{
+	uint32 commands;
+	uint32 errors;				/*answered with an error on purpose*/
+	uint32 dropped;				/*responses withheld on purpose*/
+	uint32 late;				/*responses delayed by late_ms on purpose*/
+	uint32 unknown;				/*commands the model does not know*/
+	uint32 sms_sent;
+	uint32 sms_unacknowledged;	/*sent with the +CMGS response dropped, the driver sends them again*/
+	uint32 sms_received;		/*stored in the SIM*/
+	uint32 sms_lost;			/*arrived with the network store full, the offered load is too high*/
+	uint8 sim_used_max;
+	uint32 tcp_connects;		/*AT+CIPSTART that opened a socket*/
+	uint32 tcp_closed;			/*sockets closed by the listener, announced with CLOSED*/
+	uint32 tcp_bytes;			/*written to the socket*/
+	uint32 http_posts;			/*requests written to the listener*/
+}SIM900_Stats;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+void SIM900_init(const SIM900_ConfigType * a_configPtr);
+
+/*one millisecond of modem time, releases the responses that are due*/
+void SIM900_task(uint32 now_ms);
+
+/*byte from the MCU (host USART transmit side)*/
+void SIM900_receiveByte(uint8 data);
+
+/*next byte for the MCU, FALSE if there is none (host USART receive side)*/
+boolean SIM900_transmitByte(uint8 * data);
+
+/*an SMS reaches the modem, it is stored and announced once a SIM slot is free*/
+void SIM900_deliverSms(const char * sender, const char * text);
+
+/*messages in the SIM, read or not*/
+uint8 SIM900_simUsed(void);
+
+void SIM900_getStats(SIM900_Stats * stats);
+
+#endif /* SIM900_H_ */
@@ -0,0 +1,14 @@
+/*
+ * interrupt.h
+ *
+ *  Host build (Host_Tests): the interrupt sources are called directly by the host modules.
+ */
+
+#ifndef HOST_INTERRUPT_H_
+#define HOST_INTERRUPT_H_
+
+#define sei()
+#define cli()
+#define ISR(vector)				void vector(void)
+
+#endif /* HOST_INTERRUPT_H_ */
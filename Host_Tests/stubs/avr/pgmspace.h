@@ -0,0 +1,43 @@
+/*
+ * pgmspace.h
+ *
+ *  Host build (Host_Tests): flash tables and strings are ordinary constants.
+ */
+
+#ifndef HOST_PGMSPACE_H_
+#define HOST_PGMSPACE_H_
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P					const char *
+#define PSTR(s)					(s)
+#define pgm_read_byte(a)		(*(const uint8_t *)(a))
+#define pgm_read_word(a)		(*(const uint16_t *)(a))
+#define pgm_read_dword(a)		(*(const uint32_t *)(a))
+#define pgm_read_ptr(a)			(*(void * const *)(a))
+#define memcpy_P				memcpy
+#define strcpy_P				strcpy
+#define strlen_P				strlen
+#define strncmp_P				strncmp
+#define strcat_P				strcat
+#define sprintf_P				sprintf
+#define snprintf_P				snprintf
+#define vsnprintf_P				HOST_vsnprintf_P
+
+/*%S is a string in the flash for avr-libc, an ordinary string (%s) here*/
+static inline int HOST_vsnprintf_P(char * s, size_t n, const char * format, va_list arguments){
+	char host_format[256];
+	size_t i;
+
+	for(i = 0; (format[i] != '\0') && (i < sizeof(host_format) - 1); i++){
+		host_format[i] = ((format[i] == 'S') && (i > 0) && (format[i - 1] == '%')) ? 's' : format[i];
+	}
+	host_format[i] = '\0';
+	return vsnprintf(s, n, host_format, arguments);
+}
+
+#endif /* HOST_PGMSPACE_H_ */
@@ -0,0 +1,13 @@
+/*
+ * delay.h
+ *
+ *  Host build (Host_Tests): busy waits are not timed, the host modules use the virtual clock.
+ */
+
+#ifndef HOST_DELAY_H_
+#define HOST_DELAY_H_
+
+#define _delay_ms(ms)			((void)(ms))
+#define _delay_us(us)			((void)(us))
+
+#endif /* HOST_DELAY_H_ */
@@ -0,0 +1,400 @@
+/*
+ * aiding.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Times are kept as GPS seconds (since 6 January 1980, no leap seconds) so that the saved
+ *  fix, the modem clock and the health block age compare with one subtraction. UTC dates are
+ *  converted for 2000-2099 only, the years the receiver and the modem report.
+ *  The receiver sends its UTC time every UBX_TIME_RATE fixes, the date of a fix is only taken
+ *  as the current time when it changed since the previous fix.
+ */
+
+#include "aiding.h"
+#include "../Utils/geo.h"
+#include "../HAL/SIM900A_GSM/gsm.h"
+#include "../HAL/UART_Arbiter/uart_arbiter.h"
+#include "../MCAL/Internal_EEPROM/Internal_EEPROM.h"
+#include "../MCAL/Timer/systick.h"
+#include <util/crc16.h>
+#include <string.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define AIDING_GPS_DAYS_TO_2000		7300UL		/*6 January 1980 to 1 January 2000*/
+#define AIDING_SECONDS_PER_DAY		86400UL
+#define AIDING_SECONDS_PER_WEEK		604800UL
+#define AIDING_FIX_SIZE				(sizeof(AIDING_FixRecord) + 1)
+#define AIDING_HEALTH_SIZE			(GPS_HEALTH_SIZE + 4 + 1)
+#define AIDING_HEALTH_FLAGS			68			/*AID-HUI flags: health, UTC and Klobuchar parameters valid*/
+#define AIDING_HEALTH_COMPLETE		0x07
+
+#if AIDING_HEALTH_SIZE > EEPROMINTENAL_STAGE_SIZE
+#error "the health record does not fit in the EEPROM staging buffer"
+#endif
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef struct{
+	sint32 latitude;
+	sint32 longitude;
+	sint32 altitude;
+	uint32 gps_seconds;
+}AIDING_FixRecord;
+
+typedef enum{
+	AIDING_CLOCK_OFF, AIDING_CLOCK_IDLE, AIDING_CLOCK_QUERY, AIDING_CLOCK_SEND, AIDING_CLOCK_DONE
+}AIDING_ClockState;
+
+typedef enum{
+	AIDING_HEALTH_IDLE, AIDING_HEALTH_REQUEST, AIDING_HEALTH_WAIT, AIDING_HEALTH_DONE
+}AIDING_HealthState;
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static AIDING_FixRecord g_saved;
+static boolean g_saved_valid = FALSE;
+static uint32 g_saved_ms;						/*SYSTICK time of the last save*/
+static boolean g_saved_once = FALSE;			/*saved since boot*/
+static uint32 g_health_seconds = 0;				/*GPS time of the saved health block, 0 if none*/
+static uint8 g_sent = 0;
+
+/*current time: GPS seconds at g_time_ms*/
+static uint32 g_time_seconds;
+static uint32 g_time_ms;
+static boolean g_time_known = FALSE;
+static uint8 g_fix_second = 0xFF;				/*UTC second of the previous fix*/
+static boolean g_modem_clock_set = FALSE;
+
+static AIDING_ClockState g_clock_state = AIDING_CLOCK_OFF;
+static uint8 g_clock_attempts = 0;
+static uint32 g_clock_ms;						/*SYSTICK time of the clock reading or of the last attempt*/
+static uint32 g_clock_seconds;
+
+static AIDING_HealthState g_health_state = AIDING_HEALTH_IDLE;
+static uint32 g_health_ms;						/*first fix, then the last request*/
+static boolean g_fix_taken = FALSE;
+
+/*EEPROM staging buffer claimed while the health block polled from the receiver is received in it*/
+static uint8 * g_health_block = NULL_PTR;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint8 AIDING_crc(const uint8 * data, uint8 length);
+static boolean AIDING_read(uint16 address, uint8 * data, uint8 length);
+static void AIDING_stage(uint8 * data, uint16 address, uint8 length);
+static uint32 AIDING_gpsSeconds(uint8 year, uint8 month, uint8 day, uint8 hour, uint8 minute, uint8 second);
+static uint32 AIDING_now(void);
+static void AIDING_takeTime(const GPS_Fix * fix);
+static void AIDING_saveFix(const LOCATION_Entry * location);
+static void AIDING_checkHealth(void);
+static void AIDING_clockRead(GSM_CmdStatus status);
+static void AIDING_sendTime(void);
+static void AIDING_healthTask(void);
+static void AIDING_releaseHealth(void);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void AIDING_init(void){
+	uint8 * data = EEPROMINTENAL_claim(); /*nothing is written yet at boot*/
+
+	g_saved_valid = AIDING_read(AIDING_FIX_ADDR, data, AIDING_FIX_SIZE);
+	if(g_saved_valid){
+		memcpy(&g_saved, data, sizeof(AIDING_FixRecord));
+	}
+	EEPROMINTENAL_release();
+}
+
+void AIDING_sendInitial(void){
+	GPS_Aiding aiding = {0};
+	uint8 * data;
+
+	if(g_saved_valid){
+		aiding.latitude = g_saved.latitude;
+		aiding.longitude = g_saved.longitude;
+		aiding.altitude = g_saved.altitude;
+		aiding.position_acc_cm = AIDING_POSITION_ACC_CM;
+		GPS_sendAiding(&aiding);
+		g_sent |= AIDING_SENT_POSITION;
+		g_clock_state = AIDING_CLOCK_IDLE; /*the modem is asked for the time once it is up*/
+	}
+	data = EEPROMINTENAL_claim();
+	if(data == NULL_PTR){
+		return;
+	}
+	if(AIDING_read(AIDING_HEALTH_ADDR, data, AIDING_HEALTH_SIZE)){
+		memcpy(&g_health_seconds, &data[GPS_HEALTH_SIZE], 4);
+		GPS_sendHealth(data);
+		g_sent |= AIDING_SENT_HEALTH;
+	}
+	EEPROMINTENAL_release();
+}
+
+void AIDING_update(const LOCATION_Entry * location){
+	if(!g_fix_taken){
+		g_fix_taken = TRUE;
+		g_health_ms = location->timestamp_ms;
+	}
+	AIDING_takeTime(&location->fix);
+	if(g_time_known && !g_modem_clock_set){
+		GSM_Clock clock = {location->fix.year, location->fix.month, location->fix.day,
+				location->fix.hour, location->fix.minute, location->fix.second, 0};
+		g_modem_clock_set = GSM_setClock(&clock, NULL_PTR);
+	}
+	AIDING_saveFix(location);
+	AIDING_checkHealth();
+}
+
+void AIDING_task(void){
+	switch(g_clock_state){
+	case AIDING_CLOCK_IDLE:
+		if(g_fix_taken || (g_clock_attempts == AIDING_CLOCK_ATTEMPTS)){
+			g_clock_state = AIDING_CLOCK_DONE;
+		}
+		else if(((g_clock_attempts == 0) || (SYSTICK_elapsedMs(g_clock_ms) >= AIDING_CLOCK_RETRY_MS)) &&
+				GSM_queryClock(AIDING_clockRead)){
+			g_clock_attempts++;
+			g_clock_state = AIDING_CLOCK_QUERY;
+		}
+		break;
+	case AIDING_CLOCK_SEND:
+		if(g_fix_taken){
+			ARBITER_release(ARBITER_GPS);
+			g_clock_state = AIDING_CLOCK_DONE;
+		}
+		else if(ARBITER_isGranted(ARBITER_GPS)){
+			AIDING_sendTime();
+			ARBITER_release(ARBITER_GPS); /*the frame is sent before the relay moves*/
+			g_clock_state = AIDING_CLOCK_DONE;
+		}
+		break;
+	default:
+		break;
+	}
+	AIDING_healthTask();
+}
+
+uint8 AIDING_getSent(void){
+	return g_sent;
+}
+
+boolean AIDING_getTime(uint32 * gps_seconds){
+	if(g_time_known){
+		*gps_seconds = AIDING_now();
+	}
+	return g_time_known;
+}
+
+static uint8 AIDING_crc(const uint8 * data, uint8 length){
+	uint8 crc = 0;
+	uint8 i;
+
+	for(i = 0; i < length; i++){
+		crc = _crc_ibutton_update(crc, data[i]);
+	}
+	return crc;
+}
+
+static boolean AIDING_read(uint16 address, uint8 * data, uint8 length){
+	uint8 i;
+
+	for(i = 0; i < length; i++){
+		data[i] = EEPROMINTENAL_readByte(address + i);
+	}
+	return data[length - 1] == AIDING_crc(data, length - 1);
+}
+
+/*write the first length - 1 bytes of the claimed staging buffer followed by their CRC*/
+static void AIDING_stage(uint8 * data, uint16 address, uint8 length){
+	data[length - 1] = AIDING_crc(data, length - 1);
+	EEPROMINTENAL_commit(address, length);
+}
+
+/*UTC date and time (years since 2000) to GPS seconds*/
+static uint32 AIDING_gpsSeconds(uint8 year, uint8 month, uint8 day, uint8 hour, uint8 minute, uint8 second){
+	static const uint16 days_before_month[12] PROGMEM = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+	uint16 days = (uint16)year * 365 + (year + 3) / 4 + pgm_read_word(&days_before_month[month - 1]) + day - 1;
+
+	if(((year % 4) == 0) && (month > 2)){
+		days++;
+	}
+	return (AIDING_GPS_DAYS_TO_2000 + days) * AIDING_SECONDS_PER_DAY + hour * 3600UL + minute * 60U + second
+			+ AIDING_LEAP_SECONDS;
+}
+
+static uint32 AIDING_now(void){
+	return g_time_seconds + SYSTICK_elapsedMs(g_time_ms) / 1000;
+}
+
+static void AIDING_takeTime(const GPS_Fix * fix){
+	boolean fresh = (fix->second != g_fix_second) && (g_fix_second != 0xFF);
+
+	g_fix_second = fix->second;
+	if(!fresh || (fix->year == 0) || (fix->month == 0) || (fix->month > 12)){
+		return;
+	}
+	g_time_seconds = AIDING_gpsSeconds(fix->year, fix->month, fix->day, fix->hour, fix->minute, fix->second);
+	g_time_ms = SYSTICK_getMs();
+	g_time_known = TRUE;
+}
+
+/*on a stop or every AIDING_SAVE_PERIOD_MS, once AIDING_SAVE_DISTANCE_M away from the saved fix*/
+static void AIDING_saveFix(const LOCATION_Entry * location){
+	const GPS_Fix * fix = &location->fix;
+	uint32 since_save_ms = SYSTICK_elapsedMs(g_saved_ms);
+	GEO_Point saved_position;
+	GEO_Point position;
+	AIDING_FixRecord record;
+	uint8 * data;
+
+	if(EEPROMINTENAL_isWriting() || (g_health_block != NULL_PTR)){
+		return;
+	}
+	if(g_saved_once && (since_save_ms < AIDING_SAVE_MIN_GAP_MS)){
+		return;
+	}
+	position.latitude = fix->latitude;
+	position.longitude = fix->longitude;
+	if(g_saved_valid){
+		saved_position.latitude = g_saved.latitude;
+		saved_position.longitude = g_saved.longitude;
+		if(GEO_equirectDistance(&saved_position, &position) < AIDING_SAVE_DISTANCE_M * 100UL){
+			return;
+		}
+		if((fix->speed >= AIDING_STOP_SPEED_CMS) && g_saved_once && (since_save_ms < AIDING_SAVE_PERIOD_MS)){
+			return;
+		}
+	}
+	record.latitude = fix->latitude;
+	record.longitude = fix->longitude;
+	record.altitude = fix->altitude;
+	record.gps_seconds = g_time_known ? AIDING_now() : 0;
+	data = EEPROMINTENAL_claim();
+	if(data == NULL_PTR){
+		return; /*saved on a following fix*/
+	}
+	g_saved = record;
+	g_saved_valid = TRUE;
+	g_saved_ms = SYSTICK_getMs();
+	g_saved_once = TRUE;
+	memcpy(data, &record, sizeof(AIDING_FixRecord));
+	AIDING_stage(data, AIDING_FIX_ADDR, AIDING_FIX_SIZE);
+}
+
+/*poll the health block once it had time to be decoded, if the saved one is missing or old*/
+static void AIDING_checkHealth(void){
+	if((g_health_state != AIDING_HEALTH_IDLE) || !g_time_known || EEPROMINTENAL_isWriting()){
+		return;
+	}
+	if((g_health_seconds != 0) && ((AIDING_now() - g_health_seconds) < AIDING_HEALTH_MAX_AGE_S)){
+		g_health_state = AIDING_HEALTH_DONE;
+		return;
+	}
+	if(SYSTICK_elapsedMs(g_health_ms) >= AIDING_HEALTH_DELAY_MS){
+		ARBITER_request(ARBITER_GPS);
+		g_health_state = AIDING_HEALTH_REQUEST;
+	}
+}
+
+/*AT+CCLK? completion: the modem time is used if it is not older than the saved fix*/
+static void AIDING_clockRead(GSM_CmdStatus status){
+	GSM_Clock clock;
+
+	g_clock_ms = SYSTICK_getMs();
+	if((status != GSM_CMD_OK) || !GSM_getClock(&clock)){
+		g_clock_state = AIDING_CLOCK_IDLE;
+		return;
+	}
+	g_clock_seconds = AIDING_gpsSeconds(clock.year, clock.month, clock.day, clock.hour, clock.minute,
+			clock.second) - (sint32)clock.zone * 900;
+	if((clock.year < AIDING_MIN_CLOCK_YEAR) || (g_clock_seconds < g_saved.gps_seconds)){
+		g_clock_state = AIDING_CLOCK_DONE;
+		return;
+	}
+	ARBITER_request(ARBITER_GPS);
+	g_clock_state = AIDING_CLOCK_SEND;
+}
+
+static void AIDING_sendTime(void){
+	GPS_Aiding aiding;
+	uint32 elapsed_ms = SYSTICK_elapsedMs(g_clock_ms);
+	uint32 seconds = g_clock_seconds + elapsed_ms / 1000;
+
+	aiding.latitude = g_saved.latitude;
+	aiding.longitude = g_saved.longitude;
+	aiding.altitude = g_saved.altitude;
+	aiding.position_acc_cm = AIDING_POSITION_ACC_CM;
+	aiding.week = (uint16)(seconds / AIDING_SECONDS_PER_WEEK);
+	aiding.time_of_week_ms = (seconds % AIDING_SECONDS_PER_WEEK) * 1000 + elapsed_ms % 1000;
+	aiding.time_acc_ms = AIDING_TIME_ACC_MS;
+	aiding.time_valid = TRUE;
+	GPS_sendAiding(&aiding);
+	g_sent |= AIDING_SENT_TIME;
+}
+
+/*
+ * the polled block is received in the EEPROM staging buffer, claimed for the request, and
+ * written from there if it is complete
+ */
+static void AIDING_healthTask(void){
+	uint32 now;
+
+	switch(g_health_state){
+	case AIDING_HEALTH_REQUEST:
+		if(ARBITER_isGranted(ARBITER_GPS)){
+			g_health_block = EEPROMINTENAL_claim();
+			if(g_health_block == NULL_PTR){
+				g_health_state = AIDING_HEALTH_IDLE; /*another record is written, requested again on a fix*/
+			}
+			else if(GPS_requestHealth(g_health_block)){
+				g_health_state = AIDING_HEALTH_WAIT;
+			}
+			else{
+				AIDING_releaseHealth();
+				g_health_state = AIDING_HEALTH_DONE;
+			}
+			g_health_ms = SYSTICK_getMs();
+			ARBITER_release(ARBITER_GPS);
+		}
+		break;
+	case AIDING_HEALTH_WAIT:
+		if(GPS_healthReceived()){
+			g_health_state = AIDING_HEALTH_IDLE; /*incomplete, polled again after AIDING_HEALTH_DELAY_MS*/
+			if((g_health_block[AIDING_HEALTH_FLAGS] & AIDING_HEALTH_COMPLETE) == AIDING_HEALTH_COMPLETE){
+				now = AIDING_now();
+				memcpy(&g_health_block[GPS_HEALTH_SIZE], &now, 4);
+				AIDING_stage(g_health_block, AIDING_HEALTH_ADDR, AIDING_HEALTH_SIZE);
+				g_health_block = NULL_PTR;
+				g_health_seconds = now;
+				g_health_state = AIDING_HEALTH_DONE;
+			}
+			else{
+				AIDING_releaseHealth();
+			}
+		}
+		else if(SYSTICK_elapsedMs(g_health_ms) >= AIDING_HEALTH_REPLY_MS){
+			GPS_requestHealth(NULL_PTR);
+			AIDING_releaseHealth();
+			g_health_state = AIDING_HEALTH_IDLE;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void AIDING_releaseHealth(void){
+	g_health_block = NULL_PTR;
+	EEPROMINTENAL_release();
+}
@@ -0,0 +1,86 @@
+/*
+ * aiding.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  GPS start-up aiding: the receiver has no backup supply, so every power cycle is a cold
+ *  start unless it is told where and when it is. The last good fix and the receiver health,
+ *  UTC and ionosphere block are kept in the internal EEPROM and sent back at boot:
+ *    1. AIDING_sendInitial(), in the GPS slice of the boot configuration: AID-INI with the
+ *       saved position (AIDING_POSITION_ACC_CM) and AID-HUI with the saved block.
+ *    2. AIDING_task(), once the modem is up and while there is still no fix: the modem clock
+ *       (AT+CCLK?) is read, converted to GPS time and sent with the position in a second
+ *       AID-INI, if it is not older than the saved fix (a modem that lost its RTC restarts
+ *       in the past).
+ *    3. AIDING_update(), on every fix: the modem clock is set from the GPS time once per boot,
+ *       the fix is saved when the vehicle stops (or every AIDING_SAVE_PERIOD_MS on the move)
+ *       AIDING_SAVE_DISTANCE_M away from the saved one, the health block is polled and saved
+ *       once it is complete and the saved one is older than AIDING_HEALTH_MAX_AGE_S.
+ *  EEPROM writes go through the shared staging buffer of the EEPROM driver, written one
+ *  byte per EEPROMINTENAL_task() call, the CRC last.
+ *
+ *  Record layout:
+ *    AIDING_FIX_ADDR     latitude s32, longitude s32, altitude s32 (cm), GPS time u32
+ *                        (seconds since 6 January 1980, 0 unknown), CRC-8
+ *    AIDING_HEALTH_ADDR  AID-HUI payload (GPS_HEALTH_SIZE bytes), GPS time u32, CRC-8
+ */
+
+#ifndef APP_AIDING_H_
+#define APP_AIDING_H_
+
+#include "location.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * EEPROM map: 0x000-0x009 settings, 0x00A-0x099 contact book, 0x09A-0x18F geofences,
+ * 0x190-0x1ED GPS aiding, 0x1EE-0x1F6 CO calibration, 0x1F7-0x1FF free, 0x200- journal.
+ */
+#define AIDING_FIX_ADDR				0x0190
+#define AIDING_HEALTH_ADDR			0x01A1
+
+#define AIDING_POSITION_ACC_CM		1000000UL	/*10 km, the vehicle may have been moved while off*/
+#define AIDING_TIME_ACC_MS			10000UL		/*modem RTC: one second steps and its drift since set*/
+#define AIDING_LEAP_SECONDS			18			/*GPS - UTC since 1 January 2017*/
+#define AIDING_UNIX_OFFSET_S		315964800UL	/*6 January 1980 in Unix time*/
+#define AIDING_SAVE_DISTANCE_M		500
+#define AIDING_SAVE_PERIOD_MS		600000UL	/*while moving*/
+#define AIDING_SAVE_MIN_GAP_MS		60000UL		/*stop and go traffic*/
+#define AIDING_STOP_SPEED_CMS		100
+#define AIDING_HEALTH_MAX_AGE_S		259200UL	/*3 days*/
+#define AIDING_HEALTH_DELAY_MS		900000UL	/*the navigation message repeats the UTC and ionosphere page every 12.5 min*/
+#define AIDING_HEALTH_REPLY_MS		3000
+#define AIDING_CLOCK_RETRY_MS		2000
+#define AIDING_CLOCK_ATTEMPTS		3
+#define AIDING_MIN_CLOCK_YEAR		26			/*RTC reset values are earlier*/
+
+/*aiding sent since boot, AIDING_getSent()*/
+#define AIDING_SENT_POSITION		0x01
+#define AIDING_SENT_TIME			0x02
+#define AIDING_SENT_HEALTH			0x04
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*Read the saved fix (blocking EEPROM reads, call once at boot)*/
+void AIDING_init(void);
+
+/*Queue the saved position and health frames. The USART must be routed to the GPS.*/
+void AIDING_sendInitial(void);
+
+/*Check a new fix (save, clock and health), call once per fix*/
+void AIDING_update(const LOCATION_Entry * location);
+
+/*Time aiding from the modem clock, GPS slices and EEPROM writes. Call from the main loop.*/
+void AIDING_task(void);
+
+uint8 AIDING_getSent(void);
+
+/*current GPS time (seconds since 6 January 1980) once a fix gave it, FALSE before*/
+boolean AIDING_getTime(uint32 * gps_seconds);
+
+#endif /* APP_AIDING_H_ */
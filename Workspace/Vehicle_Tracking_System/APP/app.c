@@ -7,23 +7,65 @@
 
 #include "app.h"
 
+#if (NUM_BOOK_START_ADDR + NUM_BOOK_MAX_CONTACTS * NUM_BOOK_ENTRY_SIZE) > GEOFENCE_START_ADDR
+#error "The contact book overlaps the geofences in the EEPROM"
+#endif
+
 /*******************************************************************************
  *                     	   	  Global Variables                                 *
  *******************************************************************************/
 
-char g_msg_buff [MSG_BUFFER_SIZE];        
-char g_contact_number [DIAL_NO_LENGTH];
 char g_confirmation_code [CONFIRM_CODE_LENGTH];
-boolean g_info_received_flag = FALSE;
-volatile char g_buff_index = 0;
 
 /*from EEPROM*/
 uint8 g_code_config_flag;
 uint8 g_no_of_contacts;
 
-uint8 g_timer1_tick = 0;
+/*
+ * Batch inbox: one AT+CMGL listing fills the queue, processed slots are then cleared with
+ * a single AT+CMGDA="DEL READ" (or one AT+CMGD per taken message if the queue overflowed)
+ */
+APP_InboxEntry g_inbox_queue [INBOX_QUEUE_SIZE];
+uint8 g_inbox_head = 0;
+uint8 g_inbox_count = 0;
+boolean g_inbox_decoding = FALSE;         /*the oldest entry is being decoded in place*/
+uint8 g_inbox_taken [INBOX_QUEUE_SIZE];   /*SIM indexes of the messages taken by the current listing*/
+uint8 g_inbox_taken_count = 0;
+uint8 g_inbox_delete_count = 0;           /*taken messages still to be deleted one by one*/
+boolean g_inbox_deleting = FALSE;         /*AT+CMGD of one of them in flight*/
+boolean g_inbox_delete_read = FALSE;      /*AT+CMGDA timed out, sent again*/
+boolean g_inbox_scan_request = TRUE;      /*the SIM may have filled up while the tracker was off*/
+boolean g_inbox_scanning = FALSE;
+boolean g_inbox_check_storage = FALSE;
+boolean g_inbox_retry_wait = FALSE;
+uint32 g_inbox_retry_ms = 0;
 
-float32 g_Ro;
+/*
+ * Outgoing text, one buffer for every message composed here (location and status replies,
+ * CO alerts, zone and driving event texts). The outbox does not copy it, so a new text is
+ * only composed once no recipient still uses the previous one (APP_messageTake()).
+ */
+char g_message [TRANS_MSG_MAX_LENGTH];
+boolean g_message_location = FALSE;     /*g_message holds a location reply, shared by the next requesters*/
+APP_FanOut g_fanout = {g_message, 0, GSM_PRIORITY_ROUTINE};
+
+uint16 g_co_ppm = 0;            /*last CO reading*/
+uint16 g_co_displayed_ppm = 0;  /*reading on the LCD*/
+uint32 g_co_displayed_ms = 0;
+boolean g_lcd_redraw = TRUE;    /*the CO screen was replaced (boot, received message)*/
+APP_COState g_co_state = APP_CO_CLEAR;
+uint32 g_co_state_ms = 0;       /*time the fire alarm was raised*/
+boolean g_fire_alert_due = FALSE;       /*confirmed, waiting for the alert buffer*/
+boolean g_exposure_alert_due = FALSE;
+boolean g_exposure_reported = FALSE;    /*the exposure alarm was texted since it was raised*/
+boolean g_buzz_command = FALSE;
+uint32 g_buzz_ms = 0;           /*time of the "BUZ" command*/
+boolean g_ignition_on = FALSE;
+uint32 g_telemetry_ms = 0;      /*time of the last telemetry record*/
+uint32 g_track_fix_ms = 0;      /*time of the last fix given to the track simplification*/
+uint32 g_position_fix_ms = 0;   /*time of the last fix checked for geofences and events*/
+uint32 g_first_fix_ms = 0;      /*time the MCU saw the first fix*/
+boolean g_ttff_reported = FALSE;
 
 
 /*******************************************************************************
@@ -32,68 +74,77 @@ float32 g_Ro;
 
 static void APP_readConfirmCode(const char * conf_code);
 static void APP_storeConfirmCode(const char * conf_code);
-static void APP_sendCoordinates(char * number, char * special_message);
-static void APP_switchUARTAccess(APP_UART_Access access_granted);
+static void APP_sendLocation(char * number);
+static boolean APP_messageTake(GSM_OutboxPriority priority);
+static void APP_fanOutStart(APP_FanOut * fanout);
+static void APP_fanOutTask(APP_FanOut * fanout);
+static boolean APP_fanOutBusy(const APP_FanOut * fanout);
+static void APP_formatLocation(char * text, const LOCATION_Entry * location);
 static void APP_storeNewEntry(char * number);
 static boolean APP_codeCheck(char * code);
 static boolean APP_findNumber(char * number);
-static void APP_getContactNumber(uint8 contact_id);
+static void APP_getContactNumber(uint8 contact_id, char * number);
 static boolean APP_isSUbStr(const char *str, const char *sub) ;
 static void APP_strCat(char * result, const char * str1, const char * str2);
 static boolean APP_strCmp(char * str1, char * str2);
-static void APP_flushBuffer();
+static void APP_reportTtff(const LOCATION_Entry * location);
+static void APP_trackFix(const LOCATION_Entry * location);
+static void APP_reportNoFix(const LOCATION_Entry * location);
+static uint32 APP_timestamp(uint32 event_ms, uint8 * flags);
+static void APP_geofenceCommand(char * number, char * received_msg);
+static void APP_sendStatus(char * number);
+static const char * APP_parseDecimal(const char * text, uint8 decimals, sint32 * value);
+static void APP_newMsgNotification(const GSM_UrcData * urc);
+static void APP_updateBuzzer(void);
+static void APP_inboxTask(void);
+static boolean APP_inboxStore(uint8 index, const char * sender_number);
+static void APP_inboxListed(GSM_CmdStatus status);
+static void APP_inboxReadDeleted(GSM_CmdStatus status);
+static void APP_inboxMsgDeleted(GSM_CmdStatus status);
+static void APP_inboxStorageChecked(GSM_CmdStatus status);
 
 /*******************************************************************************
  *                     		 Functions Definitions                             *
  *******************************************************************************/
 
 void APP_init(void){
-    APP_switchUARTAccess(GSM);
     LCD_clearScreen();
-	LCD_displayStringRowColumn(0,0," Detecting GSM");
-	LCD_displayStringRowColumn(1,0,"     Module");
-    while(!GSM_init(g_msg_buff));
-    APP_flushBuffer();
-    g_info_received_flag = FALSE;
+	LCD_displayStringRowColumn_P(0,0,PSTR(" Detecting GSM"));
+	LCD_displayStringRowColumn_P(1,0,PSTR("     Module"));
+    while(!GSM_init());
+    GSM_setUrcHandler(GSM_URC_CMTI, APP_newMsgNotification);
     /* get number of contacts saved in EEPROM (saved in address 7 by default)*/
     g_code_config_flag = EEPROM_read(6); 
     g_no_of_contacts = EEPROM_read(7); 
 
     if (!(g_code_config_flag == '$')){ /*special char that indicates the code has been configured*/
-        APP_storeConfirmCode("VTS100");
+        strcpy_P(g_confirmation_code, PSTR(DEF_CONFIRMATION_CODE)); /*default code*/
+        APP_storeConfirmCode(g_confirmation_code);
     }
     
 }
 
-void APP_MQSenCalibration(){
-    LCD_clearScreen();
-	LCD_displayStringRowColumn(0,0,"Calibrating MQ");
-    g_Ro = MQ_sensorCalibration();
-	LCD_displayStringRowColumn(0,0,"Calibration Done !");
-}
-
-boolean APP_isMsgReceived(char * sender_number, char * received_msg){
-	char msg_location [MSG_LOC_BUFFER_SIZE];
-    if(g_info_received_flag){
-        g_info_received_flag = FALSE;
-        if(GSM_isMsgReceived(g_msg_buff, msg_location)){
-		    APP_flushBuffer();
-		    if(!GSM_readMsgContents(msg_location, g_msg_buff, sender_number, received_msg)){
-                LCD_clearScreen();
-		    	LCD_displayStringRowColumn(0,0,"Msg Receiving Error !");
-		        APP_flushBuffer();
-                return FALSE;
-		    }
-            else {
-                LCD_displayStringRowColumn(0, 0, "No.: ");
-		    	LCD_displayString(sender_number);
-		    	LCD_displayStringRowColumn(1, 0,received_msg);
-		        APP_flushBuffer();
-                GSM_deleteMsg(msg_location); /*preserve space*/
-                return TRUE;
-            }
-        }
+boolean APP_isMsgReceived(char ** sender_number, char ** received_msg){
+    APP_InboxEntry * entry;
+
+    if(g_inbox_decoding){ /*the previous message was decoded*/
+        g_inbox_head = (g_inbox_head + 1) % INBOX_QUEUE_SIZE;
+        g_inbox_count--;
+        g_inbox_decoding = FALSE;
+    }
+    APP_inboxTask();
+    if(g_inbox_count == 0){
+        return FALSE;
     }
+    entry = &g_inbox_queue[g_inbox_head];
+    *sender_number = entry->sender_number;
+    *received_msg = entry->message;
+    g_inbox_decoding = TRUE;
+    LCD_displayStringRowColumn_P(0, 0, PSTR("No.: "));
+    LCD_displayString(entry->sender_number);
+    LCD_displayStringRowColumn(1, 0, entry->message);
+    g_lcd_redraw = TRUE;
+    return TRUE;
 }
 
 /*
@@ -102,8 +153,13 @@ E:(msg: "ENT VTS100") new phone entry
 L:(msg: "LOC")  send the current location
 B:(msg: "BUZ")  activate the buzzer for 5 sec
 C:(msg: "CNFG {old_code} {new_code}") change confirmation code
+G:(msg: "GC{id} {lat} {lon} {radius_m}") circular geofence, degrees ("30.0444196")
+G:(msg: "GP{id} {lat} {lon}") add a vertex to polygon geofence {id}
+G:(msg: "GD{id}") remove geofence {id}
+R:(msg: "RCAL") recalibrate the CO sensor, in clean air
+S:(msg: "STAT") battery, supply and auxiliary input voltages, CO reading and exposure average
 */
-void APP_decodeMsg(char * number, char * received_msg, TIMER_ConfigType * const timer1_configPtr){
+void APP_decodeMsg(char * number, char * received_msg){
     char * disp_msg;
     switch (received_msg[0]){
         case 'D':
@@ -115,18 +171,22 @@ void APP_decodeMsg(char * number, char * received_msg, TIMER_ConfigType * const
         case 'E':
             if (APP_findNumber(number)){
                 LCD_clearScreen();
-                LCD_displayStringRowColumn(0,0,"Phone No Already Exists !");
+                LCD_displayStringRowColumn_P(0,0,PSTR("Phone No Already Exists !"));
+            }
+            else if (g_no_of_contacts >= NUM_BOOK_MAX_CONTACTS){
+                LCD_clearScreen();
+                LCD_displayStringRowColumn_P(0,0,PSTR("Phone Book Full !"));
             }
             else if(APP_codeCheck(received_msg)){
                 APP_storeNewEntry(number);
                 LCD_clearScreen();
-                LCD_displayStringRowColumn(0,0,"No: ");
+                LCD_displayStringRowColumn_P(0,0,PSTR("No: "));
                 LCD_displayString(number);
-		    	LCD_displayStringRowColumn(1, 0," Was Stored !");
+		    	LCD_displayStringRowColumn_P(1, 0,PSTR(" Was Stored !"));
             }
             else {
                 LCD_clearScreen();
-                LCD_displayStringRowColumn(0,0,"Wrong Confirmation Code !");
+                LCD_displayStringRowColumn_P(0,0,PSTR("Wrong Confirmation Code !"));
             }
             return;
         break;
@@ -135,28 +195,126 @@ void APP_decodeMsg(char * number, char * received_msg, TIMER_ConfigType * const
 
     if (!APP_findNumber(number)){
         LCD_clearScreen();
-        LCD_displayStringRowColumn(0,0,"Unauthorized Access !");
+        LCD_displayStringRowColumn_P(0,0,PSTR("Unauthorized Access !"));
         return;
     }
 
     switch (received_msg[0]){
         case 'L':
-            APP_sendCoordinates(number, "Location: ");
+            APP_sendLocation(number);
         break;
         case 'B':
-            BUZZER_start();
-            TIMER_init(timer1_configPtr);
-            while (g_timer1_tick < 2);
-	        TIMER_deInit(TIMER1_ID);
-            BUZZER_stop();
-            g_timer1_tick = 0;
+            g_buzz_command = TRUE; /*sounded by APP_emergencyTask()*/
+            g_buzz_ms = SYSTICK_getMs();
         break;        
+        case 'G':
+            APP_geofenceCommand(number, received_msg);
+        break;
+        case 'R':
+            COCAL_recalibrate();
+            GSM_outboxPost_P(number, PSTR("Calibration started"), GSM_PRIORITY_ROUTINE);
+        break;
+        case 'S':
+            APP_sendStatus(number);
+        break;
+    }
+}
+
+/*the inputs without a reading (not fitted, or no ADC result yet) are sent as "--"*/
+static void APP_sendStatus(char * number){
+    static const char labels[AIN_INPUTS][4] PROGMEM = {"Bat", "Sup", "Aux"};
+    uint16 millivolts;
+    uint8 length = 0;
+    uint8 input;
+
+    if (!APP_messageTake(GSM_PRIORITY_ROUTINE)){
+        GSM_outboxPost_P(number, PSTR(APP_BUSY_REPLY), GSM_PRIORITY_ROUTINE);
+        return;
+    }
+    for (input = 0; input < AIN_INPUTS; input++){
+        length += strlen(strcpy_P(&g_message[length], labels[input]));
+        if (AIN_readMillivolts((AIN_Input)input, &millivolts)){
+            length += sprintf_P(&g_message[length], PSTR(" %u.%02uV "),
+                    millivolts / 1000, (millivolts % 1000) / 10);
+        }
+        else {
+            length += sprintf_P(&g_message[length], PSTR(" --V "));
+        }
+    }
+    sprintf_P(&g_message[length], PSTR("CO %u ppm TWA %u ppm"), COALARM_getPpm(), COALARM_getTwa());
+    GSM_outboxPost(number, g_message, GSM_PRIORITY_ROUTINE);
+}
+
+/*geofence change from an authorized number, the result is sent back to it*/
+static void APP_geofenceCommand(char * number, char * received_msg){
+    GEO_Point point;
+    sint32 id = 0;
+    sint32 radius_m = 0;
+    const char * args = APP_parseDecimal(received_msg + 2, 0, &id);
+    boolean done = FALSE;
+
+    if ((id <= 0) || (id > GEOFENCE_SLOTS)){
+        args = NULL_PTR;
     }
+
+    if ((args != NULL_PTR) && (received_msg[1] == 'D')){
+        done = GEOFENCE_remove((uint8)id);
+    }
+    else if ((args != NULL_PTR) && ((args = APP_parseDecimal(args, 7, &point.latitude)) != NULL_PTR)
+            && ((args = APP_parseDecimal(args, 7, &point.longitude)) != NULL_PTR)
+            && (labs(point.latitude) <= 90L * GEO_DEG) && (labs(point.longitude) <= 180L * GEO_DEG)){
+        if (received_msg[1] == 'P'){
+            done = GEOFENCE_addVertex((uint8)id, &point);
+        }
+        else if ((received_msg[1] == 'C') && (APP_parseDecimal(args, 0, &radius_m) != NULL_PTR)
+                && (radius_m > 0) && (radius_m <= 0xFFFF)){
+            done = GEOFENCE_setCircle((uint8)id, &point, (uint16)radius_m);
+        }
+    }
+    GSM_outboxPost_P(number, done ? PSTR("Geofence updated") : PSTR("Geofence command failed"), GSM_PRIORITY_ROUTINE);
 }
 
-static void APP_flushBuffer(){
-	memset(g_msg_buff,0,MSG_BUFFER_SIZE);
-    g_buff_index = 0;
+/*
+ * Decimal number ("-30.0444196") as an integer scaled by 10^decimals, further decimals are
+ * dropped. Returns the text after it, NULL_PTR if there is no number or it does not fit.
+ */
+static const char * APP_parseDecimal(const char * text, uint8 decimals, sint32 * value){
+    sint32 result = 0;
+    boolean negative;
+    boolean fraction = FALSE;
+    uint8 digits = 0;
+
+    while (*text == ' '){
+        text++;
+    }
+    negative = (*text == '-');
+    if (negative){
+        text++;
+    }
+    for ( ; ((*text >= '0') && (*text <= '9')) || ((*text == '.') && !fraction); text++){
+        if (*text == '.'){
+            fraction = TRUE;
+        }
+        else if (!fraction || (decimals > 0)){
+            if (result > (0x7FFFFFFFL - 9) / 10){
+                return NULL_PTR;
+            }
+            result = result * 10 + (*text - '0');
+            decimals -= fraction ? 1 : 0;
+            digits++;
+        }
+    }
+    if (digits == 0){
+        return NULL_PTR;
+    }
+    for ( ; decimals > 0; decimals--){
+        if (result > 0x7FFFFFFFL / 10){
+            return NULL_PTR;
+        }
+        result *= 10;
+    }
+    *value = negative ? -result : result;
+    return text;
 }
 
 static boolean APP_strCmp(char * str1, char * str2){
@@ -203,21 +361,23 @@ id = 2: starting from address 19 -> 27
 id = 3: starting from address 28 -> 36
 ..
 */
-static void APP_getContactNumber(uint8 contact_id){
+static void APP_getContactNumber(uint8 contact_id, char * number){
     uint16 i = NUM_BOOK_START_ADDR + (contact_id-1)*9;
     uint16 end_location = NUM_BOOK_START_ADDR + (contact_id)*9;
-    uint8 j =0;
-    char num [9];
+    uint8 j = 3;
+    strcpy_P(number, PSTR("+01"));
     for ( ; i < end_location; i++, j++){
-        num[j] = EEPROM_readByte(i);
+        number[j] = EEPROM_readByte(i);
     }
-    APP_strCat(g_contact_number, "+01", num);
+    number[j] = '\0';
 }
 
 static boolean APP_findNumber(char * number){
+    char contact_number[DIAL_NO_LENGTH];
+
     for (uint8 i = 1; i <= g_no_of_contacts; i++){
-        APP_getContactNumber(i);
-        if(APP_strCmp(g_contact_number, number)) {
+        APP_getContactNumber(i, contact_number);
+        if(APP_strCmp(contact_number, number)) {
             return TRUE;
         }
     }
@@ -241,61 +401,534 @@ static void APP_storeNewEntry(char * number){
 
 }
 
-static void APP_switchUARTAccess(APP_UART_Access access_granted) {
-    if (access_granted == GPS){
-        USART_setCallBackFunction();
-        GPIO_writePin(PORTB_ID, PIN3_ID, LOGIC_LOW);
+/*
+ * Map link with the coordinates in degrees, printed from the 1e-7 degree fixed point values
+ * at text (68 characters at most). A fix that could not be refreshed is sent with its age.
+ */
+static void APP_formatLocation(char * text, const LOCATION_Entry * location) {
+    sint32 latitude = location->fix.latitude;
+    sint32 longitude = location->fix.longitude;
+    uint8 length;
+
+    if (!location->known){
+        strcpy_P(text, PSTR("no GPS fix yet"));
+        return;
     }
-    else if (access_granted == GSM){
-        USART_setCallBackFunction(APP_bufferRecieve);
-        GPIO_writePin(PORTB_ID, PIN3_ID, LOGIC_HIGH);
+    length = sprintf_P(text, PSTR("https://maps.google.com/?q=%S%ld.%07ld,%S%ld.%07ld"),
+            (latitude < 0) ? PSTR("-") : PSTR(""), labs(latitude) / 10000000L, labs(latitude) % 10000000L,
+            (longitude < 0) ? PSTR("-") : PSTR(""), labs(longitude) / 10000000L, labs(longitude) % 10000000L);
+    if (LOCATION_getAge() > LOCATION_MAX_AGE_MS){
+        sprintf_P(&text[length], PSTR(" (%lu min old)"), LOCATION_getAge() / 60000UL);
     }
-    
 }
 
-static void APP_sendCoordinates(char * number, char * special_message) {
-    char msg_to_send [TRANS_MSG_MAX_LENGTH];
-    char location_hyperlink [LOCATION_HLINK_LENGTH];
-    APP_switchUARTAccess(GPS);
-    /*GPS_getCoordinates(location_hyperlink)*/
-    APP_switchUARTAccess(GSM);
-    APP_strCat(msg_to_send, special_message, location_hyperlink);
-    GSM_sendMsg(number, msg_to_send, g_msg_buff, g_buff_index);
+/*
+ * Queue the location for one recipient. A location reply still going out is shared with
+ * the new recipient, any other text must be sent first.
+ * The fix is waited for before g_message is taken: the wait runs APP_serviceModem(), whose
+ * driving events and geofence alerts may take g_message themselves.
+ */
+static void APP_sendLocation(char * number) {
+    const LOCATION_Entry * location = LOCATION_getFresh(LOCATION_MAX_AGE_MS);
+
+    if (!g_message_location || !APP_fanOutBusy(&g_fanout)){
+        if (!APP_messageTake(GSM_PRIORITY_ROUTINE)){
+            GSM_outboxPost_P(number, PSTR(APP_BUSY_REPLY), GSM_PRIORITY_ROUTINE);
+            return;
+        }
+        strcpy_P(g_message, PSTR("Location: "));
+        APP_formatLocation(&g_message[strlen(g_message)], location);
+        g_message_location = TRUE;
+    }
+    GSM_outboxPost(number, g_message, GSM_PRIORITY_ROUTINE);
+}
+
+/*
+ * TRUE when g_message can be rewritten with a text of this priority. An emergency takes it
+ * from a routine text: the recipients that text was not posted to yet and the ones still
+ * pending are given up, it waits only for the one being sent.
+ */
+static boolean APP_messageTake(GSM_OutboxPriority priority){
+    if ((priority == GSM_PRIORITY_EMERGENCY) && (g_fanout.priority == GSM_PRIORITY_ROUTINE)){
+        g_fanout.next_contact = 0;
+        GSM_outboxCancel(g_message);
+    }
+    if (APP_fanOutBusy(&g_fanout)){
+        return FALSE;
+    }
+    g_fanout.priority = priority;
+    g_message_location = FALSE;
+    return TRUE;
+}
+
+static void APP_fanOutStart(APP_FanOut * fanout){
+    fanout->next_contact = 1;
+    APP_fanOutTask(fanout);
+}
+
+/*post the next contacts until the outbox is full*/
+static void APP_fanOutTask(APP_FanOut * fanout){
+    char contact_number[DIAL_NO_LENGTH];
+
+    while ((fanout->next_contact != 0) && (fanout->next_contact <= g_no_of_contacts)){
+        APP_getContactNumber(fanout->next_contact, contact_number);
+        if (GSM_outboxPost(contact_number, fanout->text, fanout->priority) == GSM_OUTBOX_NO_SLOT){
+            return;
+        }
+        fanout->next_contact++;
+    }
+    fanout->next_contact = 0;
+}
+
+/*the text must not change until every contact is queued and none of them still uses it*/
+static boolean APP_fanOutBusy(const APP_FanOut * fanout){
+    return (fanout->next_contact != 0) || GSM_outboxIsReferenced(fanout->text);
+}
+
+/*route the USART to the GPS while it is configured (UBX frames are sent at boot)*/
+void APP_configureGPS(const GPS_ConfigType * gps_configPtr){
+    ARBITER_request(ARBITER_GPS);
+    while (!ARBITER_isGranted(ARBITER_GPS)){
+        APP_serviceModem();
+    }
+    GPS_init(gps_configPtr);
+    AIDING_sendInitial(); /*last saved position and receiver health*/
+    ARBITER_release(ARBITER_GPS); /*the frames are sent before the relay moves*/
+}
+
+/*
+ * Arbiter callback: notifications the modem sent during the GPS slice were not received,
+ * list the SIM again in case one of them was a new message.
+ */
+void APP_modemResumed(void){
+    g_inbox_scan_request = TRUE;
+}
+
+/*keep modem transactions, queued messages and the GPS parser moving while the application waits*/
+void APP_serviceModem(void){
+    ARBITER_task();
+    GPS_task();
+    GSM_task();
+    GSM_outboxTask();
+    GPRS_task();
+    HTTP_task();
+    TELEMETRY_task();
+    EEPROMINTENAL_task(); /*records staged by the geofences, the GPS aiding and the CO calibration*/
+    GEOFENCE_task();
+    EVENTS_task();
+    AIDING_task();
+    COCAL_task();
+    COALARM_task();
+    APP_fanOutTask(&g_fanout);
+}
+
+/*every new fix is classified against the geofences, checked for driving events and kept for aiding*/
+void APP_checkPosition(void){
+    const LOCATION_Entry * location = LOCATION_getLast();
+    GEO_Point position;
+
+    if (!location->known || (location->timestamp_ms == g_position_fix_ms)){
+        return;
+    }
+    g_position_fix_ms = location->timestamp_ms;
+    position.latitude = location->fix.latitude;
+    position.longitude = location->fix.longitude;
+    GEOFENCE_update(&position);
+    EVENTS_update(location);
+    AIDING_update(location);
+    if (!g_ttff_reported){
+        APP_reportTtff(location);
+    }
+}
+
+/*
+ * Geofence callback: one text fanned out to every contact. Refused while an emergency text
+ * (or the routine one it takes over) is still going out, the geofence module reports the
+ * transition again.
+ */
+boolean APP_geofenceTransition(uint8 id, boolean inside){
+    uint8 length;
+
+    if (!APP_messageTake(GSM_PRIORITY_EMERGENCY)){
+        return FALSE;
+    }
+    length = sprintf_P(g_message, inside ? PSTR("Zone %u entered: ") : PSTR("Zone %u left: "), id);
+    APP_formatLocation(&g_message[length], LOCATION_getLast());
+    APP_fanOutStart(&g_fanout);
+    return TRUE;
+}
+
+/*
+ * Driving event callback, sent to every contact like the geofence alerts (same retry when
+ * the outbox is still busy with the previous event).
+ */
+boolean APP_drivingEvent(const EVENTS_Event * event){
+    uint8 length;
+
+    if (!APP_messageTake(GSM_PRIORITY_ROUTINE)){
+        return FALSE;
+    }
+    switch (event->type){
+        case EVENTS_OVERSPEED:
+            length = sprintf_P(g_message, PSTR("Overspeed %u km/h"), (uint16)(event->value * 36UL / 1000));
+        break;
+        case EVENTS_IDLE:
+            length = sprintf_P(g_message, PSTR("Idle %u min"), event->value / 60);
+        break;
+        default:
+            length = sprintf_P(g_message,
+                    (event->type == EVENTS_HARSH_ACCELERATION) ? PSTR("Harsh acceleration %u.%u m/s2") :
+                    (event->type == EVENTS_HARSH_BRAKING) ? PSTR("Harsh braking %u.%u m/s2") :
+                    PSTR("Harsh cornering %u.%u m/s2"),
+                    event->value / 100, (event->value % 100) / 10);
+        break;
+    }
+    if (event->suppressed > 0){
+        length += sprintf_P(&g_message[length], PSTR(" (+%u)"), event->suppressed);
+    }
+    length += strlen(strcpy_P(&g_message[length], PSTR(": ")));
+    APP_formatLocation(&g_message[length], LOCATION_getLast());
+    APP_fanOutStart(&g_fanout);
+    return TRUE;
+}
+
+/*
+ * Every new fix goes through the track simplification, the kept ones become telemetry
+ * records (APP_trackPoint()). Without a recent fix a record is still added every
+ * TELEMETRY_PERIOD_MS for the CO reading.
+ */
+void APP_reportTelemetry(void){
+    const LOCATION_Entry * location = LOCATION_getLast();
+
+    if (location->known && (location->timestamp_ms != g_track_fix_ms)){
+        g_track_fix_ms = location->timestamp_ms;
+        APP_trackFix(location);
+        return;
+    }
+    if ((LOCATION_getAge() < LOCATION_MAX_AGE_MS) || (SYSTICK_elapsedMs(g_telemetry_ms) < TELEMETRY_PERIOD_MS)){
+        return;
+    }
+    TRACK_flush(); /*fixes still buffered go before the gap*/
+    APP_reportNoFix(location);
+}
+
+/*one fix into the track simplification, the point and the record of APP_reportNoFix() never share a frame*/
+static void APP_trackFix(const LOCATION_Entry * location){
+    TRACK_Point point;
+
+    point.position.latitude = location->fix.latitude;
+    point.position.longitude = location->fix.longitude;
+    point.timestamp_ms = location->timestamp_ms;
+    point.speed = location->fix.speed;
+    point.course = location->fix.course;
+    TRACK_addFix(&point);
+}
+
+/*CO reading at the last known position, flagged as no fix*/
+static void APP_reportNoFix(const LOCATION_Entry * location){
+    TELEMETRY_Record record = {0};
+
+    g_telemetry_ms = SYSTICK_getMs();
+    record.timestamp = APP_timestamp(g_telemetry_ms, &record.flags);
+    record.co_ppm = g_co_ppm;
+    record.latitude = location->fix.latitude;
+    record.longitude = location->fix.longitude;
+    if (APP_COThresholdExceeded()){
+        record.flags |= TELEMETRY_FLAG_CO_ALARM;
+    }
+    TELEMETRY_addRecord(&record);
+}
+
+/*track simplification callback: one telemetry record per kept fix*/
+void APP_trackPoint(const TRACK_Point * point){
+    TELEMETRY_Record record = {0};
+
+    g_telemetry_ms = SYSTICK_getMs();
+    record.flags = TELEMETRY_FLAG_FIX_VALID;
+    record.timestamp = APP_timestamp(point->timestamp_ms, &record.flags);
+    record.co_ppm = g_co_ppm;
+    record.latitude = point->position.latitude;
+    record.longitude = point->position.longitude;
+    record.speed = point->speed;
+    if (APP_COThresholdExceeded()){
+        record.flags |= TELEMETRY_FLAG_CO_ALARM;
+    }
+    TELEMETRY_addRecord(&record);
+}
+
+/*
+ * Unix time of something seen at event_ms (SYSTICK) once a fix gave the GPS time, a track point
+ * kept back by the simplification included. Before that, seconds since boot and the record is
+ * flagged TELEMETRY_FLAG_BOOT_TIME.
+ */
+static uint32 APP_timestamp(uint32 event_ms, uint8 * flags){
+    uint32 gps_seconds;
+
+    if (!AIDING_getTime(&gps_seconds)){
+        *flags |= TELEMETRY_FLAG_BOOT_TIME;
+        return event_ms / 1000;
+    }
+    return gps_seconds - SYSTICK_elapsedMs(event_ms) / 1000 + AIDING_UNIX_OFFSET_S - AIDING_LEAP_SECONDS;
+}
+
+/*
+ * One record per boot for the fleet statistics: time to first fix as its timestamp, the first
+ * fix position and the aiding used in its flags. The receiver measures the TTFF from its power
+ * up (it starts with the MCU), the time the MCU saw the fix is used if it never reports it.
+ */
+static void APP_reportTtff(const LOCATION_Entry * location){
+    TELEMETRY_Record record = {0};
+    uint32 ttff_ms = GPS_getTtff();
+    uint8 aiding = AIDING_getSent();
+
+    if (g_first_fix_ms == 0){
+        g_first_fix_ms = location->timestamp_ms;
+    }
+    if ((ttff_ms == 0) && (SYSTICK_elapsedMs(g_first_fix_ms) < TTFF_WAIT_MS)){
+        return;
+    }
+    if (ttff_ms == 0){
+        ttff_ms = g_first_fix_ms;
+    }
+    record.timestamp = (ttff_ms + 500) / 1000;
+    record.latitude = location->fix.latitude;
+    record.longitude = location->fix.longitude;
+    record.co_ppm = g_co_ppm;
+    record.flags = TELEMETRY_FLAG_FIRST_FIX;
+    if (aiding & AIDING_SENT_POSITION){
+        record.flags |= TELEMETRY_FLAG_POSITION_AIDED;
+    }
+    if (aiding & AIDING_SENT_TIME){
+        record.flags |= TELEMETRY_FLAG_TIME_AIDED;
+    }
+    g_ttff_reported = TELEMETRY_addRecord(&record);
+}
+
+/*+CMTI handler, called from GSM_task() once the whole line has arrived*/
+static void APP_newMsgNotification(const GSM_UrcData * urc){
+    (void)urc; /*the index is not used, the listing finds every message*/
+    g_inbox_scan_request = TRUE; /*picked up by the next batch listing*/
+}
+
+/*
+ * Inbox state machine, never waits on the modem:
+ * 1. Delete one by one the messages taken by an overflowed/failed listing, or send again
+ *    the AT+CMGDA that timed out.
+ * 2. Refresh the SIM occupancy once the slots are cleared.
+ * 3. Start a new listing when requested and the queue has room.
+ */
+static void APP_inboxTask(void){
+    if(g_inbox_delete_count > 0){
+        if(!g_inbox_deleting && (!g_inbox_retry_wait || (SYSTICK_elapsedMs(g_inbox_retry_ms) >= INBOX_RETRY_MS))
+                && GSM_deleteMsg(g_inbox_taken[g_inbox_delete_count - 1], APP_inboxMsgDeleted)){
+            g_inbox_deleting = TRUE;
+            g_inbox_retry_wait = FALSE;
+        }
+        return;
+    }
+    if(g_inbox_delete_read && GSM_deleteReadMsgs(APP_inboxReadDeleted)){
+        g_inbox_delete_read = FALSE;
+    }
+    if(g_inbox_check_storage && GSM_queryStorage(APP_inboxStorageChecked)){
+        g_inbox_check_storage = FALSE;
+    }
+    if(g_inbox_scan_request && !g_inbox_scanning && (g_inbox_count < INBOX_QUEUE_SIZE)
+            && (!g_inbox_retry_wait || (SYSTICK_elapsedMs(g_inbox_retry_ms) >= INBOX_RETRY_MS))){
+        g_inbox_taken_count = 0;
+        if(GSM_listMsgs(MSG_STAT_ALL, APP_inboxStore, APP_inboxListed)){
+            g_inbox_scanning = TRUE;
+            g_inbox_scan_request = FALSE;
+            g_inbox_retry_wait = FALSE;
+        }
+    }
+}
+
+/*called by the AT+CMGL parser for every listed message*/
+static boolean APP_inboxStore(uint8 index, const char * sender_number){
+    APP_InboxEntry * entry;
+
+    /*the main loop decodes while the listing streams, so one listing can take more than the queue holds*/
+    if((g_inbox_count == INBOX_QUEUE_SIZE) || (g_inbox_taken_count == INBOX_QUEUE_SIZE)){
+        return FALSE; /*left in the SIM for the next listing*/
+    }
+    entry = &g_inbox_queue[(g_inbox_head + g_inbox_count) % INBOX_QUEUE_SIZE];
+    strcpy(entry->sender_number, sender_number);
+    GSM_lineCopy(entry->message, REC_MSG_MAX_LENGTH); /*the text line, straight from the receive ring*/
+    g_inbox_count++;
+    g_inbox_taken[g_inbox_taken_count++] = index;
+    return TRUE;
+}
+
+static void APP_inboxListed(GSM_CmdStatus status){
+    if((status == GSM_CMD_OK) && GSM_listAllTaken() && GSM_deleteReadMsgs(APP_inboxReadDeleted)){
+        /*every listed message is ours and now marked as read, cleared in one command
+          (the batch stays open until then so a new listing can not see them again)*/
+        return;
+    }
+    g_inbox_scanning = FALSE;
+    /*keep the messages that were not taken, delete only the taken ones and list again*/
+    g_inbox_delete_count = g_inbox_taken_count;
+    g_inbox_check_storage = TRUE;
+    g_inbox_scan_request = TRUE;
+    if(status != GSM_CMD_OK){
+        g_inbox_retry_wait = TRUE;
+        g_inbox_retry_ms = SYSTICK_getMs();
+    }
+}
+
+static void APP_inboxReadDeleted(GSM_CmdStatus status){
+    if(status == GSM_CMD_TIMEOUT){
+        /*it may have been carried out and new messages stored in the freed slots, deleting by
+          index could hit them, AT+CMGDA again only clears the read ones*/
+        g_inbox_delete_read = TRUE;
+        return;
+    }
+    g_inbox_scanning = FALSE;
+    if(status != GSM_CMD_OK){
+        g_inbox_delete_count = g_inbox_taken_count; /*nothing deleted, one AT+CMGD per taken message*/
+    }
+    g_inbox_check_storage = TRUE;
+}
+
+/*
+ * An error leaves the message in its slot, it is deleted again after INBOX_RETRY_MS (left in
+ * the SIM it would be listed and decoded twice). A timed out AT+CMGD is not sent again, the
+ * slot may already hold a new message.
+ */
+static void APP_inboxMsgDeleted(GSM_CmdStatus status){
+    g_inbox_deleting = FALSE;
+    if((status == GSM_CMD_ERROR) || (status == GSM_CMD_CMS_ERROR)){
+        g_inbox_retry_wait = TRUE;
+        g_inbox_retry_ms = SYSTICK_getMs();
+        return;
+    }
+    g_inbox_delete_count--;
 }
 
-void APP_timerTickIncrement(void){
-	g_timer1_tick++;
+static void APP_inboxStorageChecked(GSM_CmdStatus status){
+    if((status == GSM_CMD_OK) && (GSM_getStorageUsed() > 0)){
+        g_inbox_scan_request = TRUE; /*messages arrived after the listing*/
+    }
 }
-void APP_bufferRecieve(void){
-    g_msg_buff[g_buff_index] = UDR;	    /* copy UDR (received value) to buffer */
-	g_buff_index++;
-	g_info_received_flag = TRUE;		/* flag for new message arrival */
+
+uint16 APP_getCOVal(){
+    g_co_ppm = COALARM_getPpm();
+    return g_co_ppm;
 }
 
-uint8 APP_getCOVal(){
-    return (MQ_getCOPercentage(MQ_ReadSensor()/g_Ro));
+/*
+ * The LCD takes about 4 ms per character or command (lcd.c delays), so the label is only
+ * written again after the screen was replaced, and the digits at most every CO_DISPLAY_MS
+ * when they change: 16 ms for a value of up to 3 digits and its padding, 20 ms for 4 digits.
+ */
+void APP_displayCO(void){
+    uint16 co_ppm = APP_getCOVal();
+    uint8 digits = (co_ppm >= 100) ? 3 : ((co_ppm >= 10) ? 2 : 1);
+
+    if (g_lcd_redraw){
+        LCD_displayStringRowColumn_P(0, 0, PSTR("CO =    PPM"));
+    }
+    else if ((co_ppm == g_co_displayed_ppm) || (SYSTICK_elapsedMs(g_co_displayed_ms) < CO_DISPLAY_MS)){
+        return;
+    }
+    LCD_moveCursor(0, 5);
+    LCD_intgerToString(co_ppm);
+    for ( ; digits < 3; digits++){
+        LCD_displayCharacter(' '); /*clear the digits of a longer previous value*/
+    }
+    g_co_displayed_ppm = co_ppm;
+    g_co_displayed_ms = SYSTICK_getMs();
+    g_lcd_redraw = FALSE;
 }
 
+/*level, rate of rise or exposure alarm on the filtered reading, or the module comparator until the sensor is calibrated*/
 boolean APP_COThresholdExceeded(){
-    return MQ_getDigIP();
+    return COALARM_getAlarms() != 0;
 }
 
-void APP_fireEmergency(TIMER_ConfigType * const timer1_configPtr){
-    uint8 i;
-    TIMER_init(timer1_configPtr);
-    while (g_timer1_tick < 1); // wait for 3 seconds and check again for CO Threshold
-	TIMER_deInit(TIMER1_ID);
-    g_timer1_tick = 0;
-    if(!APP_COThresholdExceeded()){
-        return; 
+/*
+ * Driving events ignition input. The battery only goes over IGNITION_ON_MV while the alternator
+ * charges it, so this is the engine running rather than the key position, which is what the
+ * idle event needs.
+ */
+boolean APP_ignitionOn(void){
+    uint16 millivolts;
+
+    if (!AIN_readMillivolts(AIN_BATTERY, &millivolts)){
+        return TRUE; /*no reading yet, as without the input*/
+    }
+    if (millivolts >= IGNITION_ON_MV){
+        g_ignition_on = TRUE;
+    }
+    else if (millivolts < IGNITION_OFF_MV){
+        g_ignition_on = FALSE;
+    }
+    return g_ignition_on;
+}
+
+/*
+ * Advanced from the main loop. A level, rate of rise or comparator alarm still active after CO_CONFIRM_MS
+ * sounds the buzzer until it clears and texts every contact once. The exposure alarm builds up
+ * over hours, it only texts them, once each time it is raised.
+ */
+void APP_emergencyTask(void){
+    uint8 alarms = COALARM_getAlarms();
+
+    switch (g_co_state){
+        case APP_CO_CLEAR:
+            if (alarms & CO_FIRE_ALARMS){
+                g_co_state = APP_CO_CONFIRMING;
+                g_co_state_ms = SYSTICK_getMs();
+            }
+        break;
+        case APP_CO_CONFIRMING:
+            if (!(alarms & CO_FIRE_ALARMS)){
+                g_co_state = APP_CO_CLEAR;
+            }
+            else if (SYSTICK_elapsedMs(g_co_state_ms) >= CO_CONFIRM_MS){
+                g_co_state = APP_CO_FIRE;
+                g_fire_alert_due = TRUE;
+            }
+        break;
+        case APP_CO_FIRE:
+            if (!(alarms & CO_FIRE_ALARMS)){
+                g_co_state = APP_CO_CLEAR;
+            }
+        break;
+    }
+    if (!(alarms & COALARM_EXPOSURE)){
+        g_exposure_reported = FALSE;
+    }
+    else if (!g_exposure_reported){
+        g_exposure_reported = TRUE;
+        g_exposure_alert_due = TRUE;
+    }
+    /*the alert text is composed once the previous emergency text was queued for every contact and sent*/
+    if ((g_fire_alert_due || g_exposure_alert_due) && APP_messageTake(GSM_PRIORITY_EMERGENCY)){
+        if (g_fire_alert_due){
+            strcpy_P(g_message, PSTR("Fire Emergency: "));
+            g_fire_alert_due = FALSE;
+        }
+        else{
+            strcpy_P(g_message, PSTR("CO Exposure: "));
+            g_exposure_alert_due = FALSE;
+        }
+        APP_formatLocation(&g_message[strlen(g_message)], LOCATION_getLast()); /*the cached fix, a fresh one would mean waiting*/
+        APP_fanOutStart(&g_fanout);
+    }
+    APP_updateBuzzer();
+}
+
+static void APP_updateBuzzer(void){
+    if (g_buzz_command && (SYSTICK_elapsedMs(g_buzz_ms) >= BUZZER_ON_MS)){
+        g_buzz_command = FALSE;
+    }
+    if ((g_co_state == APP_CO_FIRE) || g_buzz_command){
+        BUZZER_start();
     }
-    for ( i = 1; i <= g_no_of_contacts; i++){
-        APP_getContactNumber(i);
-        APP_sendCoordinates(g_contact_number,"Fire Emergency: ");
+    else{
+        BUZZER_stop();
     }
-    BUZZER_start();
-    while (APP_COThresholdExceeded());
-    BUZZER_stop();
 }
 
 static void APP_storeConfirmCode(const char * conf_code){
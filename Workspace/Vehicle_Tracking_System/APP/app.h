@@ -9,38 +9,89 @@
 #define APP_APP_H_
 
 #include "../HAL/SIM900A_GSM/gsm.h"
+#include "telemetry.h"
 #include "../HAL/Buzzer/buzzer.h"
 #include "../HAL/LCD/lcd.h"
 #include "../HAL/Sensors/MQ9/co_sensor.h"
+#include "../HAL/Analog_Inputs/analog_inputs.h"
+#include "location.h"
+#include "geofence.h"
+#include "track.h"
+#include "events.h"
+#include "aiding.h"
+#include "co_calibration.h"
+#include "co_alarm.h"
+#include "../HAL/UART_Arbiter/uart_arbiter.h"
 #include "../MCAL/USART/usart.h"
+#include "../MCAL/SW_UART/sw_uart.h"
 #include "../MCAL/Timer/timer.h"
 #include "../MCAL/GPIO/gpio.h"
 #include "../MCAL/ADC/adc.h"
+#include "../MCAL/Internal_EEPROM/Internal_EEPROM.h"
 
 #include <util/delay.h>
 
 #define DEF_CONFIRMATION_CODE       "VTS100"
 #define NUM_BOOK_START_ADDR         0x000A
-#define TIMER1_COMPARE_VALUE_3SEC   24576
-#define LOCATION_HLINK_LENGTH   100
+#define NUM_BOOK_ENTRY_SIZE         9
+#define NUM_BOOK_MAX_CONTACTS       16      /*the geofences follow the contact book*/
 #define CONFIRM_CODE_LENGTH 7
+#define INBOX_QUEUE_SIZE    2       /*received commands waiting to be decoded (54 bytes of RAM each)*/
+#define INBOX_RETRY_MS      5000    /*delay before listing the SIM again after a failure*/
+#define TELEMETRY_PERIOD_MS 15000   /*report interval over GPRS while there is no fix*/
+#define LOCATION_MAX_AGE_MS 60000   /*older cached fixes are refreshed before being sent*/
+#define BUZZER_ON_MS        6000    /*"BUZ" command*/
+#define APP_BUSY_REPLY      "Busy, try again later"     /*"LOC" or "STAT" while another text is going out*/
+#define IGNITION_ON_MV      13200   /*battery voltage of a running engine (alternator charging)*/
+#define IGNITION_OFF_MV     12800
+#define CO_CONFIRM_MS       3000    /*the fire alarm must still be active after this long*/
+#define CO_DISPLAY_MS       1000    /*LCD refresh of the CO reading, a full redraw takes 52 ms*/
+#define CO_FIRE_ALARMS      (COALARM_LEVEL | COALARM_RISE | COALARM_COMPARATOR)  /*buzzer and fire alert, the exposure alarm is only texted*/
+#define TTFF_WAIT_MS        15000   /*for the receiver TTFF (every UBX_TIME_RATE fixes, never in NMEA mode)*/
 
 typedef enum{
-	GPS, GSM
-}APP_UART_Access; 
+	APP_CO_CLEAR, APP_CO_CONFIRMING, APP_CO_FIRE
+}APP_COState;
+
+/*
+ * One text sent to every contact of the book. The outbox has fewer slots than the book
+ * holds contacts, the contacts it could not take yet are posted from the main loop.
+ */
+typedef struct{
+	const char * text;
+	uint8 next_contact;			/*1 .. g_no_of_contacts, 0 once every contact is queued*/
+	GSM_OutboxPriority priority;
+}APP_FanOut;
+
+/*message taken from the SIM by the batch inbox listing*/
+typedef struct{
+	char sender_number[DIAL_NO_LENGTH];
+	char message[REC_MSG_MAX_LENGTH];
+}APP_InboxEntry;
 
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
 void APP_init(void);
-void APP_MQSenCalibration();
-boolean APP_isMsgReceived(char * sender_number, char * received_msg);
-void APP_decodeMsg(char * number, char * received_msg, TIMER_ConfigType * const timer1_configPtr);
-void APP_timerTickIncrement(void);
-void APP_bufferRecieve(void);
-uint8 APP_getCOVal();
+/*
+ * The message is decoded in place: the pointers returned stay valid, and the message stays in
+ * the inbox queue, until the next call.
+ */
+boolean APP_isMsgReceived(char ** sender_number, char ** received_msg);
+void APP_decodeMsg(char * number, char * received_msg);
+uint16 APP_getCOVal();
+void APP_displayCO(void);  /*CO reading on the LCD, only what changed (see CO_DISPLAY_MS)*/
 boolean APP_COThresholdExceeded();
-void APP_fireEmergency(TIMER_ConfigType * const timer1_configPtr);
+void APP_emergencyTask(void);
+void APP_configureGPS(const GPS_ConfigType * gps_configPtr);
+void APP_modemResumed(void);
+void APP_serviceModem(void);
+void APP_reportTelemetry(void);
+void APP_trackPoint(const TRACK_Point * point);
+void APP_checkPosition(void);
+boolean APP_geofenceTransition(uint8 id, boolean inside);
+boolean APP_drivingEvent(const EVENTS_Event * event);
+boolean APP_ignitionOn(void);
 
 
 #endif /* APP_APP_H_ */
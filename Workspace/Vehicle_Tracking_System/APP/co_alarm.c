@@ -0,0 +1,175 @@
+/*
+ * co_alarm.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  The average is kept in Q4. The rate of rise and the exposure work on the filtered reading
+ *  once a second: a ring of the last COALARM_RISE_WINDOW_S seconds (one reading every
+ *  COALARM_RISE_STEP_S), and sums of the readings of every second over the current bucket
+ *  (at most 1800 x 10227) and of the bucket averages.
+ */
+
+#include "co_alarm.h"
+#include "co_calibration.h"
+#include "../HAL/Sensors/MQ9/co_sensor.h"
+#include "../MCAL/Timer/systick.h"
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define COALARM_RISE_SIZE		(COALARM_RISE_WINDOW_S / COALARM_RISE_STEP_S)
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static const COALARM_ConfigType * g_coalarm_config = NULL_PTR;	/*in the flash*/
+static uint32 g_sample_ms;						/*start of the current sample period*/
+static uint32 g_second_ms;						/*start of the current second*/
+
+static uint16 g_readings[COALARM_MEDIAN_SIZE];
+static uint8 g_readings_index = 0;
+static boolean g_started = FALSE;
+static sint32 g_average_q4;
+static uint16 g_ppm = 0;
+
+static uint16 g_rise[COALARM_RISE_SIZE];	/*filtered ppm of the last seconds, oldest at g_rise_index*/
+static uint8 g_rise_index = 0;
+
+static uint32 g_bucket_sum = 0;
+static uint16 g_bucket_seconds = 0;
+static uint8 g_buckets[COALARM_TWA_BUCKETS];	/*bucket averages, 255 ppm at most (above the level alarm anyway)*/
+static uint8 g_bucket_index = 0;
+static uint32 g_buckets_sum = 0;
+
+static uint8 g_alarms = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint16 COALARM_median(void);
+static void COALARM_second(void);
+static void COALARM_check(uint8 alarm, uint16 threshold, boolean set, boolean clear);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void COALARM_init(const COALARM_ConfigType * a_configPtr){
+	g_coalarm_config = a_configPtr;
+	g_sample_ms = SYSTICK_getMs();
+	g_second_ms = g_sample_ms;
+}
+
+void COALARM_task(void){
+	sint32 reading;
+	uint16 rise;
+	uint16 alarm_ppm;
+	uint16 rise_ppm;
+	uint8 i;
+
+	if((g_coalarm_config == NULL_PTR) || (SYSTICK_elapsedMs(g_sample_ms) < COALARM_SAMPLE_PERIOD_MS)){
+		return;
+	}
+	g_sample_ms += COALARM_SAMPLE_PERIOD_MS; /*on the period, whatever the main loop latency*/
+
+	g_readings[g_readings_index] = MQ_getCOppm(MQ_readSensor(), COCAL_getRo());
+	if(!g_started){ /*the first reading fills the median and the rise window*/
+		for(i = 0; i < COALARM_MEDIAN_SIZE; i++){
+			g_readings[i] = g_readings[g_readings_index];
+		}
+		for(i = 0; i < COALARM_RISE_SIZE; i++){
+			g_rise[i] = g_readings[0];
+		}
+		g_average_q4 = (sint32)g_readings[0] << 4;
+		g_started = TRUE;
+	}
+	g_readings_index = (g_readings_index + 1) % COALARM_MEDIAN_SIZE;
+	reading = (sint32)COALARM_median() << 4;
+	g_average_q4 += (reading - g_average_q4) >> pgm_read_byte(&g_coalarm_config->filter_shift);
+	g_ppm = (uint16)((g_average_q4 + 8) >> 4);
+
+	alarm_ppm = pgm_read_word(&g_coalarm_config->alarm_ppm);
+	COALARM_check(COALARM_LEVEL, alarm_ppm, g_ppm >= alarm_ppm, g_ppm < pgm_read_word(&g_coalarm_config->clear_ppm));
+	rise = (g_ppm > g_rise[g_rise_index]) ? (g_ppm - g_rise[g_rise_index]) : 0;
+	rise_ppm = pgm_read_word(&g_coalarm_config->rise_ppm);
+	COALARM_check(COALARM_RISE, rise_ppm, rise >= rise_ppm, rise < rise_ppm / 2);
+	if(MQ_getDigIP() && ((COCAL_getRo() == 0) || COCAL_isCalibrating())){
+		g_alarms |= COALARM_COMPARATOR;
+	}
+	else{
+		g_alarms &= (uint8)~COALARM_COMPARATOR;
+	}
+
+	while(SYSTICK_elapsedMs(g_second_ms) >= 1000){ /*seconds missed by a stalled loop are counted too*/
+		g_second_ms += 1000;
+		COALARM_second();
+	}
+}
+
+uint16 COALARM_getPpm(void){
+	return g_ppm;
+}
+
+/*the current bucket counts as it is so far, the oldest one only leaves once it is complete*/
+uint16 COALARM_getTwa(void){
+	return (uint16)((g_buckets_sum + g_bucket_sum / COALARM_TWA_BUCKET_S) / COALARM_TWA_BUCKETS);
+}
+
+uint8 COALARM_getAlarms(void){
+	return g_alarms;
+}
+
+/*insertion sort of a copy, COALARM_MEDIAN_SIZE is small*/
+static uint16 COALARM_median(void){
+	uint16 sorted[COALARM_MEDIAN_SIZE];
+	uint16 value;
+	uint8 i, j;
+
+	for(i = 0; i < COALARM_MEDIAN_SIZE; i++){
+		value = g_readings[i];
+		for(j = i; (j > 0) && (sorted[j - 1] > value); j--){
+			sorted[j] = sorted[j - 1];
+		}
+		sorted[j] = value;
+	}
+	return sorted[COALARM_MEDIAN_SIZE / 2];
+}
+
+static void COALARM_second(void){
+	uint16 twa;
+	uint16 twa_ppm = pgm_read_word(&g_coalarm_config->twa_ppm);
+
+	if((g_bucket_seconds % COALARM_RISE_STEP_S) == 0){ /*buckets are a whole number of steps*/
+		g_rise[g_rise_index] = g_ppm;
+		g_rise_index = (g_rise_index + 1) % COALARM_RISE_SIZE;
+	}
+
+	g_bucket_sum += g_ppm;
+	g_bucket_seconds++;
+	if(g_bucket_seconds == COALARM_TWA_BUCKET_S){
+		g_buckets_sum -= g_buckets[g_bucket_index];
+		g_bucket_sum /= COALARM_TWA_BUCKET_S;
+		g_buckets[g_bucket_index] = (g_bucket_sum > 0xFF) ? 0xFF : (uint8)g_bucket_sum;
+		g_buckets_sum += g_buckets[g_bucket_index];
+		g_bucket_index = (g_bucket_index + 1) % COALARM_TWA_BUCKETS;
+		g_bucket_sum = 0;
+		g_bucket_seconds = 0;
+	}
+	twa = COALARM_getTwa();
+	COALARM_check(COALARM_EXPOSURE, twa_ppm, twa >= twa_ppm, twa < twa_ppm - (twa_ppm >> COALARM_TWA_CLEAR_SHIFT));
+}
+
+/*a threshold of 0 disables the alarm*/
+static void COALARM_check(uint8 alarm, uint16 threshold, boolean set, boolean clear){
+	if((threshold == 0) || clear){
+		g_alarms &= (uint8)~alarm;
+	}
+	else if(set){
+		g_alarms |= alarm;
+	}
+}
@@ -0,0 +1,77 @@
+/*
+ * co_alarm.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  CO alarms found on the analogue sensor reading (integer arithmetic only), one sample every
+ *  COALARM_SAMPLE_PERIOD_MS, about one result of the ADC background sampling:
+ *    filter:	median of the last COALARM_MEDIAN_SIZE readings (spikes), then an exponential
+ *    			average of weight 1 / 2^filter_shift.
+ *    level:	filtered CO at alarm_ppm, until it drops below clear_ppm.
+ *    rate of rise:	filtered CO up by rise_ppm within COALARM_RISE_WINDOW_S, for a fast leak
+ *    			still under the level threshold, until the rise drops below rise_ppm / 2.
+ *    exposure:	time weighted average over COALARM_TWA_BUCKETS x COALARM_TWA_BUCKET_S (8 h,
+ *    			time before the boot counts as clean air) at twa_ppm, until it drops below
+ *    			twa_ppm - twa_ppm / 2^COALARM_TWA_CLEAR_SHIFT (the average of the current bucket
+ *    			moves every second). Completed buckets count 255 ppm at most.
+ *    comparator:	output of the module comparator (its potentiometer threshold), only while the
+ *    			sensor has no calibration or is being calibrated (co_calibration.h), there is no
+ *    			reading (0 ppm) until the first one.
+ *  A threshold of 0 disables its alarm.
+ */
+
+#ifndef APP_CO_ALARM_H_
+#define APP_CO_ALARM_H_
+
+#include "../Utils/std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define COALARM_SAMPLE_PERIOD_MS	100
+#define COALARM_MEDIAN_SIZE			5
+#define COALARM_RISE_WINDOW_S		16
+#define COALARM_RISE_STEP_S			2		/*one reading kept every 2 s in the rise window*/
+#define COALARM_TWA_BUCKET_S		1800	/*30 min averages*/
+#define COALARM_TWA_BUCKETS			16
+#define COALARM_TWA_CLEAR_SHIFT		3		/*the exposure alarm clears 1/8 below twa_ppm*/
+
+/*active alarms, COALARM_getAlarms()*/
+#define COALARM_LEVEL				0x01
+#define COALARM_RISE				0x02
+#define COALARM_EXPOSURE			0x04
+#define COALARM_COMPARATOR			0x08
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+/*thresholds in ppm, clear_ppm below alarm_ppm*/
+typedef struct{
+	uint8 filter_shift;
+	uint16 alarm_ppm;
+	uint16 clear_ppm;
+	uint16 rise_ppm;
+	uint16 twa_ppm;
+}COALARM_ConfigType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+void COALARM_init(const COALARM_ConfigType * a_configPtr);	/*configuration in PROGMEM*/
+
+/*Sample and check the sensor when it is due. Call from the main loop.*/
+void COALARM_task(void);
+
+/*filtered CO (ppm)*/
+uint16 COALARM_getPpm(void);
+
+/*exposure time weighted average so far (ppm)*/
+uint16 COALARM_getTwa(void);
+
+uint8 COALARM_getAlarms(void);
+
+#endif /* APP_CO_ALARM_H_ */
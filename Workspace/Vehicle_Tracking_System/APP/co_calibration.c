@@ -0,0 +1,229 @@
+/*
+ * co_calibration.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Ro is at most 10.23 Mohm / 9.83, so the average is kept in Q8 in a signed 32-bit value.
+ *  A stamp of 0 (saved before the GPS time was known) never makes the record stale, it is
+ *  replaced at the next save once the time is known.
+ */
+
+#include "co_calibration.h"
+#include "aiding.h"
+#include "../HAL/Sensors/MQ9/co_sensor.h"
+#include "../MCAL/Internal_EEPROM/Internal_EEPROM.h"
+#include "../MCAL/Timer/systick.h"
+#include <util/crc16.h>
+#include <string.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define COCAL_RECORD_SIZE			(sizeof(COCAL_Record) + 1)
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef struct{
+	uint32 ro;
+	uint32 gps_seconds;
+}COCAL_Record;
+
+typedef enum{
+	COCAL_WARMUP, COCAL_SAMPLING, COCAL_TRACKING
+}COCAL_State;
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static COCAL_State g_state = COCAL_WARMUP;
+static uint32 g_state_ms;						/*SYSTICK time of the state change, then of the last sample*/
+static boolean g_full_pending = FALSE;			/*full calibration at the end of the warm-up*/
+static uint32 g_sum;
+static uint8 g_count;
+
+static uint32 g_ro = 0;
+static sint32 g_average_q8;						/*tracked Ro, Q8*/
+
+static COCAL_Record g_saved;
+static uint32 g_saved_ms;						/*SYSTICK time of the last save*/
+static boolean g_saved_once = FALSE;			/*saved since boot*/
+static boolean g_save_due = FALSE;				/*a calibration waits for the EEPROM staging buffer*/
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint8 COCAL_crc(const uint8 * data, uint8 length);
+static void COCAL_startSampling(void);
+static void COCAL_sample(void);
+static void COCAL_track(void);
+static boolean COCAL_isStale(void);
+static void COCAL_save(boolean forced);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void COCAL_init(void){
+	uint8 * data = (uint8 *)&g_saved;
+	uint8 i;
+
+	for(i = 0; i < COCAL_RECORD_SIZE - 1; i++){
+		data[i] = EEPROMINTENAL_readByte(COCAL_ADDR + i);
+	}
+	if((EEPROMINTENAL_readByte(COCAL_ADDR + COCAL_RECORD_SIZE - 1) == COCAL_crc(data, COCAL_RECORD_SIZE - 1))
+			&& (g_saved.ro != 0)){
+		g_ro = g_saved.ro;
+		g_average_q8 = (sint32)(g_ro << 8);
+	}
+	else{
+		g_saved.ro = 0;
+		g_full_pending = TRUE;
+	}
+	g_state = COCAL_WARMUP;
+	g_state_ms = SYSTICK_getMs();
+}
+
+void COCAL_task(void){
+	switch(g_state){
+	case COCAL_WARMUP:
+		if(SYSTICK_elapsedMs(g_state_ms) >= COCAL_WARMUP_MS){
+			if(g_full_pending){
+				COCAL_startSampling();
+			}
+			else{
+				g_state = COCAL_TRACKING;
+				g_state_ms = SYSTICK_getMs();
+			}
+		}
+		break;
+	case COCAL_SAMPLING:
+		if(SYSTICK_elapsedMs(g_state_ms) >= COCAL_SAMPLE_PERIOD_MS){
+			COCAL_sample();
+		}
+		break;
+	case COCAL_TRACKING:
+		if(COCAL_isStale()){
+			COCAL_startSampling();
+		}
+		else if(SYSTICK_elapsedMs(g_state_ms) >= COCAL_TRACK_PERIOD_MS){
+			COCAL_track();
+		}
+		break;
+	}
+	if(g_save_due){
+		COCAL_save(TRUE);
+	}
+}
+
+/*a command during the warm-up waits for its end, a running calibration restarts*/
+void COCAL_recalibrate(void){
+	g_full_pending = TRUE;
+	if(g_state != COCAL_WARMUP){
+		COCAL_startSampling();
+	}
+}
+
+uint32 COCAL_getRo(void){
+	return g_ro;
+}
+
+boolean COCAL_isCalibrating(void){
+	return g_full_pending || (g_state == COCAL_SAMPLING);
+}
+
+static uint8 COCAL_crc(const uint8 * data, uint8 length){
+	uint8 crc = 0;
+	uint8 i;
+
+	for(i = 0; i < length; i++){
+		crc = _crc_ibutton_update(crc, data[i]);
+	}
+	return crc;
+}
+
+static void COCAL_startSampling(void){
+	g_full_pending = FALSE;
+	g_sum = 0;
+	g_count = 0;
+	g_state = COCAL_SAMPLING;
+	g_state_ms = SYSTICK_getMs();
+}
+
+/*the readings keep the previous Ro until the average of the COCAL_SAMPLES samples replaces it*/
+static void COCAL_sample(void){
+	g_state_ms = SYSTICK_getMs();
+	g_sum += MQ_readSensor();					/*50 x 10.23 Mohm at most*/
+	g_count++;
+	if(g_count < COCAL_SAMPLES){
+		return;
+	}
+	g_ro = (g_sum / COCAL_SAMPLES) * 100 / RO_CLEAN_AIR_FACTOR_X100;
+	if(g_ro == 0){
+		g_ro = 1;								/*shorted sensor, still a calibration*/
+	}
+	g_average_q8 = (sint32)(g_ro << 8);
+	g_state = COCAL_TRACKING;
+	COCAL_save(TRUE);
+}
+
+static void COCAL_track(void){
+	uint32 candidate;
+	uint32 difference;
+
+	g_state_ms = SYSTICK_getMs();
+	candidate = MQ_readSensor() * 100 / RO_CLEAN_AIR_FACTOR_X100;
+	difference = (candidate > g_ro) ? (candidate - g_ro) : (g_ro - candidate);
+	if(difference * 100 > g_ro * COCAL_TRACK_WINDOW_PCT){
+		return;									/*gas or a sensor fault, not drift*/
+	}
+	g_average_q8 += ((sint32)(candidate << 8) - g_average_q8) >> COCAL_TRACK_SHIFT;
+	g_ro = (uint32)g_average_q8 >> 8;
+	COCAL_save(FALSE);
+}
+
+/*no baseline tracked for COCAL_MAX_AGE_S, known once a fix gave the time*/
+static boolean COCAL_isStale(void){
+	uint32 now;
+
+	return (g_saved.gps_seconds != 0) && AIDING_getTime(&now) && ((now - g_saved.gps_seconds) >= COCAL_MAX_AGE_S);
+}
+
+/*
+ * a calibration is always saved (once the EEPROM staging buffer is free), a tracked Ro when it
+ * moved or the stamp is a day old
+ */
+static void COCAL_save(boolean forced){
+	uint32 now = 0;
+	boolean time_known = AIDING_getTime(&now);
+	uint32 difference = (g_ro > g_saved.ro) ? (g_ro - g_saved.ro) : (g_saved.ro - g_ro);
+	uint8 * data;
+
+	if(!forced){
+		if(EEPROMINTENAL_isWriting() || (g_saved_once && (SYSTICK_elapsedMs(g_saved_ms) < COCAL_SAVE_MIN_GAP_MS))){
+			return;
+		}
+		if((difference * 100 < g_saved.ro * COCAL_SAVE_CHANGE_PCT) &&
+				(!time_known || ((now - g_saved.gps_seconds) < COCAL_REFRESH_S))){
+			return;
+		}
+	}
+	data = EEPROMINTENAL_claim();
+	if(data == NULL_PTR){
+		g_save_due = g_save_due || forced;
+		return;
+	}
+	g_save_due = FALSE;
+	g_saved.ro = g_ro;
+	g_saved.gps_seconds = now;
+	g_saved_ms = SYSTICK_getMs();
+	g_saved_once = TRUE;
+	memcpy(data, &g_saved, sizeof(COCAL_Record));
+	data[COCAL_RECORD_SIZE - 1] = COCAL_crc(data, COCAL_RECORD_SIZE - 1);
+	EEPROMINTENAL_commit(COCAL_ADDR, COCAL_RECORD_SIZE);
+}
@@ -0,0 +1,68 @@
+/*
+ * co_calibration.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  MQ-9 calibration (Ro, the sensor resistance in clean air / RO_CLEAN_AIR_FACTOR) kept in the
+ *  internal EEPROM and loaded at boot, so the CO readings start at once.
+ *
+ *  Baseline tracking: once the heater is warm, one sample every COCAL_TRACK_PERIOD_MS moves
+ *  Ro by 1/2^COCAL_TRACK_SHIFT of its distance to the sample (exponential moving average,
+ *  time constant about 4 h). Samples more than COCAL_TRACK_WINDOW_PCT away from Ro are left
+ *  out: CO lowers Rs by far more than the sensor drifts. Ro is saved when it moved by
+ *  COCAL_SAVE_CHANGE_PCT, or daily while it is tracked, with the GPS time as its stamp.
+ *
+ *  Full calibration (50 samples over 25 s, the air must be clean), done in the background:
+ *  at boot when no Ro is stored, on COCAL_recalibrate() (SMS command) and when the stamp is
+ *  older than COCAL_MAX_AGE_S (the baseline stopped tracking, e.g. after a heater fault).
+ *  There is no CO reading (0 ppm) until the first calibration after the stored Ro was lost.
+ *
+ *  Record layout (COCAL_ADDR): Ro u32 (ohms), GPS time u32 (seconds, 0 unknown), CRC-8.
+ */
+
+#ifndef APP_CO_CALIBRATION_H_
+#define APP_CO_CALIBRATION_H_
+
+#include "../Utils/std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * EEPROM map: 0x000-0x009 settings, 0x00A-0x099 contact book, 0x09A-0x18F geofences,
+ * 0x190-0x1ED GPS aiding, 0x1EE-0x1F6 CO calibration, 0x1F7-0x1FF free, 0x200- journal.
+ */
+#define COCAL_ADDR					0x01EE
+
+#define COCAL_WARMUP_MS				180000UL	/*heater warm-up before the samples are trusted*/
+#define COCAL_SAMPLES				50
+#define COCAL_SAMPLE_PERIOD_MS		500
+#define COCAL_TRACK_PERIOD_MS		60000UL
+#define COCAL_TRACK_SHIFT			8
+#define COCAL_TRACK_WINDOW_PCT		25
+#define COCAL_SAVE_CHANGE_PCT		2
+#define COCAL_SAVE_MIN_GAP_MS		3600000UL	/*EEPROM wear: at most one save an hour*/
+#define COCAL_REFRESH_S				86400UL
+#define COCAL_MAX_AGE_S				2592000UL	/*30 days*/
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*Load the stored Ro (blocking EEPROM reads, call once at boot)*/
+void COCAL_init(void);
+
+/*Calibration and baseline samples, the record is written by EEPROMINTENAL_task(). Call from the main loop.*/
+void COCAL_task(void);
+
+/*Start a full calibration, the sensor must be in clean air*/
+void COCAL_recalibrate(void);
+
+/*Ro in ohms, 0 while there is none*/
+uint32 COCAL_getRo(void);
+
+boolean COCAL_isCalibrating(void);
+
+#endif /* APP_CO_CALIBRATION_H_ */
@@ -0,0 +1,214 @@
+/*
+ * events.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ */
+
+#include "events.h"
+#include "../Utils/geo.h"
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define EVENTS_MS_RAD_PER_CDEG_Q15	5719U	/*1000 x pi / 18000 in Q15: 1e-2 degrees per ms to rad/s*/
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static const EVENTS_ConfigType * g_events_config;	/*in the flash*/
+static uint16 g_previous_speed;				/*of the previous fix*/
+static uint16 g_previous_course;
+static uint32 g_previous_ms;
+static boolean g_started = FALSE;
+
+static boolean g_overspeed = FALSE;				/*over the threshold since g_overspeed_ms*/
+static boolean g_overspeed_reported = FALSE;
+static uint32 g_overspeed_ms;
+static uint16 g_overspeed_peak;
+static boolean g_stopped = FALSE;				/*stopped with the ignition on since g_stop_ms*/
+static boolean g_idle_reported = FALSE;
+static uint32 g_stop_ms;
+static uint8 g_harsh_active = 0;				/*bit per harsh type still over its threshold*/
+
+/*rate limit, per event type (seconds wrap after 18 h, longer than any rate limit)*/
+static uint16 g_queued_s[EVENTS_TYPES];
+static uint8 g_queued_once = 0;				/*bit per event type queued since the start*/
+static uint16 g_suppressed[EVENTS_TYPES];
+
+static EVENTS_Event g_queue[EVENTS_QUEUE_SIZE];
+static uint8 g_queue_head = 0;
+static uint8 g_queue_count = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void EVENTS_checkOverspeed(uint16 speed, uint32 now_ms);
+static void EVENTS_checkIdle(uint16 speed, uint32 now_ms);
+static void EVENTS_checkHarsh(EVENTS_Type type, uint32 acceleration, uint16 threshold, uint32 now_ms);
+static void EVENTS_raise(EVENTS_Type type, uint16 value, uint32 now_ms);
+static uint16 EVENTS_courseChange(uint16 from, uint16 to);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void EVENTS_init(const EVENTS_ConfigType * a_configPtr){
+	uint8 type;
+
+	g_events_config = a_configPtr;
+	g_started = FALSE;
+	g_queue_count = 0;
+	g_queued_once = 0;
+	for(type = 0; type < EVENTS_TYPES; type++){
+		g_suppressed[type] = 0;
+	}
+}
+
+/*
+ * Description :
+ * Longitudinal acceleration from the speed change, lateral acceleration from the speed
+ * times the course rate: v (cm/s) x dcourse (1e-2 degrees) x pi / 18000 / dt (s).
+ */
+void EVENTS_update(const LOCATION_Entry * location){
+	const GPS_Fix * fix = &location->fix;
+	uint32 now_ms = location->timestamp_ms;
+	uint32 elapsed_ms = now_ms - g_previous_ms;
+	uint32 lateral;
+	uint16 speed;
+	uint16 acceleration_cms2;
+	uint16 braking_cms2;
+
+	if(g_events_config == NULL_PTR){
+		return;
+	}
+	acceleration_cms2 = pgm_read_word(&g_events_config->harsh_acceleration_cms2);
+	braking_cms2 = pgm_read_word(&g_events_config->harsh_braking_cms2);
+	EVENTS_checkOverspeed(fix->speed, now_ms);
+	EVENTS_checkIdle(fix->speed, now_ms);
+	if(g_started && (elapsed_ms > 0) && (elapsed_ms <= EVENTS_MAX_FIX_GAP_MS)){
+		if(fix->speed >= g_previous_speed){
+			EVENTS_checkHarsh(EVENTS_HARSH_ACCELERATION, (uint32)(fix->speed - g_previous_speed) * 1000 / elapsed_ms,
+					acceleration_cms2, now_ms);
+			EVENTS_checkHarsh(EVENTS_HARSH_BRAKING, 0, braking_cms2, now_ms);
+		}
+		else{
+			EVENTS_checkHarsh(EVENTS_HARSH_BRAKING, (uint32)(g_previous_speed - fix->speed) * 1000 / elapsed_ms,
+					braking_cms2, now_ms);
+			EVENTS_checkHarsh(EVENTS_HARSH_ACCELERATION, 0, acceleration_cms2, now_ms);
+		}
+		lateral = 0;
+		if((fix->speed >= EVENTS_CORNER_MIN_SPEED_CMS) && (g_previous_speed >= EVENTS_CORNER_MIN_SPEED_CMS)){
+			speed = (uint16)(((uint32)fix->speed + g_previous_speed) / 2);
+			lateral = (uint32)GEO_mulQ15((sint32)((uint32)speed * EVENTS_courseChange(g_previous_course, fix->course)
+					/ elapsed_ms), EVENTS_MS_RAD_PER_CDEG_Q15);
+		}
+		EVENTS_checkHarsh(EVENTS_HARSH_CORNERING, lateral, pgm_read_word(&g_events_config->harsh_cornering_cms2), now_ms);
+	}
+	g_previous_speed = fix->speed;
+	g_previous_course = fix->course;
+	g_previous_ms = now_ms;
+	g_started = TRUE;
+}
+
+void EVENTS_task(void){
+	boolean (*on_event)(const EVENTS_Event * event);
+
+	if((g_queue_count == 0) || (g_events_config == NULL_PTR)){
+		return;
+	}
+	on_event = pgm_read_ptr(&g_events_config->on_event);
+	if(on_event(&g_queue[g_queue_head])){
+		g_queue_head = (g_queue_head + 1) % EVENTS_QUEUE_SIZE;
+		g_queue_count--;
+	}
+}
+
+static void EVENTS_checkOverspeed(uint16 speed, uint32 now_ms){
+	uint16 threshold = pgm_read_word(&g_events_config->overspeed_cms);
+
+	if(threshold == 0){
+		return;
+	}
+	if(speed > threshold){
+		if(!g_overspeed){
+			g_overspeed = TRUE;
+			g_overspeed_ms = now_ms;
+			g_overspeed_peak = 0;
+		}
+		if(speed > g_overspeed_peak){
+			g_overspeed_peak = speed;
+		}
+		if(!g_overspeed_reported && ((now_ms - g_overspeed_ms) >= pgm_read_word(&g_events_config->overspeed_hold_s) * 1000UL)){
+			g_overspeed_reported = TRUE;
+			EVENTS_raise(EVENTS_OVERSPEED, g_overspeed_peak, now_ms);
+		}
+	}
+	else if(speed + EVENTS_SPEED_HYSTERESIS_CMS < threshold){
+		g_overspeed = FALSE;
+		g_overspeed_reported = FALSE;
+	}
+	/*within the hysteresis band the overspeed (and its hold time) goes on*/
+}
+
+static void EVENTS_checkIdle(uint16 speed, uint32 now_ms){
+	boolean (*ignition_on)(void) = pgm_read_ptr(&g_events_config->ignition_on);
+	uint16 idle_s = pgm_read_word(&g_events_config->idle_s);
+
+	if((idle_s == 0) || ((ignition_on != NULL_PTR) && !ignition_on()) || (speed >= EVENTS_STOP_SPEED_CMS)){
+		g_stopped = FALSE;
+		g_idle_reported = FALSE;
+		return;
+	}
+	if(!g_stopped){
+		g_stopped = TRUE;
+		g_stop_ms = now_ms;
+	}
+	if(!g_idle_reported && ((now_ms - g_stop_ms) >= idle_s * 1000UL)){
+		g_idle_reported = TRUE;
+		EVENTS_raise(EVENTS_IDLE, idle_s, now_ms);
+	}
+}
+
+/*one event when the acceleration goes over the threshold, none while it stays over*/
+static void EVENTS_checkHarsh(EVENTS_Type type, uint32 acceleration, uint16 threshold, uint32 now_ms){
+	uint8 mask = (uint8)(1 << type);
+
+	if((threshold == 0) || (acceleration < threshold)){
+		g_harsh_active &= (uint8)~mask;
+		return;
+	}
+	if(!(g_harsh_active & mask)){
+		g_harsh_active |= mask;
+		EVENTS_raise(type, (acceleration > 0xFFFF) ? 0xFFFF : (uint16)acceleration, now_ms);
+	}
+}
+
+static void EVENTS_raise(EVENTS_Type type, uint16 value, uint32 now_ms){
+	EVENTS_Event * event;
+
+	if(((g_queued_once & (1 << type)) && ((uint16)((uint16)(now_ms / 1000) - g_queued_s[type]) < pgm_read_word(&g_events_config->rate_limit_s)))
+			|| (g_queue_count == EVENTS_QUEUE_SIZE)){
+		g_suppressed[type]++;
+		return;
+	}
+	event = &g_queue[(g_queue_head + g_queue_count) % EVENTS_QUEUE_SIZE];
+	event->type = type;
+	event->value = value;
+	event->suppressed = g_suppressed[type];
+	g_queue_count++;
+	g_suppressed[type] = 0;
+	g_queued_once |= (1 << type);
+	g_queued_s[type] = (uint16)(now_ms / 1000);
+}
+
+/*smallest angle between two courses, 0 .. 18000*/
+static uint16 EVENTS_courseChange(uint16 from, uint16 to){
+	uint16 change = (from > to) ? (from - to) : (to - from);
+
+	return (change > 18000) ? (36000 - change) : change;
+}
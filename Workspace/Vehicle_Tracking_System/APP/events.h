@@ -0,0 +1,85 @@
+/*
+ * events.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Driving events found on the vehicle from the GPS speed and course of consecutive fixes
+ *  (integer arithmetic only):
+ *    overspeed:	over overspeed_cms for overspeed_hold_s, reported once until the speed
+ *    				drops EVENTS_SPEED_HYSTERESIS_CMS below the threshold again.
+ *    idle:			ignition on and stopped for idle_s, once per stop.
+ *    harsh acceleration / braking:	speed change between two fixes over the threshold.
+ *    harsh cornering:	lateral acceleration (speed x course rate) over the threshold,
+ *    				above EVENTS_CORNER_MIN_SPEED_CMS where the course is meaningful.
+ *  A harsh manoeuvre spread over several fixes is one event. Events wait in a small queue
+ *  for the application to send them; an event type raised again within rate_limit_s of the
+ *  last one queued is only counted, the count goes with the next one sent.
+ */
+
+#ifndef APP_EVENTS_H_
+#define APP_EVENTS_H_
+
+#include "location.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define EVENTS_QUEUE_SIZE				4
+#define EVENTS_STOP_SPEED_CMS			100		/*below 3.6 km/h the vehicle is stopped*/
+#define EVENTS_SPEED_HYSTERESIS_CMS		140		/*5 km/h*/
+#define EVENTS_CORNER_MIN_SPEED_CMS		500		/*18 km/h*/
+#define EVENTS_MAX_FIX_GAP_MS			3000	/*no rate of change across longer gaps*/
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef enum{
+	EVENTS_OVERSPEED, EVENTS_IDLE, EVENTS_HARSH_ACCELERATION, EVENTS_HARSH_BRAKING,
+	EVENTS_HARSH_CORNERING, EVENTS_TYPES
+}EVENTS_Type;
+
+/*
+ * value:		peak speed (cm/s) for overspeed, stop time (s) for idle, acceleration
+ * 				(cm/s^2) for harsh manoeuvres.
+ * suppressed:	events of the same type dropped by the rate limit before this one.
+ */
+typedef struct{
+	uint8 type;
+	uint16 value;
+	uint16 suppressed;
+}EVENTS_Event;
+
+/*
+ * Thresholds in cm/s and cm/s^2 (1 g = 981 cm/s^2), 0 disables the event.
+ * ignition_on:	NULL_PTR when the tracker is only powered with the ignition.
+ * on_event:	sends an event, returning FALSE (outbox busy) keeps it queued for a retry.
+ */
+typedef struct{
+	uint16 overspeed_cms;
+	uint16 overspeed_hold_s;
+	uint16 idle_s;
+	uint16 harsh_acceleration_cms2;
+	uint16 harsh_braking_cms2;
+	uint16 harsh_cornering_cms2;
+	uint16 rate_limit_s;
+	boolean (*ignition_on)(void);
+	boolean (*on_event)(const EVENTS_Event * event);
+}EVENTS_ConfigType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*the configuration is kept in the flash (PROGMEM)*/
+void EVENTS_init(const EVENTS_ConfigType * a_configPtr);
+
+/*Check a new fix against the previous one, call once per fix*/
+void EVENTS_update(const LOCATION_Entry * location);
+
+/*Hand the oldest queued event to on_event. Call from the main loop.*/
+void EVENTS_task(void);
+
+#endif /* APP_EVENTS_H_ */
@@ -0,0 +1,376 @@
+/*
+ * geofence.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Only the kind and the side of each zone are kept in RAM, the zone itself is read back
+ *  from the EEPROM for every fix and its box found again from it. Changes are written in the
+ *  background through the staging buffer of the EEPROM driver, the zone is not checked until
+ *  its new contents are complete.
+ */
+
+#include "geofence.h"
+#include "../MCAL/Internal_EEPROM/Internal_EEPROM.h"
+#include <avr/pgmspace.h>
+#include <util/crc16.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define GEOFENCE_UNITS_PER_CM_Q15	29470U		/*1e-7 degree of latitude per cm, 0.89935 in Q15 (rounded up)*/
+#define GEOFENCE_MIN_COS			64			/*Q15, boxes closer than 0.1 degree to a pole span every longitude*/
+#define GEOFENCE_MAX_DELTA			GEO_DEG		/*coarse check before the projection, far above GEOFENCE_MAX_OFFSET_M*/
+#define GEOFENCE_LONGITUDE_SPAN		(180L * GEO_DEG)
+#define GEOFENCE_NO_SLOT			0xFF
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef enum{
+	GEOFENCE_SIDE_UNKNOWN, GEOFENCE_SIDE_INSIDE, GEOFENCE_SIDE_OUTSIDE, GEOFENCE_SIDE_UNDECIDED
+}GEOFENCE_Side;
+
+/*
+ * RAM part of a slot. kind is GEOFENCE_EMPTY while the zone is not checked (free slot,
+ * polygon under three vertices, change being written).
+ */
+typedef struct{
+	uint8 kind;
+	uint8 side;
+	uint8 streak;		/*consecutive fixes found on the other side*/
+}GEOFENCE_Zone;
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static const GEOFENCE_ConfigType * g_geofence_config;	/*in the flash*/
+static GEOFENCE_Zone g_zones[GEOFENCE_SLOTS];
+static uint8 g_written_slot = GEOFENCE_NO_SLOT;	/*loaded again once its change is written*/
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint16 GEOFENCE_slotAddress(uint8 slot);
+static uint8 GEOFENCE_crc(const uint8 * slot_data);
+static boolean GEOFENCE_readSlot(uint8 slot, GEOFENCE_Record * record);
+static boolean GEOFENCE_stage(uint8 slot, const GEOFENCE_Record * record);
+static void GEOFENCE_loadSlot(uint8 slot);
+static sint32 GEOFENCE_latitudeUnits(sint32 metres);
+static sint32 GEOFENCE_longitudeUnits(sint32 latitude_units, sint32 latitude);
+static boolean GEOFENCE_inBox(const GEOFENCE_Record * record, const GEO_Point * position);
+static GEOFENCE_Side GEOFENCE_classify(uint8 slot, const GEO_Point * position);
+static boolean GEOFENCE_insidePolygon(const GEOFENCE_Record * record, sint32 x, sint32 y);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void GEOFENCE_init(const GEOFENCE_ConfigType * a_configPtr){
+	uint8 slot;
+
+	g_geofence_config = a_configPtr;
+	for(slot = 0; slot < GEOFENCE_SLOTS; slot++){
+		GEOFENCE_loadSlot(slot);
+	}
+}
+
+boolean GEOFENCE_setCircle(uint8 id, const GEO_Point * centre, uint16 radius_m){
+	GEOFENCE_Record record;
+
+	if((g_written_slot != GEOFENCE_NO_SLOT) || (id == 0) || (id > GEOFENCE_SLOTS) || (radius_m == 0)){
+		return FALSE;
+	}
+	memset(&record, 0, sizeof(GEOFENCE_Record));
+	record.kind = GEOFENCE_CIRCLE;
+	record.radius_m = radius_m;
+	record.anchor = *centre;
+	return GEOFENCE_stage(id - 1, &record);
+}
+
+boolean GEOFENCE_addVertex(uint8 id, const GEO_Point * vertex){
+	GEOFENCE_Record record;
+	sint32 east_cm;
+	sint32 north_cm;
+
+	if((g_written_slot != GEOFENCE_NO_SLOT) || (id == 0) || (id > GEOFENCE_SLOTS)){
+		return FALSE;
+	}
+	if(!GEOFENCE_readSlot(id - 1, &record) || (record.kind != GEOFENCE_POLYGON)){
+		memset(&record, 0, sizeof(GEOFENCE_Record));
+		record.kind = GEOFENCE_POLYGON;
+		record.vertex_count = 1;
+		record.anchor = *vertex;
+		return GEOFENCE_stage(id - 1, &record);
+	}
+	if((record.vertex_count == GEOFENCE_MAX_VERTICES)
+			|| (labs(vertex->latitude - record.anchor.latitude) > GEOFENCE_MAX_DELTA)
+			|| (labs(vertex->longitude - record.anchor.longitude) > GEOFENCE_MAX_DELTA)){
+		return FALSE;
+	}
+	GEO_offset(&record.anchor, vertex, &east_cm, &north_cm);
+	east_cm /= 100;
+	north_cm /= 100;
+	if((labs(east_cm) > GEOFENCE_MAX_OFFSET_M) || (labs(north_cm) > GEOFENCE_MAX_OFFSET_M)){
+		return FALSE;
+	}
+	record.vertices[record.vertex_count - 1][0] = (sint16)east_cm;
+	record.vertices[record.vertex_count - 1][1] = (sint16)north_cm;
+	record.vertex_count++;
+	return GEOFENCE_stage(id - 1, &record);
+}
+
+boolean GEOFENCE_remove(uint8 id){
+	GEOFENCE_Record record;
+	uint16 address;
+	uint8 * data;
+
+	if((g_written_slot != GEOFENCE_NO_SLOT) || (id == 0) || (id > GEOFENCE_SLOTS)){
+		return FALSE;
+	}
+	if(GEOFENCE_readSlot(id - 1, &record)){ /*nothing to write for a free slot*/
+		data = EEPROMINTENAL_claim();
+		if(data == NULL_PTR){
+			return FALSE;
+		}
+		address = GEOFENCE_slotAddress(id - 1) + GEOFENCE_SLOT_SIZE - 1;
+		data[0] = ~EEPROMINTENAL_readByte(address);
+		EEPROMINTENAL_commit(address, 1);
+		g_written_slot = id - 1;
+	}
+	g_zones[id - 1].kind = GEOFENCE_EMPTY;
+	return TRUE;
+}
+
+void GEOFENCE_task(void){
+	if((g_written_slot == GEOFENCE_NO_SLOT) || EEPROMINTENAL_isWriting()){
+		return;
+	}
+	GEOFENCE_loadSlot(g_written_slot);
+	g_written_slot = GEOFENCE_NO_SLOT;
+}
+
+void GEOFENCE_update(const GEO_Point * position){
+	boolean (*on_transition)(uint8 id, boolean inside) = NULL_PTR;
+	GEOFENCE_Zone * zone;
+	GEOFENCE_Side side;
+	uint8 slot;
+
+	if(g_geofence_config != NULL_PTR){
+		on_transition = pgm_read_ptr(&g_geofence_config->on_transition);
+	}
+	for(slot = 0; slot < GEOFENCE_SLOTS; slot++){
+		zone = &g_zones[slot];
+		if(zone->kind == GEOFENCE_EMPTY){
+			continue;
+		}
+		side = GEOFENCE_classify(slot, position);
+		if((side == zone->side) || (side == GEOFENCE_SIDE_UNDECIDED)){
+			zone->streak = 0;
+			continue;
+		}
+		zone->streak++;
+		if(zone->streak < GEOFENCE_CONFIRM_FIXES){
+			continue;
+		}
+		if((zone->side == GEOFENCE_SIDE_UNKNOWN) || (on_transition == NULL_PTR)
+				|| on_transition(slot + 1, side == GEOFENCE_SIDE_INSIDE)){
+			zone->side = side;
+			zone->streak = 0;
+		}
+		else{
+			zone->streak = GEOFENCE_CONFIRM_FIXES - 1; /*reported again on the next fix*/
+		}
+	}
+}
+
+static uint16 GEOFENCE_slotAddress(uint8 slot){
+	return GEOFENCE_START_ADDR + (uint16)slot * GEOFENCE_SLOT_SIZE;
+}
+
+static uint8 GEOFENCE_crc(const uint8 * slot_data){
+	uint8 crc = 0;
+	uint8 i;
+
+	for(i = 0; i < GEOFENCE_SLOT_SIZE - 1; i++){
+		crc = _crc_ibutton_update(crc, slot_data[i]);
+	}
+	return crc;
+}
+
+/*read straight into the record, its CRC found on the way (the record is garbage if FALSE)*/
+static boolean GEOFENCE_readSlot(uint8 slot, GEOFENCE_Record * record){
+	uint8 * data = (uint8 *)record;
+	uint16 address = GEOFENCE_slotAddress(slot);
+	uint8 crc = 0;
+	uint8 i;
+
+	for(i = 0; i < GEOFENCE_SLOT_SIZE - 1; i++){
+		data[i] = EEPROMINTENAL_readByte(address + i);
+		crc = _crc_ibutton_update(crc, data[i]);
+	}
+	return (EEPROMINTENAL_readByte(address + GEOFENCE_SLOT_SIZE - 1) == crc);
+}
+
+/*FALSE while the staging buffer of the EEPROM driver is taken*/
+static boolean GEOFENCE_stage(uint8 slot, const GEOFENCE_Record * record){
+	uint8 * data = EEPROMINTENAL_claim();
+
+	if(data == NULL_PTR){
+		return FALSE;
+	}
+	g_zones[slot].kind = GEOFENCE_EMPTY;
+	memcpy(data, record, sizeof(GEOFENCE_Record));
+	data[GEOFENCE_SLOT_SIZE - 1] = GEOFENCE_crc(data);
+	EEPROMINTENAL_commit(GEOFENCE_slotAddress(slot), GEOFENCE_SLOT_SIZE);
+	g_written_slot = slot;
+	return TRUE;
+}
+
+/*zone checked again from its stored contents, the zone side is found again*/
+static void GEOFENCE_loadSlot(uint8 slot){
+	GEOFENCE_Zone * zone = &g_zones[slot];
+	GEOFENCE_Record record;
+
+	zone->kind = GEOFENCE_EMPTY;
+	zone->side = GEOFENCE_SIDE_UNKNOWN;
+	zone->streak = 0;
+	if(!GEOFENCE_readSlot(slot, &record)){
+		return;
+	}
+	if((record.kind == GEOFENCE_CIRCLE) || ((record.kind == GEOFENCE_POLYGON) && (record.vertex_count >= 3))){
+		zone->kind = record.kind;
+	}
+}
+
+static sint32 GEOFENCE_latitudeUnits(sint32 metres){
+	return GEO_mulQ15(metres * 100, GEOFENCE_UNITS_PER_CM_Q15);
+}
+
+/*latitude_units (positive) of arc turned into longitude units at the given latitude*/
+static sint32 GEOFENCE_longitudeUnits(sint32 latitude_units, sint32 latitude){
+	sint32 cosine = GEO_cos(latitude);
+
+	if(cosine < GEOFENCE_MIN_COS){
+		return GEOFENCE_LONGITUDE_SPAN;
+	}
+	/*latitude_units * 32768 / cosine, split so that no product exceeds 32 bits*/
+	return ((latitude_units / cosine) << 15) + (((latitude_units % cosine) << 15) + cosine - 1) / cosine;
+}
+
+/*
+ * Box in coordinate units around the metre extent of the zone plus the margin, widened with
+ * the longitude scale of its poleward edge. Zones across the 180th meridian are not supported.
+ */
+static boolean GEOFENCE_inBox(const GEOFENCE_Record * record, const GEO_Point * position){
+	sint32 west_m = 0;
+	sint32 east_m = 0;
+	sint32 south_m = 0;
+	sint32 north_m = 0;
+	sint32 south;
+	sint32 north;
+	sint32 poleward;
+	sint32 west;
+	sint32 east;
+	uint8 i;
+
+	if(record->kind == GEOFENCE_CIRCLE){
+		west_m = -(sint32)record->radius_m;
+		east_m = record->radius_m;
+		south_m = west_m;
+		north_m = east_m;
+	}
+	else{
+		for(i = 0; i < record->vertex_count - 1; i++){
+			if(record->vertices[i][0] < west_m){
+				west_m = record->vertices[i][0];
+			}
+			if(record->vertices[i][0] > east_m){
+				east_m = record->vertices[i][0];
+			}
+			if(record->vertices[i][1] < south_m){
+				south_m = record->vertices[i][1];
+			}
+			if(record->vertices[i][1] > north_m){
+				north_m = record->vertices[i][1];
+			}
+		}
+	}
+	south = record->anchor.latitude + GEOFENCE_latitudeUnits(south_m - GEOFENCE_MARGIN_M) - 1;
+	north = record->anchor.latitude + GEOFENCE_latitudeUnits(north_m + GEOFENCE_MARGIN_M) + 1;
+	if((position->latitude < south) || (position->latitude > north)){
+		return FALSE;
+	}
+	poleward = (labs(south) > labs(north)) ? labs(south) : labs(north);
+	west = GEOFENCE_longitudeUnits(GEOFENCE_latitudeUnits(GEOFENCE_MARGIN_M - west_m) + 1, poleward);
+	east = GEOFENCE_longitudeUnits(GEOFENCE_latitudeUnits(east_m + GEOFENCE_MARGIN_M) + 1, poleward);
+	return ((west == GEOFENCE_LONGITUDE_SPAN) || (position->longitude >= record->anchor.longitude - west))
+			&& ((east == GEOFENCE_LONGITUDE_SPAN) || (position->longitude <= record->anchor.longitude + east));
+}
+
+static GEOFENCE_Side GEOFENCE_classify(uint8 slot, const GEO_Point * position){
+	GEOFENCE_Record record;
+	uint32 distance_cm;
+	uint32 radius_cm;
+	sint32 east_cm;
+	sint32 north_cm;
+
+	if(!GEOFENCE_readSlot(slot, &record) || (record.kind != g_zones[slot].kind)){
+		return GEOFENCE_SIDE_UNDECIDED;
+	}
+	if(!GEOFENCE_inBox(&record, position)){
+		return GEOFENCE_SIDE_OUTSIDE;
+	}
+	if(record.kind == GEOFENCE_CIRCLE){
+		distance_cm = GEO_equirectDistance(&record.anchor, position);
+		radius_cm = (uint32)record.radius_m * 100;
+		if(distance_cm + GEOFENCE_MARGIN_M * 100UL < radius_cm){
+			return GEOFENCE_SIDE_INSIDE;
+		}
+		return (distance_cm > radius_cm + GEOFENCE_MARGIN_M * 100UL) ? GEOFENCE_SIDE_OUTSIDE : GEOFENCE_SIDE_UNDECIDED;
+	}
+	GEO_offset(&record.anchor, position, &east_cm, &north_cm);
+	return GEOFENCE_insidePolygon(&record, east_cm / 100, north_cm / 100) ?
+			GEOFENCE_SIDE_INSIDE : GEOFENCE_SIDE_OUTSIDE;
+}
+
+/*
+ * Even-odd crossing test on the metre grid of the anchor: count the edges crossed by the
+ * ray from (x, y) towards east. Coordinates stay within GEOFENCE_MAX_OFFSET_M plus the box
+ * margin, so both products fit in 32 bits.
+ */
+static boolean GEOFENCE_insidePolygon(const GEOFENCE_Record * record, sint32 x, sint32 y){
+	sint32 xi, yi, xj, yj;
+	boolean inside = FALSE;
+	uint8 i;
+
+	/*previous vertex of the first edge is the last one*/
+	xj = record->vertices[record->vertex_count - 2][0];
+	yj = record->vertices[record->vertex_count - 2][1];
+	for(i = 0; i < record->vertex_count; i++){
+		if(i == 0){
+			xi = 0; /*the anchor*/
+			yi = 0;
+		}
+		else{
+			xi = record->vertices[i - 1][0];
+			yi = record->vertices[i - 1][1];
+		}
+		if((yi > y) != (yj > y)){
+			/*x left of the crossing point: x - xi < (y - yi) (xj - xi) / (yj - yi)*/
+			if((yj > yi) ? ((x - xi) * (yj - yi) < (y - yi) * (xj - xi))
+					: ((x - xi) * (yj - yi) > (y - yi) * (xj - xi))){
+				inside = !inside;
+			}
+		}
+		xj = xi;
+		yj = yi;
+	}
+	return inside;
+}
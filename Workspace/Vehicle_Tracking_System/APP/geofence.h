@@ -0,0 +1,103 @@
+/*
+ * geofence.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Circular and polygon zones kept in the internal EEPROM, right after the contact book.
+ *  Every new fix is classified against each zone read back from the EEPROM: a bounding box
+ *  test first, the exact test (distance to the centre, even-odd crossing test on a local metre grid) only
+ *  for the zones whose box contains the fix. The work per fix is bounded by GEOFENCE_SLOTS
+ *  box tests and GEOFENCE_SLOTS exact tests of at most GEOFENCE_MAX_VERTICES edges.
+ *
+ *  Hysteresis: the fix must be GEOFENCE_MARGIN_M beyond the circle edge to change side,
+ *  and a new side (circle or polygon) must hold for GEOFENCE_CONFIRM_FIXES fixes in a row.
+ *  The first side found after boot or after a change of the zone is taken without alert.
+ *
+ *  Slot layout (GEOFENCE_SLOT_SIZE bytes):
+ *    [0..39] GEOFENCE_Record as stored in RAM
+ *    [40]    CRC-8 (Dallas/Maxim) of the bytes above, written last
+ *  A removed zone gets its CRC inverted, like a drained journal entry.
+ */
+
+#ifndef APP_GEOFENCE_H_
+#define APP_GEOFENCE_H_
+
+#include "../Utils/geo.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * EEPROM map: 0x000-0x009 settings, 0x00A-0x099 contact book (NUM_BOOK_MAX_CONTACTS
+ * entries), 0x09A-0x18F geofences, 0x190-0x1ED GPS aiding, 0x1EE-0x1F6 CO calibration,
+ * 0x1F7-0x1FF free, 0x200- journal.
+ */
+#define GEOFENCE_START_ADDR			0x009A
+#define GEOFENCE_SLOTS				6		/*zone ids 1 .. GEOFENCE_SLOTS*/
+#define GEOFENCE_MAX_VERTICES		8
+#define GEOFENCE_SLOT_SIZE			(sizeof(GEOFENCE_Record) + 1)
+#define GEOFENCE_MAX_OFFSET_M		16000	/*polygon vertices from the first one (keeps the test in 32 bits)*/
+#define GEOFENCE_MARGIN_M			20		/*circle hysteresis band, about twice the GPS noise*/
+#define GEOFENCE_CONFIRM_FIXES		3
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef enum{
+	GEOFENCE_EMPTY, GEOFENCE_CIRCLE, GEOFENCE_POLYGON
+}GEOFENCE_Kind;
+
+/*
+ * anchor:		centre of a circle, first vertex of a polygon.
+ * vertices:	east, north offset in metres of the other polygon vertices from the anchor.
+ */
+typedef struct{
+	uint8 kind;
+	uint8 vertex_count;
+	uint16 radius_m;
+	GEO_Point anchor;
+	sint16 vertices[GEOFENCE_MAX_VERTICES - 1][2];
+}GEOFENCE_Record;
+
+/*
+ * on_transition:	called when the vehicle entered (inside = TRUE) or left zone id. Returning
+ * 					FALSE (alert could not be queued) keeps the old side, the transition
+ * 					is reported again on the next fix.
+ */
+typedef struct{
+	boolean (*on_transition)(uint8 id, boolean inside);
+}GEOFENCE_ConfigType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*Load the zones from the EEPROM (blocking read, call once at boot), configuration in PROGMEM*/
+void GEOFENCE_init(const GEOFENCE_ConfigType * a_configPtr);
+
+/*
+ * Zone changes, written in the background by the EEPROM driver (EEPROMINTENAL_task()). They
+ * return FALSE for a bad id or argument, while the previous change is still being written or
+ * while another record holds the EEPROM staging buffer.
+ */
+boolean GEOFENCE_setCircle(uint8 id, const GEO_Point * centre, uint16 radius_m);
+
+/*
+ * Append a vertex to polygon id (edges in the order received, the last vertex closes on the
+ * first one). A zone that is not a polygon is replaced by a new polygon starting at the
+ * vertex. The zone is checked from its third vertex on.
+ */
+boolean GEOFENCE_addVertex(uint8 id, const GEO_Point * vertex);
+
+boolean GEOFENCE_remove(uint8 id);
+
+/*Check a changed zone again once its change is written, never waits for the EEPROM. Call from the main loop.*/
+void GEOFENCE_task(void);
+
+/*Classify a new fix against every zone, call once per fix*/
+void GEOFENCE_update(const GEO_Point * position);
+
+#endif /* APP_GEOFENCE_H_ */
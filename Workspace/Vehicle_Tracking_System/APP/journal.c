@@ -0,0 +1,166 @@
+/*
+ * journal.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  An EEPROM byte write takes about 8.5 ms, so entries are never written from the caller:
+ *  JOURNAL_append() only stages the entry in RAM and JOURNAL_task() starts the next byte
+ *  write whenever the EEPROM is free. Releases (CRC inversion) are written before the
+ *  staged entry, so a slot is always released before it can be reused.
+ */
+
+#include "journal.h"
+#include "../MCAL/Internal_EEPROM/Internal_EEPROM.h"
+#include <util/crc16.h>
+#include <string.h>
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static uint8 g_tail = 0;						/*slot of the oldest entry*/
+static uint8 g_count = 0;
+static uint16 g_sequence = 0;					/*sequence number of the next entry*/
+static uint8 g_release_slot = 0;				/*first slot still to be released*/
+static uint8 g_release_pending = 0;
+static uint8 g_staged[JOURNAL_ENTRY_SIZE];		/*entry being written to the head slot*/
+static uint8 g_staged_index = 0;
+static boolean g_staged_busy = FALSE;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint16 JOURNAL_slotAddress(uint8 slot);
+static uint8 JOURNAL_crc(const uint8 * entry);
+static boolean JOURNAL_readEntry(uint8 slot, uint8 * entry);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * The newest valid entry gives the head, the entries before it with consecutive sequence
+ * numbers are the backlog.
+ */
+void JOURNAL_init(void){
+	uint8 entry[JOURNAL_ENTRY_SIZE];
+	uint8 slot;
+	uint8 newest = JOURNAL_SLOTS;
+	uint16 sequence;
+	uint16 newest_sequence = 0;
+
+	for(slot = 0; slot < JOURNAL_SLOTS; slot++){
+		if(JOURNAL_readEntry(slot, entry)){
+			sequence = entry[0] | ((uint16)entry[1] << 8);
+			if((newest == JOURNAL_SLOTS) || ((sint16)(sequence - newest_sequence) > 0)){
+				newest = slot;
+				newest_sequence = sequence;
+			}
+		}
+	}
+	g_count = 0;
+	if(newest == JOURNAL_SLOTS){
+		g_tail = 0;
+		g_sequence = 0;
+		return;
+	}
+	slot = newest;
+	do{
+		g_count++;
+		slot = (slot == 0) ? (JOURNAL_SLOTS - 1) : (slot - 1);
+	}while((g_count < JOURNAL_SLOTS) && JOURNAL_readEntry(slot, entry) &&
+			((uint16)(entry[0] | ((uint16)entry[1] << 8)) == (uint16)(newest_sequence - g_count)));
+	g_tail = (newest + 1 + JOURNAL_SLOTS - g_count) % JOURNAL_SLOTS;
+	g_sequence = newest_sequence + 1;
+}
+
+boolean JOURNAL_append(const TELEMETRY_Record * record){
+	if(g_staged_busy || (g_count + g_release_pending >= JOURNAL_SLOTS)){
+		return FALSE;
+	}
+	g_staged[0] = (uint8)g_sequence;
+	g_staged[1] = (uint8)(g_sequence >> 8);
+	memcpy(&g_staged[2], record, sizeof(TELEMETRY_Record));
+	g_staged[JOURNAL_ENTRY_SIZE - 1] = JOURNAL_crc(g_staged);
+	g_staged_index = 0;
+	g_staged_busy = TRUE;
+	return TRUE;
+}
+
+void JOURNAL_task(void){
+	uint16 address;
+
+	if(!EEPROMINTENAL_isReady()){
+		return;
+	}
+	if(g_release_pending > 0){
+		address = JOURNAL_slotAddress(g_release_slot) + JOURNAL_ENTRY_SIZE - 1;
+		EEPROMINTENAL_writeByte(address, ~EEPROMINTENAL_readByte(address));
+		g_release_slot = (g_release_slot + 1) % JOURNAL_SLOTS;
+		g_release_pending--;
+	}
+	else if(g_staged_busy){
+		address = JOURNAL_slotAddress((g_tail + g_count) % JOURNAL_SLOTS);
+		EEPROMINTENAL_writeByte(address + g_staged_index, g_staged[g_staged_index]);
+		g_staged_index++;
+		if(g_staged_index == JOURNAL_ENTRY_SIZE){
+			/*CRC written last: the entry becomes visible only once it is complete*/
+			g_count++;
+			g_sequence++;
+			g_staged_busy = FALSE;
+		}
+	}
+}
+
+uint8 JOURNAL_count(void){
+	return g_count;
+}
+
+boolean JOURNAL_peek(uint8 offset, TELEMETRY_Record * record){
+	uint8 entry[JOURNAL_ENTRY_SIZE];
+
+	if((offset >= g_count) || !JOURNAL_readEntry((g_tail + offset) % JOURNAL_SLOTS, entry)){
+		return FALSE;
+	}
+	memcpy(record, &entry[2], sizeof(TELEMETRY_Record));
+	return TRUE;
+}
+
+void JOURNAL_release(uint8 count){
+	if(count > g_count){
+		count = g_count;
+	}
+	if(g_release_pending == 0){
+		g_release_slot = g_tail;
+	}
+	g_release_pending += count;
+	g_tail = (g_tail + count) % JOURNAL_SLOTS;
+	g_count -= count;
+}
+
+static uint16 JOURNAL_slotAddress(uint8 slot){
+	return JOURNAL_START_ADDR + (uint16)slot * JOURNAL_ENTRY_SIZE;
+}
+
+static uint8 JOURNAL_crc(const uint8 * entry){
+	uint8 crc = 0;
+	uint8 i;
+
+	for(i = 0; i < JOURNAL_ENTRY_SIZE - 1; i++){
+		crc = _crc_ibutton_update(crc, entry[i]);
+	}
+	return crc;
+}
+
+static boolean JOURNAL_readEntry(uint8 slot, uint8 * entry){
+	uint16 address = JOURNAL_slotAddress(slot);
+	uint8 i;
+
+	for(i = 0; i < JOURNAL_ENTRY_SIZE; i++){
+		entry[i] = EEPROMINTENAL_readByte(address + i);
+	}
+	return entry[JOURNAL_ENTRY_SIZE - 1] == JOURNAL_crc(entry);
+}
@@ -0,0 +1,62 @@
+/*
+ * journal.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Store-and-forward journal: telemetry records taken while the link is down are kept in a
+ *  circular log in the internal EEPROM and drained by the telemetry module once it is back.
+ *
+ *  Entry layout (JOURNAL_ENTRY_SIZE bytes):
+ *    [0..1]  sequence number (little endian, increments on every append)
+ *    [2..]   TELEMETRY_Record as stored in RAM
+ *    [last]  CRC-8 (Dallas/Maxim) of the bytes above, written last
+ *  A drained entry is released by inverting its CRC, so the log is rebuilt at boot from
+ *  the entries that still have a valid CRC. An entry cut by a reset has a bad CRC too.
+ */
+
+#ifndef APP_JOURNAL_H_
+#define APP_JOURNAL_H_
+
+#include "telemetry.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * EEPROM map (1 KB): 0x000-0x009 settings, 0x00A-0x099 contact book (9 bytes per contact),
+ * 0x09A-0x18F geofences, 0x190-0x1ED GPS aiding, 0x1EE-0x1F6 CO calibration, 0x1F7-0x1FF free,
+ * 0x200-0x3B7 journal, 0x3B8-0x3FF free.
+ */
+#define JOURNAL_START_ADDR			0x0200
+#define JOURNAL_ENTRY_SIZE			(sizeof(TELEMETRY_Record) + 3)
+#define JOURNAL_SLOTS				22		/*about 5 minutes of track at one fix every 15s*/
+#define JOURNAL_DRAIN_INTERVAL_MS	2000	/*minimum time between two drained packets*/
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*Rebuild the log from the EEPROM contents (blocking scan, call once at boot)*/
+void JOURNAL_init(void);
+
+/*
+ * Queue a record to be written to the log. Returns FALSE if the log is full or the previous
+ * record is still being written.
+ */
+boolean JOURNAL_append(const TELEMETRY_Record * record);
+
+/*Write the queued record one byte at a time, never waits for the EEPROM. Call from the main loop.*/
+void JOURNAL_task(void);
+
+/*number of entries in the log, oldest first*/
+uint8 JOURNAL_count(void);
+
+/*Read the entry at offset from the oldest one. Returns FALSE if its CRC is bad.*/
+boolean JOURNAL_peek(uint8 offset, TELEMETRY_Record * record);
+
+/*Drop the count oldest entries once they are delivered*/
+void JOURNAL_release(uint8 count);
+
+#endif /* APP_JOURNAL_H_ */
@@ -0,0 +1,71 @@
+/*
+ * location.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ */
+
+#include "location.h"
+#include "../MCAL/Timer/systick.h"
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static const LOCATION_ConfigType * g_location_config;	/*in the flash*/
+static LOCATION_Entry g_last;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static boolean LOCATION_refresh(void);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void LOCATION_init(const LOCATION_ConfigType * a_configPtr){
+	g_location_config = a_configPtr;
+	g_last.known = FALSE;
+}
+
+void LOCATION_task(void){
+	LOCATION_refresh();
+}
+
+const LOCATION_Entry * LOCATION_getLast(void){
+	return &g_last;
+}
+
+uint32 LOCATION_getAge(void){
+	return g_last.known ? SYSTICK_elapsedMs(g_last.timestamp_ms) : LOCATION_NO_FIX_AGE;
+}
+
+const LOCATION_Entry * LOCATION_getFresh(uint32 max_age_ms){
+	uint32 start_ms = SYSTICK_getMs();
+	void (*wait_hook)(void);
+
+	if((g_location_config == NULL_PTR) || (LOCATION_getAge() <= max_age_ms)){
+		return &g_last;
+	}
+	wait_hook = pgm_read_ptr(&g_location_config->wait_hook);
+	while(!LOCATION_refresh() && (SYSTICK_elapsedMs(start_ms) < LOCATION_FIX_WAIT_MS)){
+		wait_hook();
+	}
+	return &g_last;
+}
+
+/*only valid fixes replace the cache, a fix lost in a tunnel keeps the last position*/
+static boolean LOCATION_refresh(void){
+	GPS_Fix fix;
+
+	if(!GPS_getFix(&fix) || !fix.valid){
+		return FALSE;
+	}
+	g_last.fix = fix;
+	g_last.timestamp_ms = SYSTICK_getMs();
+	g_last.known = TRUE;
+	return TRUE;
+}
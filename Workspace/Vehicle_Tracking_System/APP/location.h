@@ -0,0 +1,64 @@
+/*
+ * location.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Last known position service: the latest valid GPS fix is kept with the time it was taken,
+ *  so location requests and alerts read it in O(1). The receiver has its own line (software
+ *  UART), every valid fix it sends refreshes the cache.
+ */
+
+#ifndef APP_LOCATION_H_
+#define APP_LOCATION_H_
+
+#include "../HAL/NEO6_GPS/gps.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define LOCATION_NO_FIX_AGE		0xFFFFFFFFUL	/*age reported while no fix was ever taken*/
+#define LOCATION_FIX_WAIT_MS	2000			/*longest GPS fix period in use is one second*/
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef struct{
+	GPS_Fix fix;				/*hdop, time and fix quality included*/
+	uint32 timestamp_ms;		/*SYSTICK time the fix was read*/
+	boolean known;				/*FALSE until the first valid fix*/
+}LOCATION_Entry;
+
+/*
+ * wait_hook:	run while LOCATION_getFresh() waits for a fix, must keep the GPS parser and
+ * 				the modem going (GPS_task()). It may run the application tasks, so the caller
+ * 				must not hold a buffer they use while waiting.
+ */
+typedef struct{
+	void (*wait_hook)(void);
+}LOCATION_ConfigType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+void LOCATION_init(const LOCATION_ConfigType * a_configPtr);	/*configuration in PROGMEM*/
+
+/*Take the fix the receiver sent since the last call, never waits. Call from the main loop.*/
+void LOCATION_task(void);
+
+/*cached entry, never waits*/
+const LOCATION_Entry * LOCATION_getLast(void);
+
+/*milliseconds since the cached fix was taken, LOCATION_NO_FIX_AGE if none*/
+uint32 LOCATION_getAge(void);
+
+/*
+ * Cached entry, refreshed first only if it is older than max_age_ms (waits up to
+ * LOCATION_FIX_WAIT_MS). The cached (possibly older) entry is returned if the refresh fails.
+ */
+const LOCATION_Entry * LOCATION_getFresh(uint32 max_age_ms);
+
+#endif /* APP_LOCATION_H_ */
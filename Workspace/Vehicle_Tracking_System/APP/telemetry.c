@@ -0,0 +1,236 @@
+/*
+ * telemetry.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  One packet buffer: it is filled by TELEMETRY_addRecord(), then closed and kept until its
+ *  AT+CIPSEND / HTTP POST is delivered. Records taken while it is closed, or while the link
+ *  is down, go to the EEPROM journal (journal.h) and are sent back as full packets, at most
+ *  one every JOURNAL_DRAIN_INTERVAL_MS.
+ */
+
+#include "telemetry.h"
+#include "journal.h"
+#include "../HAL/SIM900A_GSM/gsm.h"
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static const TELEMETRY_ConfigType * g_telemetry_config;	/*in the flash*/
+static uint8 g_packet[TELEMETRY_PACKET_SIZE];
+static uint8 g_build_length = 0;			/*length of the packet being filled, 0 if none*/
+static uint32 g_build_start_ms;
+static TELEMETRY_Record g_previous;			/*reference of the next delta record*/
+static uint8 g_ready_length = 0;			/*length of the closed packet, 0 if none*/
+static boolean g_in_flight = FALSE;
+static uint8 g_ready_journaled = 0;			/*journal entries carried by the closed packet*/
+static uint32 g_drain_ms = 0;				/*time of the last packet drained from the journal*/
+static uint16 g_dropped_count = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint8 TELEMETRY_putVarint(uint8 * buffer, sint32 value);
+static uint8 TELEMETRY_putLittleEndian(uint8 * buffer, uint32 value, uint8 size);
+static boolean TELEMETRY_pack(const TELEMETRY_Record * record, boolean close_when_full);
+static boolean TELEMETRY_closePacket(void);
+static void TELEMETRY_drainJournal(void);
+static boolean TELEMETRY_linkUp(void);
+static boolean TELEMETRY_send(void);
+static void TELEMETRY_sendDone(boolean sent);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void TELEMETRY_init(const TELEMETRY_ConfigType * a_configPtr){
+	g_telemetry_config = a_configPtr;
+	JOURNAL_init();
+}
+
+/*
+ * Description :
+ * Records go to the RAM batch while the link is up. While it is down, while the batch is
+ * closed and being sent, or while older records are still in the journal, they are written
+ * to the EEPROM journal instead, so they survive a reset and are sent in order once the
+ * backlog is drained.
+ */
+boolean TELEMETRY_addRecord(const TELEMETRY_Record * record){
+	if((TELEMETRY_linkUp() && (JOURNAL_count() == 0) && TELEMETRY_pack(record, TRUE)) ||
+			JOURNAL_append(record)){
+		return TRUE;
+	}
+	/*journal full or busy, keep it in RAM while there is room*/
+	if(TELEMETRY_pack(record, TRUE)){
+		return TRUE;
+	}
+	g_dropped_count++;
+	return FALSE;
+}
+
+void TELEMETRY_task(void){
+	if(g_telemetry_config == NULL_PTR){
+		return;
+	}
+	JOURNAL_task();
+	if((g_build_length == 0) && (g_ready_length == 0) && (JOURNAL_count() > 0) && TELEMETRY_linkUp() &&
+			(SYSTICK_elapsedMs(g_drain_ms) >= JOURNAL_DRAIN_INTERVAL_MS)){
+		TELEMETRY_drainJournal();
+	}
+	if((g_build_length > 0) && ((g_packet[3] >= pgm_read_byte(&g_telemetry_config->batch_records)) ||
+			(SYSTICK_elapsedMs(g_build_start_ms) >= pgm_read_dword(&g_telemetry_config->batch_age_ms)))){
+		TELEMETRY_closePacket();
+	}
+	if((g_ready_length > 0) && !g_in_flight){
+		g_in_flight = TELEMETRY_send();
+	}
+}
+
+uint16 TELEMETRY_getDroppedCount(void){
+	return g_dropped_count;
+}
+
+/*
+ * Description :
+ * Zig-zag encode a signed delta (small magnitudes of either sign give small numbers) and
+ * write it as a base-128 varint, 7 bits per byte, MSB set on every byte but the last.
+ */
+static uint8 TELEMETRY_putVarint(uint8 * buffer, sint32 value){
+	uint32 zigzag = ((uint32)value << 1) ^ (uint32)(value >> 31);
+	uint8 length = 0;
+
+	while(zigzag >= 0x80){
+		buffer[length++] = (uint8)(zigzag | 0x80);
+		zigzag >>= 7;
+	}
+	buffer[length++] = (uint8)zigzag;
+	return length;
+}
+
+static uint8 TELEMETRY_putLittleEndian(uint8 * buffer, uint32 value, uint8 size){
+	uint8 i;
+
+	for(i = 0; i < size; i++){
+		buffer[i] = (uint8)value;
+		value >>= 8;
+	}
+	return size;
+}
+
+/*
+ * Description :
+ * Hand the packet being built over to the sender, the buffer is not filled again before
+ * the packet is delivered.
+ */
+static boolean TELEMETRY_closePacket(void){
+	if(g_ready_length > 0){
+		return FALSE;
+	}
+	g_ready_length = g_build_length;
+	g_build_length = 0;
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Encode a record into the packet being built. When it does not fit, the packet is closed
+ * if close_when_full is set. The record is left out (FALSE) when it does not fit or while
+ * the buffer holds a closed packet.
+ */
+static boolean TELEMETRY_pack(const TELEMETRY_Record * record, boolean close_when_full){
+	uint8 encoded[TELEMETRY_MAX_RECORD_SIZE];
+	uint8 length = 0;
+	uint8 * packet = g_packet;
+
+	if(g_ready_length > 0){
+		return FALSE;
+	}
+	if(g_build_length > 0){
+		length += TELEMETRY_putVarint(&encoded[length], (sint32)(record->timestamp - g_previous.timestamp));
+		length += TELEMETRY_putVarint(&encoded[length], record->latitude - g_previous.latitude);
+		length += TELEMETRY_putVarint(&encoded[length], record->longitude - g_previous.longitude);
+		length += TELEMETRY_putVarint(&encoded[length], (sint32)record->speed - g_previous.speed);
+		length += TELEMETRY_putVarint(&encoded[length], (sint32)record->co_ppm - g_previous.co_ppm);
+		encoded[length++] = record->flags;
+		if(g_build_length + length > TELEMETRY_PACKET_SIZE){
+			if(close_when_full){
+				TELEMETRY_closePacket();
+			}
+			return FALSE;
+		}
+	}
+
+	if(g_build_length == 0){
+		/*new packet: header and absolute first record*/
+		packet[0] = TELEMETRY_PACKET_VERSION;
+		g_build_length = 1;
+		g_build_length += TELEMETRY_putLittleEndian(&packet[g_build_length], TELEMETRY_UNIT_ID, 2);
+		packet[g_build_length++] = 0;
+		g_build_length += TELEMETRY_putLittleEndian(&packet[g_build_length], record->timestamp, 4);
+		g_build_length += TELEMETRY_putLittleEndian(&packet[g_build_length], (uint32)record->latitude, 4);
+		g_build_length += TELEMETRY_putLittleEndian(&packet[g_build_length], (uint32)record->longitude, 4);
+		g_build_length += TELEMETRY_putLittleEndian(&packet[g_build_length], record->speed, 2);
+		g_build_length += TELEMETRY_putLittleEndian(&packet[g_build_length], record->co_ppm, 2);
+		packet[g_build_length++] = record->flags;
+		g_build_start_ms = SYSTICK_getMs();
+	}
+	else{
+		memcpy(&packet[g_build_length], encoded, length);
+		g_build_length += length;
+	}
+	packet[3]++;
+	g_previous = *record;
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Fill a whole packet with the oldest journal entries and close it. The entries are only
+ * released from the journal once the packet is delivered.
+ */
+static void TELEMETRY_drainJournal(void){
+	TELEMETRY_Record record;
+	uint8 count = 0;
+
+	while((count < JOURNAL_count()) && JOURNAL_peek(count, &record) && TELEMETRY_pack(&record, FALSE)){
+		count++;
+	}
+	if(count == 0){
+		JOURNAL_release(1); /*bad CRC, skip the entry*/
+		g_dropped_count++;
+		return;
+	}
+	TELEMETRY_closePacket();
+	g_ready_journaled = count;
+	g_drain_ms = SYSTICK_getMs();
+}
+
+static boolean TELEMETRY_linkUp(void){
+	if(g_telemetry_config == NULL_PTR){
+		return FALSE;
+	}
+	if(pgm_read_byte(&g_telemetry_config->transport) == TELEMETRY_OVER_HTTP){
+		return HTTP_isReady() || g_in_flight;
+	}
+	return GPRS_isConnected();
+}
+
+static boolean TELEMETRY_send(void){
+	if(pgm_read_byte(&g_telemetry_config->transport) == TELEMETRY_OVER_HTTP){
+		return HTTP_isReady() && HTTP_post(g_packet, g_ready_length, TELEMETRY_sendDone);
+	}
+	return GPRS_isConnected() && GPRS_send(g_packet, g_ready_length, TELEMETRY_sendDone);
+}
+
+static void TELEMETRY_sendDone(boolean sent){
+	g_in_flight = FALSE;
+	if(sent){
+		g_ready_length = 0; /*else kept and sent again once the link is back*/
+		JOURNAL_release(g_ready_journaled);
+		g_ready_journaled = 0;
+	}
+}
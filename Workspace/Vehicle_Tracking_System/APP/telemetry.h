@@ -0,0 +1,91 @@
+/*
+ * telemetry.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Compact binary position reports batched over the GPRS socket or posted as the body of an
+ *  HTTP request (one packet per AT+CIPSEND / POST).
+ *
+ *  Packet layout (multi-byte fields little endian):
+ *    [0]     TELEMETRY_PACKET_VERSION
+ *    [1..2]  unit id
+ *    [3]     number of records
+ *    first record, absolute (17 bytes):
+ *            timestamp u32, latitude s32, longitude s32, speed u16, co_ppm u16, flags u8
+ *    following records, delta to the previous one:
+ *            zig-zag varints of d(timestamp), d(latitude), d(longitude), d(speed), d(co_ppm),
+ *            then flags u8
+ *  A fix every 10-30s on the road typically costs 8-11 bytes instead of 17.
+ */
+
+#ifndef APP_TELEMETRY_H_
+#define APP_TELEMETRY_H_
+
+#include "../Utils/std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define TELEMETRY_PACKET_VERSION	0x01
+#define TELEMETRY_UNIT_ID			0x0001	/*identifies the vehicle on the server*/
+#define TELEMETRY_PACKET_SIZE		64		/*bytes per packet (one AT+CIPSEND / HTTP POST)*/
+#define TELEMETRY_HEADER_SIZE		4
+#define TELEMETRY_MAX_RECORD_SIZE	22		/*worst case delta record: 3 x 5 + 2 x 3 varint bytes + flags*/
+
+/*record flags*/
+#define TELEMETRY_FLAG_FIX_VALID		0x01
+#define TELEMETRY_FLAG_CO_ALARM			0x02
+#define TELEMETRY_FLAG_EMERGENCY		0x04
+#define TELEMETRY_FLAG_FIRST_FIX		0x08	/*once per boot, not a track point: timestamp is the time to first fix (s)*/
+#define TELEMETRY_FLAG_POSITION_AIDED	0x10	/*the receiver was given the saved position at boot*/
+#define TELEMETRY_FLAG_TIME_AIDED		0x20	/*and the modem time*/
+#define TELEMETRY_FLAG_BOOT_TIME		0x40	/*timestamp in seconds since boot, no GPS time yet*/
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef enum{
+	TELEMETRY_OVER_TCP, TELEMETRY_OVER_HTTP
+}TELEMETRY_Transport;
+
+/*
+ * A batch is sent once batch_records fixes are in it or once the oldest one is batch_age_ms
+ * old, whichever comes first (a full packet is always sent). Fewer, larger batches save
+ * airtime and per-request overhead, mostly with HTTP where every POST costs two commands.
+ */
+typedef struct{
+	TELEMETRY_Transport transport;
+	uint8 batch_records;
+	uint32 batch_age_ms;
+}TELEMETRY_ConfigType;
+
+typedef struct{
+	uint32 timestamp;		/*Unix time (UTC), seconds since boot with TELEMETRY_FLAG_BOOT_TIME*/
+	sint32 latitude;		/*1e-7 degrees*/
+	sint32 longitude;		/*1e-7 degrees*/
+	uint16 speed;			/*cm/s*/
+	uint16 co_ppm;
+	uint8 flags;
+}TELEMETRY_Record;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+void TELEMETRY_init(const TELEMETRY_ConfigType * a_configPtr);	/*configuration in PROGMEM*/
+
+/*
+ * Encode one record into the batch being built, or journal it. Returns FALSE if the record
+ * was dropped because the journal could not take it while the packet buffer was closed.
+ */
+boolean TELEMETRY_addRecord(const TELEMETRY_Record * record);
+
+/*Hand the batch to the selected link when it is due. Call from the main loop.*/
+void TELEMETRY_task(void);
+
+uint16 TELEMETRY_getDroppedCount(void);
+
+#endif /* APP_TELEMETRY_H_ */
@@ -0,0 +1,215 @@
+/*
+ * track.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  g_window[0] is always the last fix passed on, the simplified track starts from it.
+ *  Douglas-Peucker runs without recursion: the buffered fixes are turned into cm offsets
+ *  from g_window[0] once, then every kept span is split at its farthest fix until no fix
+ *  is farther than the tolerance (at most TRACK_WINDOW_SIZE passes).
+ */
+
+#include "track.h"
+#include <avr/pgmspace.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define TRACK_SCALE_LIMIT		(1L << 14)		/*offsets are scaled below it so that products fit in 32 bits*/
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static const TRACK_ConfigType * g_track_config;	/*in the flash*/
+static TRACK_Point g_window[TRACK_WINDOW_SIZE];
+static uint8 g_count = 0;						/*buffered fixes, g_window[0] included*/
+static boolean g_stopped = FALSE;				/*state of the previous fix*/
+static TRACK_Stats g_stats;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static boolean TRACK_mustKeep(const TRACK_Point * fix);
+static uint16 TRACK_courseChange(uint16 from, uint16 to);
+static void TRACK_emit(const TRACK_Point * point);
+static void TRACK_simplify(void);
+static uint32 TRACK_segmentDistance(sint32 ax, sint32 ay, sint32 bx, sint32 by, sint32 px, sint32 py);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void TRACK_init(const TRACK_ConfigType * a_configPtr){
+	g_track_config = a_configPtr;
+	g_count = 0;
+	g_stopped = FALSE;
+	g_stats.fixes = 0;
+	g_stats.points = 0;
+}
+
+void TRACK_addFix(const TRACK_Point * fix){
+	const TRACK_Point * previous;
+	boolean keep;
+
+	g_stats.fixes++;
+	if(g_count == 0){
+		g_window[0] = *fix;
+		g_count = 1;
+		g_stopped = (fix->speed < TRACK_STOP_SPEED_CMS);
+		TRACK_emit(fix);
+		return;
+	}
+	keep = TRACK_mustKeep(fix);
+	previous = &g_window[g_count - 1];
+	if(!keep && (GEO_equirectDistance(&previous->position, &fix->position) < pgm_read_word(&g_track_config->tolerance_m) * 100UL)){
+		return; /*dead-band*/
+	}
+	if(pgm_read_byte(&g_track_config->mode) == TRACK_MODE_DEADBAND){
+		if(keep || ((fix->speed >= TRACK_STOP_SPEED_CMS) &&
+				(TRACK_courseChange(g_window[0].course, fix->course) >= pgm_read_word(&g_track_config->heading_change_cdeg)))){
+			g_window[0] = *fix;
+			TRACK_emit(fix);
+		}
+		return;
+	}
+	g_window[g_count++] = *fix;
+	if(keep || (g_count == TRACK_WINDOW_SIZE)){
+		TRACK_simplify();
+	}
+}
+
+void TRACK_flush(void){
+	if(g_count > 1){
+		TRACK_simplify();
+	}
+}
+
+void TRACK_getStats(TRACK_Stats * stats){
+	*stats = g_stats;
+}
+
+/*stop, departure, speed change or report due since the last kept fix*/
+static boolean TRACK_mustKeep(const TRACK_Point * fix){
+	boolean stopped = (fix->speed < TRACK_STOP_SPEED_CMS);
+	boolean keep = (stopped != g_stopped);
+	uint16 speed_change = (fix->speed > g_window[0].speed) ?
+			(fix->speed - g_window[0].speed) : (g_window[0].speed - fix->speed);
+	uint16 speed_change_cms = pgm_read_word(&g_track_config->speed_change_cms);
+
+	g_stopped = stopped;
+	if((speed_change_cms > 0) && (speed_change >= speed_change_cms)){
+		keep = TRUE;
+	}
+	if((fix->timestamp_ms - g_window[0].timestamp_ms) >= pgm_read_word(&g_track_config->max_interval_s) * 1000UL){
+		keep = TRUE;
+	}
+	return keep;
+}
+
+/*smallest angle between two courses, 0 .. 18000*/
+static uint16 TRACK_courseChange(uint16 from, uint16 to){
+	uint16 change = (from > to) ? (from - to) : (to - from);
+
+	return (change > 18000) ? (36000 - change) : change;
+}
+
+static void TRACK_emit(const TRACK_Point * point){
+	void (*on_point)(const TRACK_Point * point) = pgm_read_ptr(&g_track_config->on_point);
+
+	g_stats.points++;
+	if(on_point != NULL_PTR){
+		on_point(point);
+	}
+}
+
+/*
+ * Description :
+ * Douglas-Peucker over the buffered fixes: g_window[0] was already passed on, the last
+ * buffered fix is always kept and becomes g_window[0]. The offsets are taken from the
+ * start of each span as they are needed, none are kept on the stack.
+ */
+static void TRACK_simplify(void){
+	sint32 end_x;
+	sint32 end_y;
+	sint32 x;
+	sint32 y;
+	uint16 kept = 1 | (1U << (g_count - 1));
+	uint32 tolerance_cm = pgm_read_word(&g_track_config->tolerance_m) * 100UL;
+	uint32 distance;
+	uint32 farthest_distance;
+	uint8 farthest;
+	uint8 start;
+	uint8 end;
+	uint8 i;
+	boolean split;
+
+	do{
+		split = FALSE;
+		for(start = 0; start < g_count - 1; start = end){
+			end = start + 1;
+			while(!(kept & (1U << end))){
+				end++;
+			}
+			farthest_distance = tolerance_cm;
+			farthest = 0;
+			GEO_offset(&g_window[start].position, &g_window[end].position, &end_x, &end_y);
+			for(i = start + 1; i < end; i++){
+				GEO_offset(&g_window[start].position, &g_window[i].position, &x, &y);
+				distance = TRACK_segmentDistance(0, 0, end_x, end_y, x, y);
+				if(distance > farthest_distance){
+					farthest_distance = distance;
+					farthest = i;
+				}
+			}
+			if(farthest != 0){
+				kept |= (1U << farthest);
+				split = TRUE;
+			}
+		}
+	}while(split);
+	for(i = 1; i < g_count; i++){
+		if(kept & (1U << i)){
+			TRACK_emit(&g_window[i]);
+		}
+	}
+	g_window[0] = g_window[g_count - 1];
+	g_count = 1;
+}
+
+/*
+ * Distance in cm from p to the segment ab (to the nearest end beyond them). The offsets
+ * are halved together until they are below TRACK_SCALE_LIMIT, which costs at most 2^n cm
+ * of resolution on spans over 164 m.
+ */
+static uint32 TRACK_segmentDistance(sint32 ax, sint32 ay, sint32 bx, sint32 by, sint32 px, sint32 py){
+	sint32 abx = bx - ax;
+	sint32 aby = by - ay;
+	sint32 apx = px - ax;
+	sint32 apy = py - ay;
+	sint32 dot;
+	sint32 length_square;
+	uint8 shift = 0;
+
+	while((labs(abx) >= TRACK_SCALE_LIMIT) || (labs(aby) >= TRACK_SCALE_LIMIT) ||
+			(labs(apx) >= TRACK_SCALE_LIMIT) || (labs(apy) >= TRACK_SCALE_LIMIT)){
+		abx /= 2;
+		aby /= 2;
+		apx /= 2;
+		apy /= 2;
+		shift++;
+	}
+	dot = abx * apx + aby * apy;
+	length_square = abx * abx + aby * aby;
+	if((dot <= 0) || (length_square == 0)){
+		return GEO_hypot(apx, apy) << shift;
+	}
+	if(dot >= length_square){
+		return GEO_hypot(apx - abx, apy - aby) << shift;
+	}
+	return ((uint32)labs(abx * apy - aby * apx) / GEO_hypot(abx, aby)) << shift;
+}
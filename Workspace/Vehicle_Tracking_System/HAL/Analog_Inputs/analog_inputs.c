@@ -0,0 +1,55 @@
+ /******************************************************************************
+ *
+ * [FILE NAME]:     analog_inputs.c
+ *
+ * [AUTHOR]:        Omar Amr
+ *
+ * [DATE]:          18-10-2026
+ *
+ * [Description]:   Source file for the vehicle battery, board supply and auxiliary inputs
+ *
+ *******************************************************************************/
+
+#include "../../MCAL/GPIO/gpio.h"
+#include "analog_inputs.h"
+#include <avr/pgmspace.h>
+
+static const AIN_ConfigType * g_ain_config = NULL_PTR;		/*in the flash*/
+
+void AIN_init(const AIN_ConfigType * a_configPtr)
+{
+	const ADC_ChannelConfigType * adc_channel;
+	uint8 i;
+
+	g_ain_config = a_configPtr;
+	for(i = 0; i < AIN_INPUTS; i++){
+		adc_channel = pgm_read_ptr(&a_configPtr->inputs[i].adc_channel);
+		if(adc_channel != NULL_PTR){
+			GPIO_setupPinDirection(PORTA_ID, pgm_read_byte(&adc_channel->channel), PIN_INPUT);
+		}
+	}
+}
+
+/*
+ * The result has 10 + oversampling_shift - decimation_shift bits, its full scale is
+ * 2^bits codes (a 16-bit result times a 16-bit full scale fits 32 bits).
+ */
+boolean AIN_readMillivolts(AIN_Input input, uint16 * millivolts)
+{
+	const AIN_InputConfigType * config;
+	const ADC_ChannelConfigType * adc_channel;
+	uint16 result;
+	uint8 bits;
+
+	if((g_ain_config == NULL_PTR) || (input >= AIN_INPUTS)){
+		return FALSE;
+	}
+	config = &g_ain_config->inputs[input];
+	adc_channel = pgm_read_ptr(&config->adc_channel);
+	if((adc_channel == NULL_PTR) || !ADC_getSample(pgm_read_byte(&adc_channel->channel), &result)){
+		return FALSE;
+	}
+	bits = 10 + pgm_read_byte(&adc_channel->oversampling_shift) - pgm_read_byte(&adc_channel->decimation_shift);
+	*millivolts = (uint16)(((uint32)result * pgm_read_word(&config->full_scale_mv)) >> bits);
+	return TRUE;
+}
@@ -0,0 +1,55 @@
+ /******************************************************************************
+ *
+ * [FILE NAME]:     analog_inputs.h
+ *
+ * [AUTHOR]:        Omar Amr
+ *
+ * [DATE]:          18-10-2026
+ *
+ * [Description]:   Header file for the vehicle battery, board supply and auxiliary inputs.
+ *                  The inputs are channels of the ADC background sampling (ADC_startSampling),
+ *                  this driver scales their results to millivolts.
+ *
+ *******************************************************************************/
+
+#ifndef ANALOG_INPUTS_H_
+#define ANALOG_INPUTS_H_
+
+#include "../../MCAL/ADC/adc.h"
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef enum{
+	AIN_BATTERY, AIN_SUPPLY, AIN_AUXILIARY, AIN_INPUTS
+}AIN_Input;
+
+/*
+ * One input: its channel in the ADC sampling list and the voltage at its terminal that gives
+ * the ADC full scale (reference x divider ratio), e.g. 2.56 V behind a 10:1 divider is 25600.
+ */
+typedef struct{
+	const ADC_ChannelConfigType * adc_channel;
+	uint16 full_scale_mv;
+}AIN_InputConfigType;
+
+typedef struct{
+	AIN_InputConfigType inputs[AIN_INPUTS];		/*adc_channel NULL_PTR: input not fitted*/
+}AIN_ConfigType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*the configuration is read from the flash (PROGMEM), like the ADC sampling list it points in*/
+void AIN_init(const AIN_ConfigType * a_configPtr);
+
+/*
+ * Latest filtered voltage of an input, never waits.
+ * Returns FALSE if the input is not fitted or the ADC has no result for it yet.
+ */
+boolean AIN_readMillivolts(AIN_Input input, uint16 * millivolts);
+
+
+#endif /* ANALOG_INPUTS_H_ */
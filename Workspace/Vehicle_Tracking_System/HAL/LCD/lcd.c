@@ -125,6 +125,17 @@ void LCD_displayString(const uint8 * strConst){
 	}
 }
 
+/*
+ * Description :
+ * Display the required string from the flash (PSTR()) on the screen
+ */
+void LCD_displayString_P(PGM_P strConst){
+	uint8 data;
+	while((data = pgm_read_byte(strConst++)) != '\0'){
+		LCD_displayCharacter(data);
+	}
+}
+
 /*
  * Description :
  * write the required string on the screen with delay effect
@@ -172,6 +183,15 @@ void LCD_displayStringRowColumn(uint8 row, uint8 col, const uint8 * str){
 	LCD_displayString(str);
 }
 
+/*
+ * Description :
+ * Display the required string from the flash (PSTR()) in a specified row and column index on the screen
+ */
+void LCD_displayStringRowColumn_P(uint8 row, uint8 col, PGM_P str){
+	LCD_moveCursor(row, col); /* go to to the required LCD position */
+	LCD_displayString_P(str);
+}
+
 /*
  * Description :
  * Display the required decimal value on the screen
@@ -15,6 +15,7 @@
 
 #include "../../Utils/std_types.h"
 #include "../../Utils/common_macros.h"
+#include <avr/pgmspace.h>
 
 /*******************************************************************************
  *                                Definitions                                  *
@@ -107,6 +108,12 @@ void LCD_displayCharacter(uint8 Data);
  */
 void LCD_displayString(const uint8 * strConst);
 
+/*
+ * Description :
+ * Display the required string from the flash (PSTR()) on the screen
+ */
+void LCD_displayString_P(PGM_P strConst);
+
 /*
  * Description :
  * write the required string on the screen with delay effect
@@ -125,6 +132,12 @@ void LCD_moveCursor(uint8 row, uint8 col);
  */
 void LCD_displayStringRowColumn(uint8 row, uint8 col, const uint8 * str);
 
+/*
+ * Description :
+ * Display the required string from the flash (PSTR()) in a specified row and column index on the screen
+ */
+void LCD_displayStringRowColumn_P(uint8 row, uint8 col, PGM_P str);
+
 /*
  * Description :
  * Display the required decimal value on the screen
@@ -0,0 +1,95 @@
+/*
+ * gps.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ */
+
+#include "gps.h"
+#include "nmea.h"
+#include "ubx.h"
+#include "../../MCAL/SW_UART/sw_uart.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static GPS_Protocol g_protocol = GPS_PROTOCOL_NMEA;
+static GPS_Fix g_fix;							/*written by the parsers*/
+static volatile boolean g_fix_updated = FALSE;
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void GPS_init(const GPS_ConfigType * a_configPtr){
+	g_protocol = pgm_read_byte(&a_configPtr->protocol);
+	if(g_protocol == GPS_PROTOCOL_UBX){
+		UBX_configure(pgm_read_word(&a_configPtr->fix_period_ms));
+	}
+}
+
+void GPS_sendAiding(const GPS_Aiding * aiding){
+	UBX_sendAiding(aiding);
+}
+
+void GPS_sendHealth(const uint8 * health){
+	UBX_sendHealth(health);
+}
+
+boolean GPS_requestHealth(uint8 * health){
+	if(g_protocol != GPS_PROTOCOL_UBX){
+		return FALSE;
+	}
+	UBX_requestHealth(health);
+	return TRUE;
+}
+
+boolean GPS_healthReceived(void){
+	return UBX_healthReceived();
+}
+
+uint32 GPS_getTtff(void){
+	return (g_protocol == GPS_PROTOCOL_UBX) ? UBX_getTtff() : 0;
+}
+
+void GPS_task(void){
+	uint8 data;
+
+	while(SWUART_readByte(&data)){
+		GPS_parseByte(data);
+	}
+}
+
+void GPS_parseByte(uint8 data){
+	if(g_protocol == GPS_PROTOCOL_UBX){
+		UBX_parseByte(data);
+	}
+	else{
+		NMEA_parseByte(data);
+	}
+}
+
+boolean GPS_getFix(GPS_Fix * fix){
+	boolean updated;
+	uint8 sreg = SREG;
+
+	cli(); /*GPS_parseByte() may also be given the bytes in ISR context*/
+	*fix = g_fix;
+	updated = g_fix_updated;
+	g_fix_updated = FALSE;
+	SREG = sreg;
+	return updated;
+}
+
+void GPS_getPublishedFix(GPS_Fix * fix){
+	*fix = g_fix;
+}
+
+void GPS_publishFix(const GPS_Fix * fix){
+	g_fix = *fix;
+	g_fix_updated = TRUE;
+}
@@ -0,0 +1,118 @@
+/*
+ * gps.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  NEO-6 GPS front end: one fix type shared by the NMEA (nmea.h) and UBX (ubx.h) parsers,
+ *  the protocol selection and the fix published to the application.
+ *  The receiver output is read on its own line by the software UART (sw_uart.h), the
+ *  hardware USART only reaches the receiver through the relay to send it commands.
+ */
+
+#ifndef GPS_H_
+#define GPS_H_
+
+#include "../../Utils/std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define GPS_HEALTH_SIZE			72		/*satellite health, UTC and ionosphere parameters (UBX AID-HUI)*/
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef struct{
+	sint32 latitude;		/*1e-7 degrees, north positive*/
+	sint32 longitude;		/*1e-7 degrees, east positive*/
+	sint32 altitude;		/*cm above mean sea level*/
+	uint16 speed;			/*cm/s over ground*/
+	uint16 course;			/*1e-2 degrees from true north*/
+	uint16 hdop;			/*1e-2 (PDOP in UBX mode, an upper bound of it)*/
+	uint8 hour;				/*UTC*/
+	uint8 minute;
+	uint8 second;
+	uint8 day;
+	uint8 month;
+	uint8 year;				/*years since 2000*/
+	uint8 fix_quality;		/*0 no fix, 1 GPS, 2 DGPS*/
+	uint8 satellites;		/*used in the fix*/
+	boolean valid;
+}GPS_Fix;
+
+typedef enum{
+	GPS_PROTOCOL_NMEA, GPS_PROTOCOL_UBX
+}GPS_Protocol;
+
+/*
+ * protocol:		NMEA leaves the receiver in its factory configuration, UBX reconfigures it
+ * 					at boot to send the binary navigation messages only.
+ * fix_period_ms:	time between two fixes (UBX only, 200 ms at most at 9600 baud).
+ */
+typedef struct{
+	GPS_Protocol protocol;
+	uint16 fix_period_ms;
+}GPS_ConfigType;
+
+/*
+ * Aiding data for a faster first fix (UBX AID-INI, accepted by the receiver in both
+ * protocols): the last known position and, if time_valid, the current GPS time.
+ */
+typedef struct{
+	sint32 latitude;		/*1e-7 degrees*/
+	sint32 longitude;		/*1e-7 degrees*/
+	sint32 altitude;		/*cm above mean sea level*/
+	uint32 position_acc_cm;
+	uint32 time_of_week_ms;
+	uint32 time_acc_ms;
+	uint16 week;			/*GPS weeks since 6 January 1980, not rolled over*/
+	boolean time_valid;
+}GPS_Aiding;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Select the protocol and configure the receiver (configuration in the flash, PROGMEM).
+ * The USART must be routed to the GPS.
+ */
+void GPS_init(const GPS_ConfigType * a_configPtr);
+
+/*
+ * Aiding, the frames are queued on the USART which must be routed to the GPS until they are
+ * sent (like GPS_init()):
+ * GPS_sendAiding() gives the receiver its initial position and time.
+ * GPS_sendHealth() sends back a block saved from GPS_requestHealth().
+ * GPS_requestHealth() polls the receiver for its GPS_HEALTH_SIZE byte health/UTC/ionosphere
+ * block, copied into health when the reply arrives (GPS_healthReceived()), NULL_PTR cancels
+ * the request. UBX protocol only, returns FALSE in NMEA mode where the reply is not parsed.
+ */
+void GPS_sendAiding(const GPS_Aiding * aiding);
+void GPS_sendHealth(const uint8 * health);
+boolean GPS_requestHealth(uint8 * health);
+boolean GPS_healthReceived(void);
+
+/*time to first fix measured by the receiver since power up (ms), 0 until known (UBX only)*/
+uint32 GPS_getTtff(void);
+
+/*Parse the bytes received by the software UART. Call from the main loop.*/
+void GPS_task(void);
+
+/*Feed one received byte to the parser of the selected protocol*/
+void GPS_parseByte(uint8 data);
+
+/*Copy the latest fix. Returns TRUE if it was updated since the last call.*/
+boolean GPS_getFix(GPS_Fix * fix);
+
+/*
+ * For the protocol parsers: read the published fix (the fields a message does not carry
+ * are kept) and publish the updated one.
+ */
+void GPS_getPublishedFix(GPS_Fix * fix);
+void GPS_publishFix(const GPS_Fix * fix);
+
+#endif /* GPS_H_ */
@@ -0,0 +1,298 @@
+/*
+ * nmea.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  One state machine step per byte. Numeric fields are accumulated as integers while the
+ *  digits arrive (decimals kept up to NMEA_FRACTION_DIGITS) and converted once at the
+ *  closing ',' or '*'. The sentence is decoded into a working copy of the fix, which only
+ *  replaces the published fix (gps.h) once the checksum matches.
+ */
+
+#include "nmea.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef enum{
+	NMEA_IDLE, NMEA_BODY, NMEA_CHECKSUM_HIGH, NMEA_CHECKSUM_LOW
+}NMEA_State;
+
+typedef enum{
+	NMEA_UNKNOWN, NMEA_RMC, NMEA_GGA
+}NMEA_Sentence;
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define NMEA_TYPE_CODE(a, b, c)		(((uint32)(a) << 16) | ((uint32)(b) << 8) | (uint32)(c))
+#define NMEA_MAX_FIELD_LENGTH		15		/*longer fields mean a corrupted sentence*/
+#define NMEA_MINUTES_SCALE			10000000UL	/*ddmm.mmmmm scaled by 1e5: minutes take 7 digits*/
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+/*parser state, only touched by NMEA_parseByte()*/
+static NMEA_State g_state = NMEA_IDLE;
+static NMEA_Sentence g_sentence;
+static uint8 g_field;						/*index of the field being received, 0 = address*/
+static uint8 g_checksum;					/*XOR of the bytes between '$' and '*'*/
+static uint8 g_received_checksum;
+static uint32 g_value;						/*digits of the current field, decimal point removed*/
+static uint8 g_fraction;					/*decimals in g_value*/
+static boolean g_dot;
+static boolean g_negative;
+static uint8 g_length;
+static uint8 g_first;						/*first character of the current field*/
+static GPS_Fix g_work;
+static volatile uint16 g_checksum_errors = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void NMEA_startField(void);
+static void NMEA_addChar(uint8 data);
+static void NMEA_endField(void);
+static uint32 NMEA_fixedValue(void);
+static uint32 NMEA_integerValue(void);
+static sint32 NMEA_toDegrees(uint32 value);
+static uint8 NMEA_hexValue(uint8 data);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void NMEA_parseByte(uint8 data){
+	if(data == '$'){
+		g_state = NMEA_BODY;
+		g_sentence = NMEA_UNKNOWN;
+		g_field = 0;
+		g_checksum = 0;
+		GPS_getPublishedFix(&g_work);
+		NMEA_startField();
+		return;
+	}
+
+	switch(g_state){
+	case NMEA_BODY:
+		if(data == '*'){
+			NMEA_endField();
+			g_state = NMEA_CHECKSUM_HIGH;
+		}
+		else if((data == '\r') || (data == '\n') || (g_length >= NMEA_MAX_FIELD_LENGTH)){
+			g_state = NMEA_IDLE; /*truncated or corrupted, wait for the next '$'*/
+		}
+		else{
+			g_checksum ^= data;
+			if(data == ','){
+				NMEA_endField();
+				g_field++;
+				NMEA_startField();
+			}
+			else{
+				NMEA_addChar(data);
+			}
+		}
+		break;
+	case NMEA_CHECKSUM_HIGH:
+		g_received_checksum = NMEA_hexValue(data) << 4;
+		g_state = NMEA_CHECKSUM_LOW;
+		break;
+	case NMEA_CHECKSUM_LOW:
+		g_received_checksum |= NMEA_hexValue(data);
+		if((g_received_checksum != g_checksum) || (NMEA_hexValue(data) > 0x0F)){
+			g_checksum_errors++;
+		}
+		else if(g_sentence != NMEA_UNKNOWN){
+			GPS_publishFix(&g_work);
+		}
+		g_state = NMEA_IDLE;
+		break;
+	default:
+		break;
+	}
+}
+
+uint16 NMEA_getChecksumErrors(void){
+	uint16 errors;
+	uint8 sreg = SREG;
+
+	cli();
+	errors = g_checksum_errors;
+	SREG = sreg;
+	return errors;
+}
+
+static void NMEA_startField(void){
+	g_value = 0;
+	g_fraction = 0;
+	g_dot = FALSE;
+	g_negative = FALSE;
+	g_length = 0;
+	g_first = 0;
+}
+
+static void NMEA_addChar(uint8 data){
+	g_length++;
+	if(g_field == 0){
+		/*"GPRMC", "GNGGA"...: the talker is ignored, the last three letters give the type*/
+		if(g_length >= 3){
+			g_value = (g_value << 8) | data;
+		}
+		return;
+	}
+	if(g_length == 1){
+		g_first = data;
+	}
+	if((data >= '0') && (data <= '9')){
+		if(!g_dot){
+			g_value = g_value * 10 + (data - '0');
+		}
+		else if(g_fraction < NMEA_FRACTION_DIGITS){
+			g_value = g_value * 10 + (data - '0');
+			g_fraction++;
+		}
+	}
+	else if(data == '.'){
+		g_dot = TRUE;
+	}
+	else if(data == '-'){
+		g_negative = TRUE;
+	}
+}
+
+/*
+ * Description :
+ * Store the field that just ended into the working fix.
+ *   RMC: 1 time, 2 status, 3 lat, 4 N/S, 5 lon, 6 E/W, 7 speed (knots), 8 course, 9 date
+ *   GGA: 1 time, 2 lat, 3 N/S, 4 lon, 5 E/W, 6 quality, 7 satellites, 8 HDOP, 9 altitude
+ * GGA fields from 2 on are handled as field + 1. Empty fields keep the previous value.
+ */
+static void NMEA_endField(void){
+	uint8 field = g_field;
+	uint32 value;
+
+	if(field == 0){
+		if(g_value == NMEA_TYPE_CODE('R', 'M', 'C')){
+			g_sentence = NMEA_RMC;
+		}
+		else if(g_value == NMEA_TYPE_CODE('G', 'G', 'A')){
+			g_sentence = NMEA_GGA;
+		}
+		return;
+	}
+	if((g_sentence == NMEA_UNKNOWN) || (g_length == 0)){
+		return;
+	}
+	/*GGA has no status field, shift it to share the position cases with RMC*/
+	if((g_sentence == NMEA_GGA) && (field >= 2)){
+		field++;
+	}
+
+	switch(field){
+	case 1:
+		value = NMEA_integerValue(); /*hhmmss*/
+		g_work.hour = value / 10000;
+		g_work.minute = (value / 100) % 100;
+		g_work.second = value % 100;
+		break;
+	case 2:
+		g_work.valid = (g_first == 'A');
+		break;
+	case 3:
+		g_work.latitude = NMEA_toDegrees(NMEA_fixedValue());
+		break;
+	case 4:
+		if((g_first == 'S') && (g_work.latitude > 0)){
+			g_work.latitude = -g_work.latitude;
+		}
+		break;
+	case 5:
+		g_work.longitude = NMEA_toDegrees(NMEA_fixedValue());
+		break;
+	case 6:
+		if((g_first == 'W') && (g_work.longitude > 0)){
+			g_work.longitude = -g_work.longitude;
+		}
+		break;
+	default:
+		if(g_sentence == NMEA_RMC){
+			if(field == 7){
+				/*1 knot = 51.444 cm/s*/
+				g_work.speed = (uint16)((NMEA_fixedValue() / 100) * 5144 / 100000);
+			}
+			else if(field == 8){
+				g_work.course = (uint16)(NMEA_fixedValue() / 1000);
+			}
+			else if(field == 9){
+				value = NMEA_integerValue(); /*ddmmyy*/
+				g_work.day = value / 10000;
+				g_work.month = (value / 100) % 100;
+				g_work.year = value % 100;
+			}
+		}
+		else{
+			if(field == 7){
+				g_work.fix_quality = (uint8)g_value;
+			}
+			else if(field == 8){
+				g_work.satellites = (uint8)g_value;
+			}
+			else if(field == 9){
+				g_work.hdop = (uint16)(NMEA_fixedValue() / 1000);
+			}
+			else if(field == 10){
+				value = NMEA_fixedValue() / 1000;
+				g_work.altitude = g_negative ? -(sint32)value : (sint32)value;
+			}
+		}
+		break;
+	}
+}
+
+/*field value scaled by 10^NMEA_FRACTION_DIGITS*/
+static uint32 NMEA_fixedValue(void){
+	uint32 value = g_value;
+	uint8 fraction;
+
+	for(fraction = g_fraction; fraction < NMEA_FRACTION_DIGITS; fraction++){
+		value *= 10;
+	}
+	return value;
+}
+
+/*field value without its decimals*/
+static uint32 NMEA_integerValue(void){
+	uint32 value = g_value;
+	uint8 fraction;
+
+	for(fraction = g_fraction; fraction > 0; fraction--){
+		value /= 10;
+	}
+	return value;
+}
+
+/*(d)ddmm.mmmmm scaled by 1e5 to 1e-7 degrees: minutes * 1e7 / 60 = (minutes * 1e5) * 5 / 3*/
+static sint32 NMEA_toDegrees(uint32 value){
+	return (sint32)((value / NMEA_MINUTES_SCALE) * 10000000UL + (value % NMEA_MINUTES_SCALE) * 5 / 3);
+}
+
+static uint8 NMEA_hexValue(uint8 data){
+	if((data >= '0') && (data <= '9')){
+		return data - '0';
+	}
+	if((data >= 'A') && (data <= 'F')){
+		return data - 'A' + 10;
+	}
+	if((data >= 'a') && (data <= 'f')){
+		return data - 'a' + 10;
+	}
+	return 0xFF; /*never matches a checksum*/
+}
@@ -0,0 +1,36 @@
+/*
+ * nmea.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Streaming NMEA 0183 parser for the NEO-6 GPS ($GPRMC and $GPGGA).
+ */
+
+#ifndef NMEA_H_
+#define NMEA_H_
+
+#include "gps.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define NMEA_FRACTION_DIGITS	5	/*decimals kept from numeric fields, the rest is truncated*/
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Feed one received byte (through GPS_parseByte()). Fields are decoded as they arrive,
+ * nothing is buffered, and the fix is only published once the sentence checksum is
+ * verified. No float and no division except once per decoded field.
+ */
+void NMEA_parseByte(uint8 data);
+
+/*sentences dropped because of a checksum mismatch*/
+uint16 NMEA_getChecksumErrors(void);
+
+#endif /* NMEA_H_ */
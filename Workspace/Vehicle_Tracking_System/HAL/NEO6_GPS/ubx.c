@@ -0,0 +1,420 @@
+/*
+ * ubx.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  UBX and the AVR are both little endian, so the payload bytes of the fields in use are
+ *  written straight into the matching integers of g_raw while the frame arrives. Fields
+ *  that are contiguous in the payload are kept contiguous (and in the same order) in
+ *  UBX_Raw so one range check covers them.
+ */
+
+#include "ubx.h"
+#include "../../MCAL/USART/usart.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef enum{
+	UBX_SYNC_1, UBX_SYNC_2, UBX_CLASS, UBX_ID, UBX_LENGTH_LOW, UBX_LENGTH_HIGH,
+	UBX_PAYLOAD, UBX_CHECKSUM_A, UBX_CHECKSUM_B
+}UBX_State;
+
+typedef struct{
+	sint32 longitude;		/*NAV-POSLLH 4..7, 1e-7 deg*/
+	sint32 latitude;		/*NAV-POSLLH 8..11, 1e-7 deg*/
+	sint32 height_msl;		/*NAV-POSLLH 16..19, mm*/
+	uint32 ground_speed;	/*NAV-VELNED 20..23, cm/s*/
+	sint32 heading;			/*NAV-VELNED 24..27, 1e-5 deg*/
+	uint8 gps_fix;			/*NAV-SOL 10: 0 none, 1 DR, 2 2D, 3 3D, 4 GPS + DR, 5 time only*/
+	uint8 fix_flags;		/*NAV-SOL 11: bit 0 gpsFixOk, bit 1 DGPS used*/
+	uint16 pdop;			/*NAV-SOL 44..45, 0.01*/
+	uint8 satellites;		/*NAV-SOL 47*/
+	uint16 year;			/*NAV-TIMEUTC 12..19*/
+	uint8 month;
+	uint8 day;
+	uint8 hour;
+	uint8 minute;
+	uint8 second;
+	uint8 time_valid;		/*bit 2 validUTC*/
+	uint32 ttff;			/*NAV-STATUS 8..11, ms*/
+}UBX_Raw;
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define UBX_POSLLH_LENGTH		28
+#define UBX_VELNED_LENGTH		36
+#define UBX_SOL_LENGTH			52
+#define UBX_TIMEUTC_LENGTH		20
+#define UBX_STATUS_LENGTH		16
+#define UBX_SOL_FIX_OK			0x01
+#define UBX_SOL_DGPS			0x02
+#define UBX_TIME_VALID_UTC		0x04
+#define UBX_ID_HEALTH			0xFF		/*g_id of the AID-HUI reply being captured (no NAV id)*/
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static UBX_State g_state = UBX_SYNC_1;
+static uint8 g_class;
+static uint8 g_id;							/*NAV message in use (or UBX_ID_HEALTH), 0 if the frame is ignored*/
+static uint16 g_length;
+static uint16 g_offset;						/*payload bytes received*/
+static uint8 g_ck_a;
+static uint8 g_ck_b;
+static UBX_Raw g_raw;
+static volatile uint16 g_checksum_errors = 0;
+static uint32 g_ttff_ms = 0;
+static uint8 * g_health = NULL_PTR;			/*destination of the AID-HUI reply requested*/
+static volatile boolean g_health_received = FALSE;
+static uint8 g_tx_ck_a;							/*checksum of the frame being sent*/
+static uint8 g_tx_ck_b;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint8 * UBX_fieldByte(uint16 offset);
+static void UBX_updateFix(void);
+static void UBX_sendFrame(uint8 msg_class, uint8 msg_id, const uint8 * payload, uint8 length);
+static void UBX_startFrame(uint8 msg_class, uint8 msg_id, uint8 length);
+static void UBX_sendPayloadByte(uint8 data);
+static void UBX_sendValue(uint32 value, uint8 size);
+static void UBX_endFrame(void);
+static void UBX_putLittleEndian(uint8 * buffer, uint32 value, uint8 size);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void UBX_configure(uint16 fix_period_ms){
+	uint8 payload[20];
+
+	if(fix_period_ms < UBX_MIN_FIX_PERIOD_MS){
+		fix_period_ms = UBX_MIN_FIX_PERIOD_MS;
+	}
+
+	/*CFG-PRT: UART1 keeps 9600 8N1, accepts UBX and NMEA, sends UBX only*/
+	memset(payload, 0, sizeof(payload));
+	payload[0] = UBX_PORT_UART1;
+	UBX_putLittleEndian(&payload[4], UBX_UART_MODE_8N1, 4);
+	UBX_putLittleEndian(&payload[8], UBX_UART_BAUD_RATE, 4);
+	UBX_putLittleEndian(&payload[12], UBX_PROTO_UBX | UBX_PROTO_NMEA, 2);
+	UBX_putLittleEndian(&payload[14], UBX_PROTO_UBX, 2);
+	UBX_sendFrame(UBX_CLASS_CFG, UBX_CFG_PRT, payload, 20);
+
+	/*CFG-MSG: class, id, rate in navigation solutions on the current port*/
+	payload[0] = UBX_CLASS_NAV;
+	payload[2] = 1;
+	payload[1] = UBX_NAV_POSLLH;
+	UBX_sendFrame(UBX_CLASS_CFG, UBX_CFG_MSG, payload, 3);
+	payload[1] = UBX_NAV_VELNED;
+	UBX_sendFrame(UBX_CLASS_CFG, UBX_CFG_MSG, payload, 3);
+	payload[1] = UBX_NAV_SOL;
+	UBX_sendFrame(UBX_CLASS_CFG, UBX_CFG_MSG, payload, 3);
+	payload[1] = UBX_NAV_TIMEUTC;
+	payload[2] = UBX_TIME_RATE;
+	UBX_sendFrame(UBX_CLASS_CFG, UBX_CFG_MSG, payload, 3);
+	payload[1] = UBX_NAV_STATUS;
+	UBX_sendFrame(UBX_CLASS_CFG, UBX_CFG_MSG, payload, 3);
+
+	/*CFG-RATE: measurement period, one solution per measurement, aligned to GPS time*/
+	UBX_putLittleEndian(&payload[0], fix_period_ms, 2);
+	UBX_putLittleEndian(&payload[2], 1, 2);
+	UBX_putLittleEndian(&payload[4], 1, 2);
+	UBX_sendFrame(UBX_CLASS_CFG, UBX_CFG_RATE, payload, 6);
+}
+
+/*the payload is sent field by field, it is never held in RAM*/
+void UBX_sendAiding(const GPS_Aiding * aiding){
+	boolean time_valid = aiding->time_valid;
+
+	UBX_startFrame(UBX_CLASS_AID, UBX_AID_INI, UBX_AID_INI_LENGTH);
+	UBX_sendValue((uint32)aiding->latitude, 4);
+	UBX_sendValue((uint32)aiding->longitude, 4);
+	UBX_sendValue((uint32)aiding->altitude, 4);
+	UBX_sendValue(aiding->position_acc_cm, 4);
+	UBX_sendValue(0, 2);	/*tmCfg 0: GPS week and time of week, no time mark*/
+	UBX_sendValue(time_valid ? aiding->week : 0, 2);
+	UBX_sendValue(time_valid ? aiding->time_of_week_ms : 0, 4);
+	UBX_sendValue(0, 4);	/*towNs*/
+	UBX_sendValue(time_valid ? aiding->time_acc_ms : 0, 4);
+	UBX_sendValue(0, 4);	/*tAccNs*/
+	UBX_sendValue(0, 4);	/*clkD*/
+	UBX_sendValue(0, 4);	/*clkDAcc*/
+	UBX_sendValue(UBX_AID_INI_POSITION | UBX_AID_INI_LLA | (time_valid ? UBX_AID_INI_TIME : 0), 4);
+	UBX_endFrame();
+}
+
+void UBX_sendHealth(const uint8 * health){
+	UBX_sendFrame(UBX_CLASS_AID, UBX_AID_HUI, health, GPS_HEALTH_SIZE);
+}
+
+void UBX_requestHealth(uint8 * health){
+	uint8 sreg = SREG;
+
+	cli();
+	g_health = health;
+	g_health_received = FALSE;
+	if(g_id == UBX_ID_HEALTH){
+		g_id = 0; /*the rest of a reply in progress is not written anywhere*/
+	}
+	SREG = sreg;
+	if(health != NULL_PTR){
+		UBX_sendFrame(UBX_CLASS_AID, UBX_AID_HUI, NULL_PTR, 0);
+	}
+}
+
+boolean UBX_healthReceived(void){
+	return g_health_received;
+}
+
+uint32 UBX_getTtff(void){
+	uint32 ttff_ms;
+	uint8 sreg = SREG;
+
+	cli();
+	ttff_ms = g_ttff_ms;
+	SREG = sreg;
+	return ttff_ms;
+}
+
+void UBX_parseByte(uint8 data){
+	uint8 * field;
+
+	if((g_state >= UBX_CLASS) && (g_state <= UBX_PAYLOAD)){
+		g_ck_a += data;
+		g_ck_b += g_ck_a;
+	}
+
+	switch(g_state){
+	case UBX_SYNC_1:
+		if(data == UBX_SYNC_CHAR_1){
+			g_state = UBX_SYNC_2;
+		}
+		break;
+	case UBX_SYNC_2:
+		g_state = (data == UBX_SYNC_CHAR_2) ? UBX_CLASS : UBX_SYNC_1;
+		g_ck_a = 0;
+		g_ck_b = 0;
+		break;
+	case UBX_CLASS:
+		g_class = data;
+		g_state = UBX_ID;
+		break;
+	case UBX_ID:
+		g_id = (g_class == UBX_CLASS_NAV) ? data : 0;
+		if((g_class == UBX_CLASS_AID) && (data == UBX_AID_HUI) && (g_health != NULL_PTR)){
+			g_id = UBX_ID_HEALTH;
+		}
+		g_state = UBX_LENGTH_LOW;
+		break;
+	case UBX_LENGTH_LOW:
+		g_length = data;
+		g_state = UBX_LENGTH_HIGH;
+		break;
+	case UBX_LENGTH_HIGH:
+		g_length |= (uint16)data << 8;
+		g_offset = 0;
+		if(((g_id == UBX_NAV_POSLLH) && (g_length != UBX_POSLLH_LENGTH)) ||
+				((g_id == UBX_NAV_VELNED) && (g_length != UBX_VELNED_LENGTH)) ||
+				((g_id == UBX_NAV_SOL) && (g_length != UBX_SOL_LENGTH)) ||
+				((g_id == UBX_NAV_TIMEUTC) && (g_length != UBX_TIMEUTC_LENGTH)) ||
+				((g_id == UBX_NAV_STATUS) && (g_length != UBX_STATUS_LENGTH)) ||
+				((g_id == UBX_ID_HEALTH) && (g_length != GPS_HEALTH_SIZE))){
+			g_id = 0; /*unexpected layout, only checked for its checksum*/
+		}
+		g_state = (g_length > 0) ? UBX_PAYLOAD : UBX_CHECKSUM_A;
+		break;
+	case UBX_PAYLOAD:
+		field = UBX_fieldByte(g_offset);
+		if(field != NULL_PTR){
+			*field = data;
+		}
+		g_offset++;
+		if(g_offset == g_length){
+			g_state = UBX_CHECKSUM_A;
+		}
+		break;
+	case UBX_CHECKSUM_A:
+		g_state = (data == g_ck_a) ? UBX_CHECKSUM_B : UBX_SYNC_1;
+		if(data != g_ck_a){
+			g_checksum_errors++;
+		}
+		break;
+	case UBX_CHECKSUM_B:
+		if(data == g_ck_b){
+			UBX_updateFix();
+		}
+		else{
+			g_checksum_errors++;
+		}
+		g_state = UBX_SYNC_1;
+		break;
+	default:
+		g_state = UBX_SYNC_1;
+		break;
+	}
+}
+
+uint16 UBX_getChecksumErrors(void){
+	uint16 errors;
+	uint8 sreg = SREG;
+
+	cli();
+	errors = g_checksum_errors;
+	SREG = sreg;
+	return errors;
+}
+
+/*destination of the payload byte at the given offset, NULL_PTR if the byte is not used*/
+static uint8 * UBX_fieldByte(uint16 offset){
+	switch(g_id){
+	case UBX_NAV_POSLLH:
+		if((offset >= 4) && (offset < 12)){
+			return (uint8 *)&g_raw.longitude + (offset - 4);
+		}
+		if((offset >= 16) && (offset < 20)){
+			return (uint8 *)&g_raw.height_msl + (offset - 16);
+		}
+		break;
+	case UBX_NAV_VELNED:
+		if((offset >= 20) && (offset < 28)){
+			return (uint8 *)&g_raw.ground_speed + (offset - 20);
+		}
+		break;
+	case UBX_NAV_SOL:
+		if((offset == 10) || (offset == 11)){
+			return &g_raw.gps_fix + (offset - 10);
+		}
+		if((offset == 44) || (offset == 45)){
+			return (uint8 *)&g_raw.pdop + (offset - 44);
+		}
+		if(offset == 47){
+			return &g_raw.satellites;
+		}
+		break;
+	case UBX_NAV_TIMEUTC:
+		if((offset >= 12) && (offset < 20)){
+			return (uint8 *)&g_raw.year + (offset - 12);
+		}
+		break;
+	case UBX_NAV_STATUS:
+		if((offset >= 8) && (offset < 12)){
+			return (uint8 *)&g_raw.ttff + (offset - 8);
+		}
+		break;
+	case UBX_ID_HEALTH:
+		return (g_health != NULL_PTR) ? &g_health[offset] : NULL_PTR;
+	default:
+		break;
+	}
+	return NULL_PTR;
+}
+
+/*convert the message that just passed its checksum into the published fix*/
+static void UBX_updateFix(void){
+	GPS_Fix fix;
+
+	if(g_id == UBX_ID_HEALTH){
+		g_health = NULL_PTR;
+		g_health_received = TRUE;
+		return;
+	}
+	if(g_id == UBX_NAV_STATUS){
+		g_ttff_ms = g_raw.ttff; /*0 until the first fix*/
+		return;
+	}
+	GPS_getPublishedFix(&fix);
+	switch(g_id){
+	case UBX_NAV_POSLLH:
+		fix.latitude = g_raw.latitude;
+		fix.longitude = g_raw.longitude;
+		fix.altitude = g_raw.height_msl / 10;
+		break;
+	case UBX_NAV_VELNED:
+		fix.speed = (g_raw.ground_speed > 0xFFFF) ? 0xFFFF : (uint16)g_raw.ground_speed;
+		fix.course = (uint16)(g_raw.heading / 1000);
+		break;
+	case UBX_NAV_SOL:
+		fix.valid = (g_raw.fix_flags & UBX_SOL_FIX_OK) && (g_raw.gps_fix >= 2) && (g_raw.gps_fix <= 4);
+		fix.fix_quality = !fix.valid ? 0 : ((g_raw.fix_flags & UBX_SOL_DGPS) ? 2 : 1);
+		fix.hdop = g_raw.pdop;
+		fix.satellites = g_raw.satellites;
+		break;
+	case UBX_NAV_TIMEUTC:
+		if(!(g_raw.time_valid & UBX_TIME_VALID_UTC)){
+			return;
+		}
+		fix.year = (uint8)(g_raw.year - 2000);
+		fix.month = g_raw.month;
+		fix.day = g_raw.day;
+		fix.hour = g_raw.hour;
+		fix.minute = g_raw.minute;
+		fix.second = g_raw.second;
+		break;
+	default:
+		return; /*ACK/NAK and other frames*/
+	}
+	GPS_publishFix(&fix);
+}
+
+static void UBX_sendFrame(uint8 msg_class, uint8 msg_id, const uint8 * payload, uint8 length){
+	uint8 i;
+
+	UBX_startFrame(msg_class, msg_id, length);
+	for(i = 0; i < length; i++){
+		UBX_sendPayloadByte(payload[i]);
+	}
+	UBX_endFrame();
+}
+
+/*sync characters and header, the checksum starts at the class*/
+static void UBX_startFrame(uint8 msg_class, uint8 msg_id, uint8 length){
+	g_tx_ck_a = 0;
+	g_tx_ck_b = 0;
+	USART_sendByte(UBX_SYNC_CHAR_1);
+	USART_sendByte(UBX_SYNC_CHAR_2);
+	UBX_sendPayloadByte(msg_class);
+	UBX_sendPayloadByte(msg_id);
+	UBX_sendPayloadByte(length);
+	UBX_sendPayloadByte(0);
+}
+
+static void UBX_sendPayloadByte(uint8 data){
+	g_tx_ck_a += data;
+	g_tx_ck_b += g_tx_ck_a;
+	USART_sendByte(data);
+}
+
+/*little endian field of size bytes*/
+static void UBX_sendValue(uint32 value, uint8 size){
+	uint8 i;
+
+	for(i = 0; i < size; i++){
+		UBX_sendPayloadByte((uint8)value);
+		value >>= 8;
+	}
+}
+
+static void UBX_endFrame(void){
+	USART_sendByte(g_tx_ck_a);
+	USART_sendByte(g_tx_ck_b);
+}
+
+static void UBX_putLittleEndian(uint8 * buffer, uint32 value, uint8 size){
+	uint8 i;
+
+	for(i = 0; i < size; i++){
+		buffer[i] = (uint8)value;
+		value >>= 8;
+	}
+}
@@ -0,0 +1,104 @@
+/*
+ * ubx.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  UBX binary protocol driver for the NEO-6 GPS (protocol version 7).
+ *
+ *  Frame: 0xB5 0x62, class, id, length (u16 LE), payload, CK_A, CK_B (8-bit Fletcher
+ *  over class, id, length and payload).
+ *  The NEO-6 has no NAV-PVT (u-blox 7 and later), the fix is built from:
+ *    NAV-POSLLH  (01 02, 28 bytes)  lon/lat 1e-7 deg, hMSL mm
+ *    NAV-VELNED  (01 12, 36 bytes)  gSpeed cm/s, heading 1e-5 deg
+ *    NAV-SOL     (01 06, 52 bytes)  gpsFix, flags, pDOP 0.01, numSV
+ *    NAV-TIMEUTC (01 21, 20 bytes)  UTC date and time, every UBX_TIME_RATE fixes
+ *    NAV-STATUS  (01 03, 16 bytes)  time to first fix, every UBX_TIME_RATE fixes
+ *  About 145 bytes per fix on the UART against about 450 bytes for the factory NMEA set
+ *  (GGA, GLL, GSA, 3 x GSV, RMC, VTG), and the fields are copied as binary integers instead
+ *  of being decoded from ASCII.
+ *  Aiding (accepted whatever the output protocol):
+ *    AID-INI     (0B 01, 48 bytes)  initial position (LLA) and GPS time
+ *    AID-HUI     (0B 02, 72 bytes)  satellite health, UTC and Klobuchar parameters, polled
+ *                                   with an empty AID-HUI and sent back at the next boot
+ */
+
+#ifndef UBX_H_
+#define UBX_H_
+
+#include "gps.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define UBX_SYNC_CHAR_1			0xB5
+#define UBX_SYNC_CHAR_2			0x62
+
+#define UBX_CLASS_NAV			0x01
+#define UBX_CLASS_CFG			0x06
+#define UBX_CLASS_AID			0x0B
+#define UBX_NAV_POSLLH			0x02
+#define UBX_NAV_STATUS			0x03
+#define UBX_NAV_SOL				0x06
+#define UBX_NAV_VELNED			0x12
+#define UBX_NAV_TIMEUTC			0x21
+#define UBX_CFG_PRT				0x00
+#define UBX_CFG_MSG				0x01
+#define UBX_CFG_RATE			0x08
+#define UBX_AID_INI				0x01
+#define UBX_AID_HUI				0x02
+
+#define UBX_PORT_UART1			1
+#define UBX_UART_BAUD_RATE		9600UL		/*shared USART speed, must not change*/
+#define UBX_UART_MODE_8N1		0x000008D0UL
+#define UBX_PROTO_UBX			0x0001
+#define UBX_PROTO_NMEA			0x0002
+
+#define UBX_AID_INI_LENGTH		48
+#define UBX_AID_INI_POSITION	0x00000001UL	/*flags: position valid*/
+#define UBX_AID_INI_TIME		0x00000002UL	/*flags: time valid*/
+#define UBX_AID_INI_LLA			0x00000020UL	/*flags: position given as latitude, longitude, altitude*/
+
+#define UBX_TIME_RATE			10			/*NAV-TIMEUTC and NAV-STATUS once every this many fixes*/
+#define UBX_MIN_FIX_PERIOD_MS	200			/*145 bytes per fix at 9600 baud take 151 ms*/
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Switch the receiver UART output to UBX only, enable the navigation messages and set the
+ * measurement period (clamped to UBX_MIN_FIX_PERIOD_MS). The frames are queued on the USART,
+ * which must be routed to the GPS until they are sent (USART_flush()).
+ */
+void UBX_configure(uint16 fix_period_ms);
+
+/*
+ * Description :
+ * Feed one received byte (through GPS_parseByte()). The payload is not buffered:
+ * the bytes of the fields in use are stored as they arrive and converted into the fix once
+ * the checksum of the frame is verified.
+ */
+void UBX_parseByte(uint8 data);
+
+/*
+ * Description :
+ * Aiding frames (see GPS_sendAiding()), queued on the USART like UBX_configure().
+ * UBX_requestHealth() polls AID-HUI, the reply payload is written into health as it arrives
+ * and UBX_healthReceived() turns TRUE once its checksum is verified (NULL_PTR cancels the
+ * request, the buffer is not written any more).
+ */
+void UBX_sendAiding(const GPS_Aiding * aiding);
+void UBX_sendHealth(const uint8 * health);
+void UBX_requestHealth(uint8 * health);
+boolean UBX_healthReceived(void);
+
+/*time to first fix measured by the receiver since its start (ms), 0 until reported*/
+uint32 UBX_getTtff(void);
+
+/*frames dropped because of a checksum mismatch*/
+uint16 UBX_getChecksumErrors(void);
+
+#endif /* UBX_H_ */
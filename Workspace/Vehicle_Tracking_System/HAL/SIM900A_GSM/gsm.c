@@ -7,100 +7,756 @@
 
 #include "gsm.h"
 
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
 
-boolean GSM_init(char * message_buffer){
-	USART_sendString(NO_ECHO_CMD);
-	_delay_ms(500); /*half a second response time*/
-	if(strstr(message_buffer,"OK")){ /*write your own GSM_subStrfind() function*/
-		USART_sendString(TEXT_MODE_CMD);
-		return TRUE;
-	}
-	else {
+typedef enum{
+	GSM_ENGINE_IDLE, GSM_ENGINE_SEND_CMD, GSM_ENGINE_WAIT_PROMPT, GSM_ENGINE_SEND_PAYLOAD, GSM_ENGINE_WAIT_RESPONSE,
+	GSM_ENGINE_SEND_SYNC, GSM_ENGINE_WAIT_SYNC	/*resynchronising after a timeout, no command active*/
+}GSM_EngineState;
+
+typedef struct{
+	const char * command;		/*in the flash, or g_cmd_text*/
+	boolean command_in_flash;
+	const char * payload;
+	uint8 payload_length;		/*0: text payload terminated by Ctrl+Z, else raw bytes*/
+	boolean payload_in_flash;	/*text payload given to GSM_submitCmdText_P()*/
+	uint16 timeout_ms;
+	GSM_LineHandler on_line;
+	GSM_DoneHandler on_done;
+}GSM_Command;
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+/*command FIFO, the active command is the one at g_cmd_tail*/
+static GSM_Command g_cmd_queue[GSM_CMD_QUEUE_SIZE];
+static char g_cmd_text[GSM_CMD_MAX_LENGTH];	/*copied or formatted command, held until it is sent*/
+static boolean g_cmd_text_busy = FALSE;
+static uint8 g_cmd_head = 0;
+static uint8 g_cmd_tail = 0;
+static uint8 g_cmd_count = 0;
+static uint8 g_cmd_submitted = 0;	/*free running sequence numbers used by GSM_execute()*/
+static uint8 g_cmd_completed = 0;
+
+static GSM_EngineState g_engine_state = GSM_ENGINE_IDLE;
+static uint32 g_cmd_start_ms;
+static uint16 g_payload_index;		/*next byte of the command, then of the payload, to queue*/
+static GSM_CmdStatus g_last_status = GSM_CMD_OK;
+static uint32 g_cmd_sent_ms;		/*latency reference, g_cmd_start_ms restarts after the payload*/
+static GSM_EngineStats g_stats;
+static boolean g_hold = FALSE;		/*queued commands wait while the USART is given to another user*/
+
+/*resynchronisation after a timeout (GSM_startSync())*/
+static const char g_sync_cmd[] PROGMEM = IDENTIFY_CMD;
+static boolean g_sync_needed = FALSE;
+static boolean g_sync_escape = FALSE;		/*the modem may still be taking the text of the expired command*/
+static boolean g_sync_identified = FALSE;	/*the ATI product line, its OK is the sync point*/
+
+/*destination of the message read by GSM_readMsgContents()*/
+static char * g_read_sender;
+static char * g_read_text;
+static boolean g_read_expect_text;
+static boolean g_read_found;
+
+/*state of the AT+CMGL listing in progress*/
+static GSM_MsgHandler g_list_handler;
+static uint8 g_list_index;
+static boolean g_list_expect_text;
+static boolean g_list_refused = FALSE;		/*a message of the last listing was not taken by the handler*/
+static char g_list_sender[DIAL_NO_LENGTH];
+
+/*SIM message storage occupancy from the last AT+CPMS?*/
+static uint8 g_storage_used = 0;
+static uint8 g_storage_total = 0;
+
+/*modem clock from the last AT+CCLK?*/
+static GSM_Clock g_clock;
+static boolean g_clock_valid = FALSE;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static GSM_Command * GSM_queueCmd(const char * command, boolean command_in_flash, const char * payload,
+		uint16 timeout_ms, GSM_LineHandler on_line, GSM_DoneHandler on_done);
+static GSM_Command * GSM_queueFormat(const char * payload, uint16 timeout_ms, GSM_LineHandler on_line,
+		GSM_DoneHandler on_done, PGM_P format, va_list arguments);
+static void GSM_startCmd(void);
+static void GSM_sendCmd(void);
+static void GSM_startSync(void);
+static void GSM_sendSync(void);
+static boolean GSM_syncing(void);
+static void GSM_syncLine(void);
+static char GSM_commandChar(const GSM_Command * cmd);
+static char GSM_payloadChar(const GSM_Command * cmd);
+static void GSM_completeCmd(GSM_CmdStatus status);
+static void GSM_processLine(void);
+static void GSM_startPayload(void);
+static boolean GSM_lineEquals_P(PGM_P str);
+static boolean GSM_readMsgLine(void);
+static boolean GSM_listMsgLine(void);
+static boolean GSM_storageLine(void);
+static boolean GSM_clockLine(void);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+boolean GSM_submitCmd(const char * command, const char * payload, uint16 timeout_ms,
+		GSM_LineHandler on_line, GSM_DoneHandler on_done){
+	if(g_cmd_text_busy || (strlen(command) >= GSM_CMD_MAX_LENGTH) ||
+			(GSM_queueCmd(g_cmd_text, FALSE, payload, timeout_ms, on_line, on_done) == NULL_PTR)){
 		return FALSE;
 	}
+	strcpy(g_cmd_text, command);
+	g_cmd_text_busy = TRUE;
+	return TRUE;
+}
+
+boolean GSM_submitCmd_P(PGM_P command, const char * payload, uint16 timeout_ms,
+		GSM_LineHandler on_line, GSM_DoneHandler on_done){
+	return (GSM_queueCmd(command, TRUE, payload, timeout_ms, on_line, on_done) != NULL_PTR);
 }
 
-boolean GSM_isMsgReceived(char * message_buffer, char * message_location){
-	char buf_ptr = 0, i = 0;
-	if(!strstr(message_buffer,"CMTI:")){
+boolean GSM_submitCmdText_P(PGM_P text, uint16 timeout_ms, GSM_LineHandler on_line,
+		GSM_DoneHandler on_done, PGM_P format, ...){
+	va_list arguments;
+	GSM_Command * cmd;
+
+	va_start(arguments, format);
+	cmd = GSM_queueFormat(text, timeout_ms, on_line, on_done, format, arguments);
+	va_end(arguments);
+	if(cmd == NULL_PTR){
 		return FALSE;
 	}
-	else{
-		while(message_buffer[buf_ptr]!= ','){
-				buf_ptr++;
+	cmd->payload_in_flash = TRUE;
+	return TRUE;
+}
+
+boolean GSM_submitCmdFormat_P(const char * payload, uint16 timeout_ms, GSM_LineHandler on_line,
+		GSM_DoneHandler on_done, PGM_P format, ...){
+	va_list arguments;
+	GSM_Command * cmd;
+
+	va_start(arguments, format);
+	cmd = GSM_queueFormat(payload, timeout_ms, on_line, on_done, format, arguments);
+	va_end(arguments);
+	return (cmd != NULL_PTR);
+}
+
+/*
+ * Description :
+ * Advance the AT transaction engine, never waits:
+ * 1. Start the next queued command if the modem is free, queue what the USART takes of it.
+ * 2. Match every complete line in the receive ring (final result codes, command data, URCs).
+ * 3. Stream the payload once the '>' prompt is seen.
+ * 4. Expire the active command on timeout, then resynchronise before the next one starts.
+ */
+void GSM_task(void){
+	GSM_Command * cmd;
+
+	if((g_engine_state == GSM_ENGINE_IDLE) && !g_hold){
+		if(g_sync_needed){
+			GSM_startSync();
+		}
+		else if(g_cmd_count > 0){
+			GSM_startCmd();
 		}
+	}
+	if(g_engine_state == GSM_ENGINE_SEND_CMD){
+		GSM_sendCmd();
+	}
+	else if(g_engine_state == GSM_ENGINE_SEND_SYNC){
+		GSM_sendSync();
+	}
 
-		while(message_buffer[buf_ptr++]!= '\r'){
-			message_location[i++]= message_buffer[buf_ptr];				      /* copy location of received message where it is stored */
+	while(USART_rxLinesPending()){
+		if(GSM_lineLength() > 0){
+			GSM_processLine();
 		}
-		message_location[i] = '\0';
-		return TRUE;
+		USART_rxConsumeLine();
+	}
+
+	/*the prompt is "> " without a line terminator*/
+	if((g_engine_state == GSM_ENGINE_WAIT_PROMPT) && (USART_rxCount() > 0) && (USART_rxPeek(0) == '>')){
+		USART_rxDrop(((USART_rxCount() > 1) && (USART_rxPeek(1) == ' ')) ? 2 : 1);
+		GSM_startPayload();
+	}
+
+	if(g_engine_state == GSM_ENGINE_SEND_PAYLOAD){
+		cmd = &g_cmd_queue[g_cmd_tail];
+		if(cmd->payload_length == 0){
+			while((GSM_payloadChar(cmd) != '\0') && USART_queueByte(GSM_payloadChar(cmd))){
+				g_payload_index++;
+			}
+			if((GSM_payloadChar(cmd) == '\0') && USART_queueByte(CTRL_Z_CHARACTER)){
+				g_engine_state = GSM_ENGINE_WAIT_RESPONSE;
+				g_cmd_start_ms = SYSTICK_getMs(); /*the response timeout starts after the text is sent*/
+			}
+		}
+		else{
+			/*raw data (AT+CIPSEND=<length>), the modem counts the bytes, no terminator*/
+			while((g_payload_index < cmd->payload_length) && USART_queueByte(cmd->payload[g_payload_index])){
+				g_payload_index++;
+			}
+			if(g_payload_index == cmd->payload_length){
+				g_engine_state = GSM_ENGINE_WAIT_RESPONSE;
+				g_cmd_start_ms = SYSTICK_getMs();
+			}
+		}
+	}
+
+	if(GSM_syncing()){
+		if(SYSTICK_elapsedMs(g_cmd_start_ms) >= GSM_DEFAULT_TIMEOUT_MS){
+			g_engine_state = GSM_ENGINE_IDLE; /*no answer to ATI either, ask again*/
+		}
+	}
+	else if(g_engine_state != GSM_ENGINE_IDLE){
+		if(SYSTICK_elapsedMs(g_cmd_start_ms) >= ((g_engine_state == GSM_ENGINE_WAIT_PROMPT) ?
+				GSM_PROMPT_TIMEOUT_MS : g_cmd_queue[g_cmd_tail].timeout_ms)){
+			GSM_completeCmd(GSM_CMD_TIMEOUT);
+		}
+	}
+
+	/*a line longer than the whole ring can never complete, drop it to unblock reception*/
+	if((USART_rxLinesPending() == 0) && (USART_rxCount() == USART_RX_BUFFER_MASK)){
+		USART_rxFlush();
+	}
+}
+
+boolean GSM_submitData(const char * command, const uint8 * data, uint8 length, uint16 timeout_ms,
+		GSM_LineHandler on_line, GSM_DoneHandler on_done){
+	uint8 slot = g_cmd_head;
+
+	if((length == 0) || !GSM_submitCmd(command, (const char *)data, timeout_ms, on_line, on_done)){
+		return FALSE;
+	}
+	g_cmd_queue[slot].payload_length = length;
+	return TRUE;
+}
+
+void GSM_endCmd(GSM_CmdStatus status){
+	if((g_engine_state != GSM_ENGINE_IDLE) && !GSM_syncing()){
+		GSM_completeCmd(status);
+	}
+}
+
+void GSM_hold(boolean hold){
+	g_hold = hold;
+}
+
+boolean GSM_cmdInProgress(void){
+	return (g_engine_state != GSM_ENGINE_IDLE);
+}
+
+uint8 GSM_queuedCmds(void){
+	return g_cmd_count;
+}
+
+boolean GSM_isIdle(void){
+	return (g_engine_state == GSM_ENGINE_IDLE) && (g_cmd_count == 0);
+}
+
+GSM_CmdStatus GSM_getLastStatus(void){
+	return g_last_status;
+}
+
+void GSM_getStats(GSM_EngineStats * stats){
+	*stats = g_stats;
+}
+
+void GSM_resetStats(void){
+	memset(&g_stats, 0, sizeof(g_stats));
+}
+
+GSM_CmdStatus GSM_execute(const char * command, const char * payload, uint16 timeout_ms, GSM_LineHandler on_line){
+	uint8 sequence;
+
+	while(!GSM_submitCmd(command, payload, timeout_ms, on_line, NULL_PTR)){
+		GSM_task(); /*queue is full, let the pending commands go*/
+	}
+	sequence = g_cmd_submitted;
+	while((sint8)(g_cmd_completed - sequence) < 0){
+		GSM_task();
+	}
+	return g_last_status;
+}
+
+boolean GSM_init(void){
+	char command[12];
+
+	strcpy_P(command, PSTR(NO_ECHO_CMD));
+	if(GSM_execute(command, NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR) != GSM_CMD_OK){
+		return FALSE;
 	}
+	strcpy_P(command, PSTR(TEXT_MODE_CMD));
+	return (GSM_execute(command, NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR) == GSM_CMD_OK);
 }
 
-boolean GSM_readMsgContents(char * message_location, char * message_buffer, char * sender_number, char * recieved_message){
+boolean GSM_readMsgContents(uint8 message_index, char * sender_number, char * recieved_message){
 	char read_command [13]; /*13 character for the command and the location*/
-	char buf_ptr = 0, i = 0;
 
-	sprintf(read_command, "%s%s\r", READ_MSG_CMD, message_location);
-	USART_sendString(read_command);
-	_delay_ms(1000); /*wait a second for buffer to fill up (might consider reducing after testing)*/
-	if(!strstr(message_buffer,"+CMGR")){
+	sprintf_P(read_command, PSTR(READ_MSG_CMD "%u\r"), message_index);
+	g_read_sender = sender_number;
+	g_read_text = recieved_message;
+	g_read_expect_text = FALSE;
+	g_read_found = FALSE;
+	return (GSM_execute(read_command, NULL_PTR, GSM_READ_TIMEOUT_MS, GSM_readMsgLine) == GSM_CMD_OK) && g_read_found;
+}
+
+boolean GSM_sendMsg(char * number, char * message_to_send){
+	char send_msg_command[GSM_CMD_MAX_LENGTH];
+	snprintf_P(send_msg_command, sizeof(send_msg_command), PSTR(SEND_MSG_CMD "\"%s\"\r"), number);
+	return (GSM_execute(send_msg_command, message_to_send, GSM_SMS_TIMEOUT_MS, NULL_PTR) == GSM_CMD_OK);
+}
+
+boolean GSM_deleteMsg(uint8 message_index, GSM_DoneHandler on_done){
+	return GSM_submitCmdFormat_P(NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR, on_done,
+			PSTR(DELETE_MSG_CMD "%u\r"), message_index);
+}
+
+void GSM_deleteAllMsgs(){
+	GSM_submitCmd_P(PSTR(DEL_ALL_MSGS_CMD), NULL_PTR, GSM_DELETE_TIMEOUT_MS, NULL_PTR, NULL_PTR);
+}
+
+boolean GSM_listMsgs(const char * stat, GSM_MsgHandler on_msg, GSM_DoneHandler on_done){
+	g_list_handler = on_msg;
+	g_list_expect_text = FALSE;
+	g_list_refused = FALSE;
+	return GSM_submitCmdFormat_P(NULL_PTR, GSM_LIST_TIMEOUT_MS, GSM_listMsgLine, on_done,
+			PSTR(LIST_MSGS_CMD "\"%s\"\r"), stat);
+}
+
+/*refused while the last listing left messages it marked as read in the SIM*/
+boolean GSM_deleteReadMsgs(GSM_DoneHandler on_done){
+	if(g_list_refused){
 		return FALSE;
 	}
-	else {
-		while(message_buffer[buf_ptr]!= ','){ /*to get mobile number*/
-			buf_ptr++;
+	return GSM_submitCmd_P(PSTR(DEL_READ_MSGS_CMD), NULL_PTR, GSM_DELETE_TIMEOUT_MS, NULL_PTR, on_done);
+}
+
+boolean GSM_listAllTaken(void){
+	return !g_list_refused;
+}
+
+boolean GSM_queryStorage(GSM_DoneHandler on_done){
+	return GSM_submitCmd_P(PSTR(STORAGE_STATUS_CMD), NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, GSM_storageLine, on_done);
+}
+
+uint8 GSM_getStorageUsed(void){
+	return g_storage_used;
+}
+
+uint8 GSM_getStorageTotal(void){
+	return g_storage_total;
+}
+
+boolean GSM_queryClock(GSM_DoneHandler on_done){
+	g_clock_valid = FALSE;
+	return GSM_submitCmd_P(PSTR(CLOCK_QUERY_CMD), NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, GSM_clockLine, on_done);
+}
+
+boolean GSM_getClock(GSM_Clock * clock){
+	if(g_clock_valid){
+		*clock = g_clock;
+	}
+	return g_clock_valid;
+}
+
+boolean GSM_setClock(const GSM_Clock * clock, GSM_DoneHandler on_done){
+	return GSM_submitCmdFormat_P(NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR, on_done,
+			PSTR(CLOCK_SET_CMD "\"%02u/%02u/%02u,%02u:%02u:%02u%+03d\"\r"), clock->year,
+			clock->month, clock->day, clock->hour, clock->minute, clock->second, clock->zone);
+}
+
+/*
+ * Description :
+ * Length of the oldest complete line in the receive ring without the "\r\n" terminator.
+ */
+uint8 GSM_lineLength(void){
+	uint8 length = USART_rxLineLength();
+	if(length > 0){
+		length--; /*'\n'*/
+	}
+	if((length > 0) && (USART_rxPeek(length - 1) == '\r')){
+		length--;
+	}
+	return length;
+}
+
+/*
+ * Description :
+ * Copy the oldest complete line (without terminator) into line, null terminated.
+ */
+uint8 GSM_lineCopy(char * line, uint8 max_length){
+	uint8 i;
+	uint8 length = GSM_lineLength();
+
+	if(length > max_length - 1){
+		length = max_length - 1;
+	}
+	for(i = 0; i < length; i++){
+		line[i] = USART_rxPeek(i);
+	}
+	line[i] = '\0';
+	return length;
+}
+
+/*
+ * Description :
+ * Compare the beginning of the oldest complete line with the given prefix (in the flash), in place.
+ */
+boolean GSM_lineStartsWith_P(PGM_P prefix){
+	uint8 i;
+	uint8 length = GSM_lineLength();
+	uint8 data;
+	for(i = 0; (data = pgm_read_byte(&prefix[i])) != '\0'; i++){
+		if((i >= length) || (USART_rxPeek(i) != data)){
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Copy field number field_index of a "+XXXX: a,"b",c" line into field (null terminated,
+ * at most max_length - 1 characters). Returns the number of copied characters.
+ */
+uint8 GSM_lineGetField(uint8 field_index, char * field, uint8 max_length){
+	uint8 i = 0, j = 0;
+	uint8 length = GSM_lineLength();
+	boolean quoted = FALSE;
+	uint8 data;
+
+	/*fields start after the ':' of the response name (if there is one)*/
+	while((i < length) && (USART_rxPeek(i) != ':')){
+		i++;
+	}
+	i = (i < length) ? (i + 1) : 0;
+
+	/*skip the preceding fields*/
+	for(; (i < length) && (field_index > 0); i++){
+		data = USART_rxPeek(i);
+		if(data == '"'){
+			quoted = !quoted;
 		}
-		buf_ptr +=2;
-		/*extract phone number*/
-		for(i =0; i<DIAL_NO_LENGTH-1; i++){
-			sender_number[i] = message_buffer[buf_ptr];
-			buf_ptr++;
+		else if((data == ',') && !quoted){
+			field_index--;
 		}
-		sender_number[i] = '\0';
-		while(message_buffer[buf_ptr++]!= '\n'); /*to get the message*/
-		i = 0;
-		while ( (i < REC_MSG_MAX_LENGTH) && (message_buffer[buf_ptr] != '\r')){
-			recieved_message[i] = message_buffer[buf_ptr];
-			i++;
-			buf_ptr++;
+	}
+	while((i < length) && (USART_rxPeek(i) == ' ')){
+		i++;
+	}
+
+	quoted = FALSE;
+	for(; i < length; i++){
+		data = USART_rxPeek(i);
+		if(data == '"'){
+			quoted = !quoted;
+			continue;
 		}
-		recieved_message[i] = '\0';
-		return TRUE;
+		if(((data == ',') && !quoted) || (j >= max_length - 1)){
+			break;
+		}
+		field[j++] = data;
+	}
+	field[j] = '\0';
+	return j;
+}
+
+/*
+ * Description :
+ * Take the next free queue slot for the command, NULL_PTR if the queue is full.
+ * A command in RAM is g_cmd_text, which the caller fills and marks busy.
+ */
+static GSM_Command * GSM_queueCmd(const char * command, boolean command_in_flash, const char * payload,
+		uint16 timeout_ms, GSM_LineHandler on_line, GSM_DoneHandler on_done){
+	GSM_Command * cmd;
+
+	if(g_cmd_count == GSM_CMD_QUEUE_SIZE){
+		return NULL_PTR;
 	}
+	cmd = &g_cmd_queue[g_cmd_head];
+	cmd->command = command;
+	cmd->command_in_flash = command_in_flash;
+	cmd->payload = payload;
+	cmd->payload_length = 0;
+	cmd->payload_in_flash = FALSE;
+	cmd->timeout_ms = timeout_ms;
+	cmd->on_line = on_line;
+	cmd->on_done = on_done;
+	g_cmd_head = (g_cmd_head + 1) % GSM_CMD_QUEUE_SIZE;
+	g_cmd_count++;
+	g_cmd_submitted++;
+	return cmd;
 }
 
-void GSM_sendMsg(char * number, char * message_to_send, char * message_buffer, char * buff_ptr){
-	char send_msg_command[23];
-	sprintf(send_msg_command,"%s\"%s\"\r", SEND_MSG_CMD, number);
-	USART_sendString(send_msg_command);
-	_delay_ms(500);
-	while(TRUE)
-	{
-		if(message_buffer[*buff_ptr]==0x3e) /*'>' character*/
-		{
-		   buff_ptr = 0;
-		   memset(message_buffer,0,MSG_BUFFER_SIZE);
-		   USART_sendString(message_to_send);
-		   USART_sendByte(0x1a); /* send Ctrl+Z */
-		   break;
+/*the command is formatted straight into g_cmd_text, taken only if the whole command fitted*/
+static GSM_Command * GSM_queueFormat(const char * payload, uint16 timeout_ms, GSM_LineHandler on_line,
+		GSM_DoneHandler on_done, PGM_P format, va_list arguments){
+	int length;
+	GSM_Command * cmd;
+
+	if(g_cmd_text_busy || (g_cmd_count == GSM_CMD_QUEUE_SIZE)){
+		return NULL_PTR;
+	}
+	length = vsnprintf_P(g_cmd_text, GSM_CMD_MAX_LENGTH, format, arguments);
+	if((length < 0) || (length >= GSM_CMD_MAX_LENGTH)){
+		return NULL_PTR;
+	}
+	cmd = GSM_queueCmd(g_cmd_text, FALSE, payload, timeout_ms, on_line, on_done);
+	g_cmd_text_busy = TRUE;
+	return cmd;
+}
+
+static void GSM_startCmd(void){
+	g_payload_index = 0;
+	g_engine_state = GSM_ENGINE_SEND_CMD;
+	g_cmd_start_ms = SYSTICK_getMs();
+	g_cmd_sent_ms = g_cmd_start_ms;
+	GSM_sendCmd();
+}
+
+/*
+ * Description :
+ * Queue the active command as far as the USART transmit queue takes it, the rest goes on
+ * the next GSM_task() call. The response timeout starts once the command is queued.
+ */
+static void GSM_sendCmd(void){
+	GSM_Command * cmd = &g_cmd_queue[g_cmd_tail];
+
+	while((GSM_commandChar(cmd) != '\0') && USART_queueByte(GSM_commandChar(cmd))){
+		g_payload_index++;
+	}
+	if(GSM_commandChar(cmd) == '\0'){
+		if(!cmd->command_in_flash){
+			g_cmd_text_busy = FALSE; /*sent, the next command can be copied*/
+		}
+		g_engine_state = (cmd->payload != NULL_PTR) ? GSM_ENGINE_WAIT_PROMPT : GSM_ENGINE_WAIT_RESPONSE;
+		g_cmd_start_ms = SYSTICK_getMs();
+	}
+}
+
+/*
+ * Description :
+ * A command that timed out may still be answered, and its late result would end the next
+ * command. The input is discarded until ATI has been answered: its product line can only
+ * come after whatever the modem still owed, and the OK that follows it is the sync point.
+ * ESC first cancels the text entry a command that expired around its prompt may have left.
+ */
+static void GSM_startSync(void){
+	g_payload_index = 0;
+	g_sync_identified = FALSE;
+	g_engine_state = GSM_ENGINE_SEND_SYNC;
+	g_cmd_start_ms = SYSTICK_getMs();
+	GSM_sendSync();
+}
+
+static void GSM_sendSync(void){
+	if(g_sync_escape){
+		if(!USART_queueByte(ESC_CHARACTER)){
+			return;
 		}
-		(*buff_ptr)++;
+		g_sync_escape = FALSE;
+	}
+	while((pgm_read_byte(&g_sync_cmd[g_payload_index]) != '\0') && USART_queueByte(pgm_read_byte(&g_sync_cmd[g_payload_index]))){
+		g_payload_index++;
+	}
+	if(pgm_read_byte(&g_sync_cmd[g_payload_index]) == '\0'){
+		g_engine_state = GSM_ENGINE_WAIT_SYNC;
+		g_cmd_start_ms = SYSTICK_getMs();
 	}
 }
 
-void GSM_deleteMsg(char * message_location){
-	char delete_command[13];
-	sprintf(delete_command,"%s%s\r",READ_MSG_CMD, message_location);
-	USART_sendString(delete_command);
+static boolean GSM_syncing(void){
+	return (g_engine_state == GSM_ENGINE_SEND_SYNC) || (g_engine_state == GSM_ENGINE_WAIT_SYNC);
+}
 
+/*the product line must be followed by OK straight away, so a listed SMS text cannot pass for it*/
+static void GSM_syncLine(void){
+	if(GSM_lineStartsWith_P(PSTR(IDENTIFY_REPLY))){
+		g_sync_identified = TRUE;
+		return;
+	}
+	if(g_sync_identified && GSM_lineEquals_P(PSTR("OK"))){
+		g_sync_needed = FALSE;
+		g_engine_state = GSM_ENGINE_IDLE;
+	}
+	else if(GSM_lineEquals_P(PSTR("OK")) || GSM_lineEquals_P(PSTR("ERROR")) ||
+			GSM_lineStartsWith_P(PSTR("+CMS ERROR")) || GSM_lineStartsWith_P(PSTR("+CME ERROR"))){
+		g_stats.late_results++;
+	}
+	else{
+		g_stats.urcs += GSM_dispatchUrc();
+	}
+	g_sync_identified = FALSE;
 }
 
-void GSM_deleteAllMsgs(){
-	USART_sendString(DEL_ALL_MSGS_CMD);
+static char GSM_commandChar(const GSM_Command * cmd){
+	return cmd->command_in_flash ? (char)pgm_read_byte(&cmd->command[g_payload_index]) : cmd->command[g_payload_index];
 }
 
+static char GSM_payloadChar(const GSM_Command * cmd){
+	return cmd->payload_in_flash ? (char)pgm_read_byte(&cmd->payload[g_payload_index]) : cmd->payload[g_payload_index];
+}
+
+static void GSM_completeCmd(GSM_CmdStatus status){
+	GSM_DoneHandler on_done = g_cmd_queue[g_cmd_tail].on_done;
+	uint32 latency_ms = SYSTICK_elapsedMs(g_cmd_sent_ms);
+
+	if(status == GSM_CMD_OK){
+		g_stats.completed++;
+	}
+	else if(status == GSM_CMD_TIMEOUT){
+		g_stats.timeouts++;
+		g_sync_needed = TRUE;
+		g_sync_escape = (g_engine_state == GSM_ENGINE_WAIT_PROMPT) || (g_engine_state == GSM_ENGINE_SEND_PAYLOAD);
+	}
+	else{
+		g_stats.failed++;
+	}
+	g_stats.total_latency_ms += latency_ms;
+	if(latency_ms > g_stats.max_latency_ms){
+		g_stats.max_latency_ms = (latency_ms > 0xFFFF) ? 0xFFFF : (uint16)latency_ms;
+	}
+
+	/*free the slot before notifying so the handler can submit the next command*/
+	if((g_engine_state == GSM_ENGINE_SEND_CMD) && !g_cmd_queue[g_cmd_tail].command_in_flash){
+		g_cmd_text_busy = FALSE; /*expired before it was sent*/
+	}
+	g_cmd_tail = (g_cmd_tail + 1) % GSM_CMD_QUEUE_SIZE;
+	g_cmd_count--;
+	g_cmd_completed++;
+	g_engine_state = GSM_ENGINE_IDLE;
+	g_last_status = status;
+	if(on_done != NULL_PTR){
+		on_done(status);
+	}
+}
+
+static void GSM_processLine(void){
+	GSM_LineHandler on_line = g_cmd_queue[g_cmd_tail].on_line;
+
+	if(g_engine_state == GSM_ENGINE_IDLE){
+		g_stats.urcs += GSM_dispatchUrc();
+	}
+	else if(GSM_syncing()){
+		GSM_syncLine();
+	}
+	else if((g_engine_state == GSM_ENGINE_WAIT_PROMPT) && GSM_lineEquals_P(PSTR("DOWNLOAD"))){
+		GSM_startPayload(); /*AT+HTTPDATA prompts with a DOWNLOAD line instead of '>'*/
+	}
+	else if((on_line != NULL_PTR) && on_line()){
+		/*taken as command data*/
+	}
+	else if(GSM_lineEquals_P(PSTR("OK"))){
+		GSM_completeCmd(GSM_CMD_OK);
+	}
+	else if(GSM_lineEquals_P(PSTR("ERROR"))){
+		GSM_completeCmd(GSM_CMD_ERROR);
+	}
+	else if(GSM_lineStartsWith_P(PSTR("+CMS ERROR")) || GSM_lineStartsWith_P(PSTR("+CME ERROR"))){
+		GSM_completeCmd(GSM_CMD_CMS_ERROR);
+	}
+	else{
+		g_stats.urcs += GSM_dispatchUrc();
+	}
+}
+
+static void GSM_startPayload(void){
+	g_payload_index = 0;
+	g_engine_state = GSM_ENGINE_SEND_PAYLOAD;
+}
+
+static boolean GSM_lineEquals_P(PGM_P str){
+	return (GSM_lineLength() == strlen_P(str)) && GSM_lineStartsWith_P(str);
+}
 
+/*
+ * Description :
+ * Response lines of AT+CMGR: the header followed by the message text.
+ */
+static boolean GSM_readMsgLine(void){
+	if(g_read_expect_text){
+		GSM_lineCopy(g_read_text, REC_MSG_MAX_LENGTH);
+		g_read_expect_text = FALSE;
+		g_read_found = TRUE;
+		return TRUE;
+	}
+	if(GSM_lineStartsWith_P(PSTR("+CMGR:"))){
+		/* +CMGR: "REC UNREAD","+20XXXXXXXXXX","","23/12/01,10:00:00+08" */
+		GSM_lineGetField(1, g_read_sender, DIAL_NO_LENGTH);
+		g_read_expect_text = TRUE;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * Description :
+ * Response lines of AT+CMGL: a header per message followed by its text, streamed to the
+ * registered handler one message at a time so the listing is never buffered as a whole.
+ */
+static boolean GSM_listMsgLine(void){
+	char index[4];
+
+	if(g_list_expect_text){
+		g_list_expect_text = FALSE;
+		if((g_list_handler == NULL_PTR) || !g_list_handler(g_list_index, g_list_sender)){
+			g_list_refused = TRUE;
+		}
+		return TRUE;
+	}
+	if(GSM_lineStartsWith_P(PSTR("+CMGL:"))){
+		/* +CMGL: <index>,"REC UNREAD","+20XXXXXXXXXX","","23/12/01,10:00:00+08" */
+		GSM_lineGetField(0, index, sizeof(index));
+		g_list_index = (uint8)atoi(index);
+		GSM_lineGetField(2, g_list_sender, DIAL_NO_LENGTH);
+		g_list_expect_text = TRUE;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * Description :
+ * Response line of AT+CPMS?: +CPMS: "SM",<used>,<total>,"SM",<used>,<total>,...
+ */
+static boolean GSM_storageLine(void){
+	char number[4];
+
+	if(GSM_lineStartsWith_P(PSTR("+CPMS:"))){
+		GSM_lineGetField(1, number, sizeof(number));
+		g_storage_used = (uint8)atoi(number);
+		GSM_lineGetField(2, number, sizeof(number));
+		g_storage_total = (uint8)atoi(number);
+		return TRUE;
+	}
+	return FALSE;
+}
 
+/*+CCLK: "yy/MM/dd,hh:mm:ss+zz"*/
+static boolean GSM_clockLine(void){
+	char text[24];
+	uint8 length;
 
+	if(!GSM_lineStartsWith_P(PSTR("+CCLK:"))){
+		return FALSE;
+	}
+	length = GSM_lineGetField(0, text, sizeof(text));
+	if((length == 20) && (text[2] == '/') && (text[5] == '/') && (text[8] == ',') && (text[11] == ':')){
+		g_clock.year = (uint8)atoi(&text[0]);
+		g_clock.month = (uint8)atoi(&text[3]);
+		g_clock.day = (uint8)atoi(&text[6]);
+		g_clock.hour = (uint8)atoi(&text[9]);
+		g_clock.minute = (uint8)atoi(&text[12]);
+		g_clock.second = (uint8)atoi(&text[15]);
+		g_clock.zone = (sint8)atoi(&text[17]);
+		g_clock_valid = (g_clock.month >= 1) && (g_clock.month <= 12) && (g_clock.day >= 1);
+	}
+	return TRUE;
+}
@@ -11,18 +11,24 @@
 #include "../../Utils/std_types.h"
 #include "../../Utils/common_macros.h"
 #include "../../MCAL/USART/usart.h"
+#include "../../MCAL/Timer/systick.h"
+#include "gsm_urc.h"
+#include "gsm_outbox.h"
+#include "gsm_gprs.h"
+#include "gsm_http.h"
 #include <util/delay.h>
+#include <avr/pgmspace.h>
+#include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /*******************************************************************************
  *                                Definitions                                  *
  *******************************************************************************/
-#define MSG_BUFFER_SIZE 		256
-#define MSG_LOC_BUFFER_SIZE 	4
 #define DIAL_NO_LENGTH 			14
-#define REC_MSG_MAX_LENGTH		16
-#define TRANS_MSG_MAX_LENGTH    150
+#define REC_MSG_MAX_LENGTH		40		/*longest command: "GC1 -33.8688197 -151.2092955 65000"*/
+#define TRANS_MSG_MAX_LENGTH    110     /*longest alert: "Harsh acceleration 655.3 m/s2 (+65535): " and a 67 character location*/
 
 /*"E0" turns off the echoing of characters. When echoing is off,
  * the module will not repeat back the characters it receives from the host (MCU).
@@ -33,18 +39,190 @@
 #define SEND_MSG_CMD		"AT+CMGS="
 #define DELETE_MSG_CMD		"AT+CMGD="
 #define DEL_ALL_MSGS_CMD	"AT+CMGDA=\"DEL ALL\"\r"
+#define DEL_READ_MSGS_CMD	"AT+CMGDA=\"DEL READ\"\r"
+#define LIST_MSGS_CMD		"AT+CMGL="
+#define STORAGE_STATUS_CMD	"AT+CPMS?\r"
+#define CLOCK_QUERY_CMD		"AT+CCLK?\r"
+#define CLOCK_SET_CMD		"AT+CCLK="
+#define IDENTIFY_CMD		"ATI\r"
+#define IDENTIFY_REPLY		"SIM900 R"	/*product line answered to ATI, "SIM900 R11.0"*/
+
+/*AT+CMGL <stat> values (text mode)*/
+#define MSG_STAT_UNREAD		"REC UNREAD"
+#define MSG_STAT_READ		"REC READ"
+#define MSG_STAT_ALL		"ALL"
+
+#define CTRL_Z_CHARACTER	0x1A /*terminates the text entered after the '>' prompt*/
+#define ESC_CHARACTER		0x1B /*cancels the text entered after the '>' prompt*/
+
+/*AT transaction engine configuration*/
+#define GSM_CMD_QUEUE_SIZE		2	/*number of commands waiting for the modem (13 bytes of RAM each)*/
+#define GSM_CMD_MAX_LENGTH		48	/*longest copied or formatted command (including "\r" and null terminator)*/
+#define GSM_DEFAULT_TIMEOUT_MS	1000
+#define GSM_PROMPT_TIMEOUT_MS	5000	/*time allowed for the '>' prompt of AT+CMGS*/
+#define GSM_READ_TIMEOUT_MS		5000
+#define GSM_SMS_TIMEOUT_MS		60000	/*AT+CMGS maximum response time (SIM900 AT manual)*/
+#define GSM_LIST_TIMEOUT_MS		20000	/*a full SIM listing streams for a while at 9600 baud*/
+#define GSM_DELETE_TIMEOUT_MS	25000	/*AT+CMGDA on a full SIM*/
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef enum{
+	GSM_CMD_PENDING, GSM_CMD_OK, GSM_CMD_ERROR, GSM_CMD_CMS_ERROR, GSM_CMD_TIMEOUT
+}GSM_CmdStatus;
+
+/*
+ * Called for every response line of the active command that is not a final result code.
+ * The line is the oldest complete line of the receive ring (use the GSM_line* helpers).
+ * Return TRUE if the line was taken as command data so it is not matched any further
+ * (e.g. the text line after +CMGR that could read "OK").
+ */
+typedef boolean (*GSM_LineHandler)(void);
+
+/*Called once when the command completes, fails or times out*/
+typedef void (*GSM_DoneHandler)(GSM_CmdStatus status);
+
+/*
+ * Called by GSM_listMsgs() for every listed message as soon as its text line arrives. The text
+ * is the oldest line of the receive ring, copied out with GSM_lineCopy() (it is not copied
+ * before). Return FALSE if the message could not be taken (the caller then must not delete it).
+ */
+typedef boolean (*GSM_MsgHandler)(uint8 index, const char * sender_number);
+
+/*
+ * Engine counters, for measuring command throughput and modem latency on the bench
+ * (latency runs from the command being sent until its final response).
+ */
+typedef struct{
+	uint16 completed;			/*commands ended by OK*/
+	uint16 failed;				/*ERROR, +CMS ERROR or +CME ERROR*/
+	uint16 timeouts;
+	uint16 late_results;		/*final results discarded while resynchronising after a timeout*/
+	uint16 urcs;				/*unsolicited lines handed to the URC dispatcher*/
+	uint16 max_latency_ms;
+	uint32 total_latency_ms;	/*divide by the number of commands for the average*/
+}GSM_EngineStats;
+
+/*
+ * Modem real time clock, as "yy/MM/dd,hh:mm:ss+zz" in AT+CCLK: local time with the zone in
+ * quarters of an hour from UTC (UTC = local time - zone x 15 minutes).
+ */
+typedef struct{
+	uint8 year;				/*since 2000*/
+	uint8 month;
+	uint8 day;
+	uint8 hour;
+	uint8 minute;
+	uint8 second;
+	sint8 zone;				/*quarters of an hour*/
+}GSM_Clock;
 
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
 
-boolean GSM_init(char * message_buffer);
-boolean GSM_isMsgReceived(char * message_buffer, char * message_location);
-boolean GSM_readMsgContents(char * message_location, char * message_buffer, char * sender_number, char * recieved_message);
-void GSM_sendMsg(char * number, char * message_to_send, char * message_buffer, char * buff_ptr);
-void GSM_deleteMsg(char *message_location);
+/*
+ * AT transaction engine:
+ * Commands are queued with GSM_submitCmd() and sent one at a time by GSM_task(), which must
+ * be called from the main loop. A command completes as soon as its final result code
+ * (OK / ERROR / +CMS ERROR / +CME ERROR) arrives or when its timeout expires. After a timeout
+ * the next command waits until ATI has been answered, so a late result cannot end it. If a
+ * payload is given, it is sent after the '>' prompt (or DOWNLOAD line of AT+HTTPDATA)
+ * followed by Ctrl+Z for text payloads (AT+CMGS).
+ * Lines that are not part of the active command go to the URC dispatcher (gsm_urc.h).
+ * The payload is not copied, it must stay valid until the command completes.
+ * GSM_submitCmd_P() takes the command from the flash (PSTR()), for the fixed commands, it is
+ * not copied either.
+ * GSM_submitCmd() copies the command and GSM_submitCmdFormat_P() formats it (printf format in
+ * the flash) into one buffer shared by the queue, held until the command is sent: a second
+ * one is refused like a full queue meanwhile, and like a command that does not fit.
+ * GSM_submitCmdText_P() is GSM_submitCmdFormat_P() with the text payload in the flash, for the
+ * fixed replies.
+ */
+boolean GSM_submitCmd(const char * command, const char * payload, uint16 timeout_ms,
+		GSM_LineHandler on_line, GSM_DoneHandler on_done);
+boolean GSM_submitCmd_P(PGM_P command, const char * payload, uint16 timeout_ms,
+		GSM_LineHandler on_line, GSM_DoneHandler on_done);
+boolean GSM_submitCmdFormat_P(const char * payload, uint16 timeout_ms, GSM_LineHandler on_line,
+		GSM_DoneHandler on_done, PGM_P format, ...);
+boolean GSM_submitCmdText_P(PGM_P text, uint16 timeout_ms, GSM_LineHandler on_line,
+		GSM_DoneHandler on_done, PGM_P format, ...);
+
+/*Same as GSM_submitCmd() with a binary payload of a fixed length sent after '>' without Ctrl+Z*/
+boolean GSM_submitData(const char * command, const uint8 * data, uint8 length, uint16 timeout_ms,
+		GSM_LineHandler on_line, GSM_DoneHandler on_done);
+
+/*
+ * Complete the active command from its line handler, for commands whose final response
+ * is not a result code (the IP line of AT+CIFSR, SEND OK of AT+CIPSEND).
+ */
+void GSM_endCmd(GSM_CmdStatus status);
+void GSM_task(void);
+boolean GSM_isIdle(void);
+
+/*
+ * Keep queued commands from being started (the USART is routed away from the modem).
+ * Only set while no command is in progress. GSM_execute() must not be used while held.
+ */
+void GSM_hold(boolean hold);
+boolean GSM_cmdInProgress(void);
+uint8 GSM_queuedCmds(void);
+GSM_CmdStatus GSM_getLastStatus(void);
+void GSM_getStats(GSM_EngineStats * stats);
+void GSM_resetStats(void);
+
+/*Submit a command and run the engine until it completes (for boot time and simple flows)*/
+GSM_CmdStatus GSM_execute(const char * command, const char * payload, uint16 timeout_ms, GSM_LineHandler on_line);
+
+/*
+ * Modem responses are read line by line, in place, from the USART receive ring buffer.
+ * Nothing is copied out of the ring except the fields the caller asks for.
+ */
+boolean GSM_init(void);
+boolean GSM_readMsgContents(uint8 message_index, char * sender_number, char * recieved_message);
+boolean GSM_sendMsg(char * number, char * message_to_send);
+boolean GSM_deleteMsg(uint8 message_index, GSM_DoneHandler on_done);
 void GSM_deleteAllMsgs(void);
 
-void GSM_StoreToBuff(char * buffer, const char * const_string);
+/*
+ * Batch inbox processing (all asynchronous, driven by GSM_task()):
+ * GSM_listMsgs() lists the messages with the given <stat> in one AT+CMGL round trip and
+ * streams each one to on_msg. Listed unread messages become "REC READ" in the SIM, so a
+ * following GSM_deleteReadMsgs() clears every processed slot with one AT+CMGDA while
+ * messages that arrived in the meantime survive. GSM_deleteReadMsgs() is refused (FALSE)
+ * after a listing in which on_msg did not take every message, GSM_listAllTaken() tells it:
+ * those messages must then be deleted one by one.
+ * GSM_queryStorage() refreshes the SIM occupancy returned by GSM_getStorageUsed/Total().
+ */
+boolean GSM_listMsgs(const char * stat, GSM_MsgHandler on_msg, GSM_DoneHandler on_done);
+boolean GSM_deleteReadMsgs(GSM_DoneHandler on_done);
+boolean GSM_listAllTaken(void);
+boolean GSM_queryStorage(GSM_DoneHandler on_done);
+uint8 GSM_getStorageUsed(void);
+uint8 GSM_getStorageTotal(void);
+
+/*
+ * Modem clock (kept across power cycles by the module RTC while its backup supply holds):
+ * GSM_queryClock() reads it with AT+CCLK?, GSM_getClock() returns FALSE until a reading
+ * parsed. GSM_setClock() sets it, the clock passed stays owned by the caller.
+ */
+boolean GSM_queryClock(GSM_DoneHandler on_done);
+boolean GSM_getClock(GSM_Clock * clock);
+boolean GSM_setClock(const GSM_Clock * clock, GSM_DoneHandler on_done);
+
+/*
+ * Helpers working on the oldest complete line of the receive ring (see usart.h).
+ * GSM_lineLength() excludes the trailing "\r\n".
+ * GSM_lineStartsWith_P() compares with a prefix in the flash (PSTR()).
+ * GSM_lineGetField() copies the comma separated field with the given index found after
+ * the ':' of a "+XXXX: a,b,c" response (quotes stripped, commas inside quotes kept).
+ * GSM_lineCopy() copies the whole line (truncated to max_length - 1 characters).
+ */
+uint8 GSM_lineLength(void);
+boolean GSM_lineStartsWith_P(PGM_P prefix);
+uint8 GSM_lineGetField(uint8 field_index, char * field, uint8 max_length);
+uint8 GSM_lineCopy(char * line, uint8 max_length);
 
 #endif /* GSM_H_ */
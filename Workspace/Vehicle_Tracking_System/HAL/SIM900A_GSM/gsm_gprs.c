@@ -0,0 +1,244 @@
+/*
+ * gsm_gprs.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Bring-up sequence: AT+CIPSHUT -> AT+CSTT -> AT+CIICR -> AT+CIFSR -> AT+CIPSTART.
+ *  Every step is submitted by GPRS_task() once the previous one completed, the link
+ *  state then follows the CONNECT OK / CLOSED / +PDP: DEACT URCs.
+ */
+
+#include "gsm.h"
+#include "gsm_gprs.h"
+#include "../UART_Arbiter/uart_arbiter.h"
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static const GPRS_ConfigType * g_gprs_config;			/*in the flash*/
+static GPRS_State g_gprs_state = GPRS_DOWN;
+static uint8 g_gprs_step;						/*bring-up step in progress*/
+static boolean g_gprs_cmd_busy = FALSE;			/*a bring-up/connect command is queued*/
+static uint32 g_gprs_retry_ms = 0;				/*time stamp of the last failure*/
+static uint32 g_gprs_backoff_ms = 0;
+static uint32 g_gprs_connect_ms;
+static void (*g_gprs_send_done)(boolean sent) = NULL_PTR;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void GPRS_submitStep(void);
+static void GPRS_stepDone(GSM_CmdStatus status);
+static void GPRS_startDone(GSM_CmdStatus status);
+static void GPRS_fail(GPRS_State fallback);
+static boolean GPRS_shutLine(void);
+static boolean GPRS_ipLine(void);
+static boolean GPRS_sendLine(void);
+static void GPRS_sendDone(GSM_CmdStatus status);
+static void GPRS_linkEvent(const GSM_UrcData * urc);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void GPRS_init(const GPRS_ConfigType * a_configPtr){
+	g_gprs_config = a_configPtr;
+	g_gprs_state = GPRS_DOWN;
+	GSM_setUrcHandler(GSM_URC_CONNECT_OK, GPRS_linkEvent);
+	GSM_setUrcHandler(GSM_URC_ALREADY_CONNECT, GPRS_linkEvent);
+	GSM_setUrcHandler(GSM_URC_CONNECT_FAIL, GPRS_linkEvent);
+	GSM_setUrcHandler(GSM_URC_CLOSED, GPRS_linkEvent);
+	GSM_setUrcHandler(GSM_URC_PDP_DEACT, GPRS_linkEvent);
+}
+
+void GPRS_task(void){
+	if((g_gprs_config == NULL_PTR) || g_gprs_cmd_busy){
+		return;
+	}
+	switch(g_gprs_state){
+	case GPRS_DOWN:
+		if(SYSTICK_elapsedMs(g_gprs_retry_ms) >= g_gprs_backoff_ms){
+			g_gprs_step = 0;
+			g_gprs_state = GPRS_BRINGING_UP;
+			GPRS_submitStep();
+		}
+		break;
+	case GPRS_BRINGING_UP:
+		GPRS_submitStep();
+		break;
+	case GPRS_BEARER_UP:
+		if(SYSTICK_elapsedMs(g_gprs_retry_ms) >= g_gprs_backoff_ms){
+			if(GSM_submitCmdFormat_P(NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR, GPRS_startDone,
+					PSTR(GPRS_START_CMD "\"TCP\",\"%S\",\"%u\"\r"), pgm_read_ptr(&g_gprs_config->host),
+					pgm_read_word(&g_gprs_config->port))){
+				g_gprs_cmd_busy = TRUE;
+				g_gprs_state = GPRS_CONNECTING;
+				g_gprs_connect_ms = SYSTICK_getMs();
+				ARBITER_awaitUrc(ARBITER_URC_GPRS, TRUE); /*CONNECT OK / CONNECT FAIL*/
+			}
+		}
+		break;
+	case GPRS_CONNECTING:
+		if(SYSTICK_elapsedMs(g_gprs_connect_ms) >= GPRS_CONNECT_TIMEOUT_MS){
+			GPRS_fail(GPRS_DOWN); /*no CONNECT OK/FAIL at all, restart the bearer*/
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+GPRS_State GPRS_getState(void){
+	return g_gprs_state;
+}
+
+boolean GPRS_isConnected(void){
+	return (g_gprs_state == GPRS_CONNECTED);
+}
+
+boolean GPRS_send(const uint8 * data, uint8 length, void (*on_done)(boolean sent)){
+	char send_command[16];
+
+	if(!GPRS_isConnected() || (g_gprs_send_done != NULL_PTR)){
+		return FALSE;
+	}
+	sprintf_P(send_command, PSTR(GPRS_SEND_CMD "%u\r"), length);
+	if(!GSM_submitData(send_command, data, length, GPRS_SEND_TIMEOUT_MS, GPRS_sendLine, GPRS_sendDone)){
+		return FALSE;
+	}
+	g_gprs_send_done = on_done;
+	return TRUE;
+}
+
+static void GPRS_submitStep(void){
+	boolean submitted = FALSE;
+
+	switch(g_gprs_step){
+	case 0:
+		submitted = GSM_submitCmd_P(PSTR(GPRS_SHUT_CMD), NULL_PTR, GPRS_SHUT_TIMEOUT_MS, GPRS_shutLine, GPRS_stepDone);
+		break;
+	case 1:
+		submitted = GSM_submitCmdFormat_P(NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR, GPRS_stepDone,
+				PSTR(GPRS_SET_APN_CMD "\"%S\"\r"), pgm_read_ptr(&g_gprs_config->apn));
+		break;
+	case 2:
+		submitted = GSM_submitCmd_P(PSTR(GPRS_BRING_UP_CMD), NULL_PTR, GPRS_BRING_UP_TIMEOUT_MS, NULL_PTR, GPRS_stepDone);
+		break;
+	case 3:
+		submitted = GSM_submitCmd_P(PSTR(GPRS_GET_IP_CMD), NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, GPRS_ipLine, GPRS_stepDone);
+		break;
+	default:
+		/*bearer is up, the socket is opened by GPRS_task()*/
+		g_gprs_state = GPRS_BEARER_UP;
+		g_gprs_backoff_ms = 0;
+		return;
+	}
+	g_gprs_cmd_busy = submitted;
+	if(!submitted){
+		GPRS_fail(GPRS_DOWN); /*engine queue full, try again later*/
+	}
+}
+
+static void GPRS_stepDone(GSM_CmdStatus status){
+	g_gprs_cmd_busy = FALSE;
+	if(status != GSM_CMD_OK){
+		GPRS_fail(GPRS_DOWN);
+		return;
+	}
+	g_gprs_step++; /*submitted by the next GPRS_task() call*/
+}
+
+static void GPRS_startDone(GSM_CmdStatus status){
+	g_gprs_cmd_busy = FALSE;
+	if((status != GSM_CMD_OK) && (g_gprs_state == GPRS_CONNECTING)){
+		GPRS_fail(GPRS_DOWN);
+	}
+	/*else wait for the CONNECT OK / CONNECT FAIL URC*/
+}
+
+static void GPRS_fail(GPRS_State fallback){
+	g_gprs_state = fallback;
+	ARBITER_awaitUrc(ARBITER_URC_GPRS, FALSE);
+	g_gprs_retry_ms = SYSTICK_getMs();
+	if(g_gprs_backoff_ms == 0){
+		g_gprs_backoff_ms = GPRS_RETRY_MIN_MS;
+	}
+	else if(g_gprs_backoff_ms < GPRS_RETRY_MAX_MS){
+		g_gprs_backoff_ms <<= 1;
+		if(g_gprs_backoff_ms > GPRS_RETRY_MAX_MS){
+			g_gprs_backoff_ms = GPRS_RETRY_MAX_MS; /*5 s doubled runs past it (160 s)*/
+		}
+	}
+}
+
+/*AT+CIPSHUT answers SHUT OK instead of OK*/
+static boolean GPRS_shutLine(void){
+	if(GSM_lineStartsWith_P(PSTR("SHUT OK"))){
+		GSM_endCmd(GSM_CMD_OK);
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/*AT+CIFSR answers with the local IP address only*/
+static boolean GPRS_ipLine(void){
+	uint8 first = USART_rxPeek(0);
+
+	if((first >= '0') && (first <= '9')){
+		GSM_endCmd(GSM_CMD_OK);
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/*AT+CIPSEND answers SEND OK / SEND FAIL (or DATA ACCEPT in quick send mode)*/
+static boolean GPRS_sendLine(void){
+	if(GSM_lineStartsWith_P(PSTR("SEND OK")) || GSM_lineStartsWith_P(PSTR("DATA ACCEPT"))){
+		GSM_endCmd(GSM_CMD_OK);
+		return TRUE;
+	}
+	if(GSM_lineStartsWith_P(PSTR("SEND FAIL"))){
+		GSM_endCmd(GSM_CMD_ERROR);
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static void GPRS_sendDone(GSM_CmdStatus status){
+	void (*on_done)(boolean sent) = g_gprs_send_done;
+
+	g_gprs_send_done = NULL_PTR;
+	if((status != GSM_CMD_OK) && (g_gprs_state == GPRS_CONNECTED)){
+		GPRS_fail(GPRS_BEARER_UP); /*reopen the socket*/
+	}
+	if(on_done != NULL_PTR){
+		on_done(status == GSM_CMD_OK);
+	}
+}
+
+static void GPRS_linkEvent(const GSM_UrcData * urc){
+	switch(urc->id){
+	case GSM_URC_CONNECT_OK:
+	case GSM_URC_ALREADY_CONNECT:
+		if(g_gprs_state == GPRS_CONNECTING){
+			g_gprs_state = GPRS_CONNECTED;
+			ARBITER_awaitUrc(ARBITER_URC_GPRS, FALSE);
+			g_gprs_backoff_ms = 0;
+		}
+		break;
+	case GSM_URC_CONNECT_FAIL:
+	case GSM_URC_CLOSED:
+		if((g_gprs_state == GPRS_CONNECTING) || (g_gprs_state == GPRS_CONNECTED)){
+			GPRS_fail(GPRS_BEARER_UP);
+		}
+		break;
+	case GSM_URC_PDP_DEACT:
+		GPRS_fail(GPRS_DOWN);
+		break;
+	default:
+		break;
+	}
+}
@@ -0,0 +1,73 @@
+/*
+ * gsm_gprs.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Persistent GPRS TCP connection of the SIM900A (single connection, non transparent mode).
+ */
+
+#ifndef GSM_GPRS_H_
+#define GSM_GPRS_H_
+
+#include "../../Utils/std_types.h"
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define GPRS_SHUT_CMD				"AT+CIPSHUT\r"
+#define GPRS_SET_APN_CMD			"AT+CSTT="
+#define GPRS_BRING_UP_CMD			"AT+CIICR\r"
+#define GPRS_GET_IP_CMD				"AT+CIFSR\r"
+#define GPRS_START_CMD				"AT+CIPSTART="
+#define GPRS_SEND_CMD				"AT+CIPSEND="
+
+#define GPRS_SHUT_TIMEOUT_MS		65000	/*response times from the SIM900 AT manual*/
+#define GPRS_BRING_UP_TIMEOUT_MS	65000	/*AT+CIICR can take up to 85s, bounded by the uint16 timeout*/
+#define GPRS_CONNECT_TIMEOUT_MS		65000	/*wait for CONNECT OK after AT+CIPSTART*/
+#define GPRS_SEND_TIMEOUT_MS		30000
+#define GPRS_RETRY_MIN_MS			5000	/*reconnection back-off, doubled after every failure*/
+#define GPRS_RETRY_MAX_MS			120000
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef enum{
+	GPRS_DOWN, GPRS_BRINGING_UP, GPRS_BEARER_UP, GPRS_CONNECTING, GPRS_CONNECTED
+}GPRS_State;
+
+/*
+ * Bearer and server of the telemetry connection. The configuration and its strings are kept
+ * in the flash (PROGMEM) and not copied.
+ * The resulting AT+CSTT / AT+CIPSTART commands must fit in GSM_CMD_MAX_LENGTH,
+ * so use the server IP address (a LAN listener works the same as the real server).
+ */
+typedef struct{
+	PGM_P apn;
+	PGM_P host;
+	uint16 port;
+}GPRS_ConfigType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+void GPRS_init(const GPRS_ConfigType * a_configPtr);
+
+/*Keep the bearer and the socket up, reconnecting with back-off. Call from the main loop.*/
+void GPRS_task(void);
+
+GPRS_State GPRS_getState(void);
+boolean GPRS_isConnected(void);
+
+/*
+ * Send length raw bytes on the socket (AT+CIPSEND=<length>). The data is not copied and
+ * must stay valid until on_done is called. Returns FALSE if not connected or a send is
+ * already in flight.
+ */
+boolean GPRS_send(const uint8 * data, uint8 length, void (*on_done)(boolean sent));
+
+#endif /* GSM_GPRS_H_ */
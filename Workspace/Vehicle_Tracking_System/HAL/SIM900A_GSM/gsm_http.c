@@ -0,0 +1,251 @@
+/*
+ * gsm_http.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Set-up sequence: AT+HTTPTERM -> AT+SAPBR=0,1 (both only clean up, result ignored) ->
+ *  AT+SAPBR=3,1,"CONTYPE","GPRS" -> AT+SAPBR=3,1,"APN",<apn> -> AT+SAPBR=1,1 ->
+ *  AT+HTTPINIT -> AT+HTTPPARA="CID",1 -> AT+HTTPPARA="URL",<url> ->
+ *  AT+HTTPPARA="CONTENT",<HTTP_CONTENT_TYPE>.
+ *  A POST is AT+HTTPDATA=<length>,<time> with the raw body, then AT+HTTPACTION=1 and the
+ *  +HTTPACTION: 1,<status>,<length> URC. The session stays open between POSTs, so a batch
+ *  costs two commands instead of a full connection set-up.
+ */
+
+#include "gsm.h"
+#include "gsm_http.h"
+#include "../UART_Arbiter/uart_arbiter.h"
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+typedef enum{
+	HTTP_DOWN, HTTP_SETTING_UP, HTTP_READY, HTTP_SENDING_BODY, HTTP_WAIT_ACTION
+}HTTP_State;
+
+static const HTTP_ConfigType * g_http_config;			/*in the flash*/
+static HTTP_State g_http_state = HTTP_DOWN;
+static uint8 g_http_step;						/*set-up step in progress*/
+static boolean g_http_cmd_busy = FALSE;			/*a set-up command is queued*/
+static uint8 g_http_post_errors = 0;			/*POSTs answered ERROR since the last +HTTPACTION*/
+static uint32 g_http_retry_ms = 0;				/*time stamp of the last failure*/
+static uint32 g_http_backoff_ms = 0;
+static uint32 g_http_action_ms;
+static uint16 g_http_last_status = 0;
+static void (*g_http_post_done)(boolean sent) = NULL_PTR;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void HTTP_submitStep(void);
+static void HTTP_stepDone(GSM_CmdStatus status);
+static void HTTP_dataDone(GSM_CmdStatus status);
+static void HTTP_actionDone(GSM_CmdStatus status);
+static void HTTP_actionEvent(const GSM_UrcData * urc);
+static void HTTP_postFailed(GSM_CmdStatus status);
+static void HTTP_finishPost(boolean sent);
+static void HTTP_fail(void);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void HTTP_init(const HTTP_ConfigType * a_configPtr){
+	g_http_config = a_configPtr;
+	g_http_state = HTTP_DOWN;
+	GSM_setUrcHandler(GSM_URC_HTTPACTION, HTTP_actionEvent);
+}
+
+void HTTP_task(void){
+	if((g_http_config == NULL_PTR) || g_http_cmd_busy){
+		return;
+	}
+	switch(g_http_state){
+	case HTTP_DOWN:
+		if(SYSTICK_elapsedMs(g_http_retry_ms) >= g_http_backoff_ms){
+			g_http_step = 0;
+			g_http_state = HTTP_SETTING_UP;
+			HTTP_submitStep();
+		}
+		break;
+	case HTTP_SETTING_UP:
+		HTTP_submitStep();
+		break;
+	case HTTP_WAIT_ACTION:
+		if(SYSTICK_elapsedMs(g_http_action_ms) >= HTTP_ACTION_TIMEOUT_MS){
+			g_http_last_status = 0;
+			HTTP_fail(); /*the session is in an unknown state, set it up again*/
+			HTTP_finishPost(FALSE);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+boolean HTTP_isReady(void){
+	return (g_http_state == HTTP_READY);
+}
+
+boolean HTTP_post(const uint8 * data, uint8 length, void (*on_done)(boolean sent)){
+	char data_command[24];
+
+	if(!HTTP_isReady()){
+		return FALSE;
+	}
+	sprintf_P(data_command, PSTR(HTTP_DATA_CMD "%u,%u\r"), length, HTTP_DATA_INPUT_MS);
+	if(!GSM_submitData(data_command, data, length, GSM_PROMPT_TIMEOUT_MS, NULL_PTR, HTTP_dataDone)){
+		return FALSE;
+	}
+	g_http_post_done = on_done;
+	g_http_state = HTTP_SENDING_BODY;
+	return TRUE;
+}
+
+uint16 HTTP_getLastStatus(void){
+	return g_http_last_status;
+}
+
+static void HTTP_submitStep(void){
+	boolean submitted = FALSE;
+
+	switch(g_http_step){
+	case 0:
+		submitted = GSM_submitCmd_P(PSTR(HTTP_TERM_CMD), NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR, HTTP_stepDone);
+		break;
+	case 1:
+		submitted = GSM_submitCmd_P(PSTR(HTTP_BEARER_CMD "0,1\r"), NULL_PTR, HTTP_BEARER_TIMEOUT_MS, NULL_PTR, HTTP_stepDone);
+		break;
+	case 2:
+		submitted = GSM_submitCmd_P(PSTR(HTTP_BEARER_CMD "3,1,\"CONTYPE\",\"GPRS\"\r"), NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR, HTTP_stepDone);
+		break;
+	case 3:
+		submitted = GSM_submitCmdFormat_P(NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR, HTTP_stepDone,
+				PSTR(HTTP_BEARER_CMD "3,1,\"APN\",\"%S\"\r"), pgm_read_ptr(&g_http_config->apn));
+		break;
+	case 4:
+		submitted = GSM_submitCmd_P(PSTR(HTTP_BEARER_CMD "1,1\r"), NULL_PTR, HTTP_BEARER_TIMEOUT_MS, NULL_PTR, HTTP_stepDone);
+		break;
+	case 5:
+		submitted = GSM_submitCmd_P(PSTR(HTTP_INIT_CMD), NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR, HTTP_stepDone);
+		break;
+	case 6:
+		submitted = GSM_submitCmd_P(PSTR(HTTP_PARA_CMD "\"CID\",1\r"), NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR, HTTP_stepDone);
+		break;
+	case 7:
+		/*refused if the URL does not fit in a command*/
+		submitted = GSM_submitCmdFormat_P(NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR, HTTP_stepDone,
+				PSTR(HTTP_PARA_CMD "\"URL\",\"%S\"\r"), pgm_read_ptr(&g_http_config->url));
+		break;
+	case 8:
+		submitted = GSM_submitCmd_P(PSTR(HTTP_PARA_CMD "\"CONTENT\",\"" HTTP_CONTENT_TYPE "\"\r"), NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR, HTTP_stepDone);
+		break;
+	default:
+		/*session is up, POSTs are accepted*/
+		g_http_state = HTTP_READY;
+		g_http_backoff_ms = 0;
+		return;
+	}
+	g_http_cmd_busy = submitted;
+	if(!submitted){
+		HTTP_fail(); /*engine queue full, try again later*/
+	}
+}
+
+static void HTTP_stepDone(GSM_CmdStatus status){
+	g_http_cmd_busy = FALSE;
+	if(g_http_state != HTTP_SETTING_UP){
+		return; /*bearer lost meanwhile*/
+	}
+	if((status != GSM_CMD_OK) && (g_http_step > 1)){
+		HTTP_fail();
+		return;
+	}
+	g_http_step++; /*submitted by the next HTTP_task() call*/
+}
+
+static void HTTP_dataDone(GSM_CmdStatus status){
+	if(g_http_state != HTTP_SENDING_BODY){
+		return;
+	}
+	if(status != GSM_CMD_OK){
+		HTTP_postFailed(status);
+		return;
+	}
+	if(!GSM_submitCmd_P(PSTR(HTTP_POST_CMD), NULL_PTR, GSM_DEFAULT_TIMEOUT_MS, NULL_PTR, HTTP_actionDone)){
+		HTTP_postFailed(GSM_CMD_ERROR); /*engine queue full, the session is fine*/
+		return;
+	}
+	g_http_state = HTTP_WAIT_ACTION;
+	g_http_action_ms = SYSTICK_getMs();
+	ARBITER_awaitUrc(ARBITER_URC_HTTP, TRUE); /*+HTTPACTION*/
+}
+
+static void HTTP_actionDone(GSM_CmdStatus status){
+	if((status != GSM_CMD_OK) && (g_http_state == HTTP_WAIT_ACTION)){
+		HTTP_postFailed(status);
+	}
+	/*else wait for the +HTTPACTION URC*/
+}
+
+static void HTTP_actionEvent(const GSM_UrcData * urc){
+	if(g_http_state != HTTP_WAIT_ACTION){
+		return;
+	}
+	g_http_last_status = (uint16)urc->value;
+	g_http_post_errors = 0;
+	if(urc->value >= 600){
+		HTTP_fail(); /*6xx are modem side errors (bearer lost, DNS, timeout)*/
+	}
+	else{
+		g_http_state = HTTP_READY;
+		ARBITER_awaitUrc(ARBITER_URC_HTTP, FALSE);
+	}
+	HTTP_finishPost((urc->value >= 200) && (urc->value < 300));
+}
+
+/*
+ * Description :
+ * AT+HTTPDATA or AT+HTTPACTION failed. An ERROR leaves the session as it is (the POST is
+ * reported failed and the next one goes on it), a timeout or HTTP_POST_ERRORS_MAX errors in
+ * a row leave it in an unknown state and it is set up again.
+ */
+static void HTTP_postFailed(GSM_CmdStatus status){
+	g_http_last_status = 0;
+	if((status == GSM_CMD_ERROR) && (++g_http_post_errors < HTTP_POST_ERRORS_MAX)){
+		g_http_state = HTTP_READY;
+		ARBITER_awaitUrc(ARBITER_URC_HTTP, FALSE);
+	}
+	else{
+		HTTP_fail();
+	}
+	HTTP_finishPost(FALSE);
+}
+
+static void HTTP_finishPost(boolean sent){
+	void (*on_done)(boolean sent) = g_http_post_done;
+
+	g_http_post_done = NULL_PTR;
+	if(on_done != NULL_PTR){
+		on_done(sent);
+	}
+}
+
+static void HTTP_fail(void){
+	g_http_state = HTTP_DOWN;
+	g_http_post_errors = 0;
+	ARBITER_awaitUrc(ARBITER_URC_HTTP, FALSE);
+	g_http_retry_ms = SYSTICK_getMs();
+	if(g_http_backoff_ms == 0){
+		g_http_backoff_ms = HTTP_RETRY_MIN_MS;
+	}
+	else if(g_http_backoff_ms < HTTP_RETRY_MAX_MS){
+		g_http_backoff_ms <<= 1;
+		if(g_http_backoff_ms > HTTP_RETRY_MAX_MS){
+			g_http_backoff_ms = HTTP_RETRY_MAX_MS; /*5 s doubled runs past it (160 s)*/
+		}
+	}
+}
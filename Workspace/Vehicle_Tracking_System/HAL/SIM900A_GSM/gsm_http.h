@@ -0,0 +1,73 @@
+/*
+ * gsm_http.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  HTTP POST uploads through the SIM900A internal HTTP stack (AT+SAPBR / AT+HTTP*).
+ */
+
+#ifndef GSM_HTTP_H_
+#define GSM_HTTP_H_
+
+#include "../../Utils/std_types.h"
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define HTTP_BEARER_CMD				"AT+SAPBR="
+#define HTTP_INIT_CMD				"AT+HTTPINIT\r"
+#define HTTP_TERM_CMD				"AT+HTTPTERM\r"
+#define HTTP_PARA_CMD				"AT+HTTPPARA="
+#define HTTP_DATA_CMD				"AT+HTTPDATA="
+#define HTTP_POST_CMD				"AT+HTTPACTION=1\r"
+#define HTTP_CONTENT_TYPE			"application/octet-stream"
+
+#define HTTP_BEARER_TIMEOUT_MS		65000	/*AT+SAPBR=1,1 can take up to 85s, bounded by the uint16 timeout*/
+#define HTTP_DATA_INPUT_MS			10000	/*time given to the modem to receive the body*/
+#define HTTP_ACTION_TIMEOUT_MS		60000	/*wait for +HTTPACTION after AT+HTTPACTION*/
+#define HTTP_RETRY_MIN_MS			5000	/*set-up back-off, doubled after every failure*/
+#define HTTP_RETRY_MAX_MS			120000
+#define HTTP_POST_ERRORS_MAX		3		/*POSTs answered ERROR in a row before the session is set up again*/
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+/*
+ * Bearer and upload end point, in the flash (PROGMEM) with its strings, not copied.
+ * The AT+HTTPPARA="URL" command
+ * must fit in GSM_CMD_MAX_LENGTH, which leaves 26 characters for the URL, so use the
+ * server IP address (e.g. "http://10.0.0.2:8080/t"). A local HTTP listener works the same
+ * as the real back-end.
+ */
+typedef struct{
+	PGM_P apn;
+	PGM_P url;
+}HTTP_ConfigType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+void HTTP_init(const HTTP_ConfigType * a_configPtr);
+
+/*Open the bearer and the HTTP session, expire stuck requests. Call from the main loop.*/
+void HTTP_task(void);
+
+/*TRUE once the bearer and the HTTP session are set up and no POST is in flight*/
+boolean HTTP_isReady(void);
+
+/*
+ * POST length bytes as HTTP_CONTENT_TYPE (set with the session), the server reads them as
+ * raw bytes. The data is not copied and must stay valid until on_done reports the outcome
+ * (TRUE for a 2xx status).
+ */
+boolean HTTP_post(const uint8 * data, uint8 length, void (*on_done)(boolean sent));
+
+/*HTTP status of the last completed POST (0 if it never got an answer)*/
+uint16 HTTP_getLastStatus(void);
+
+#endif /* GSM_HTTP_H_ */
@@ -0,0 +1,232 @@
+/*
+ * gsm_outbox.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  One AT+CMGS is in flight at a time (the modem handles one), the next one is submitted
+ *  by the following GSM_outboxTask() call (not from the completion callback, which runs
+ *  deep in the engine stack) so consecutive recipients cost one modem round trip each. A failed send goes back to PENDING with an exponential back-off
+ *  until GSM_OUTBOX_MAX_ATTEMPTS is reached.
+ */
+
+#include "gsm.h"
+#include "gsm_outbox.h"
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef struct{
+	char number[DIAL_NO_LENGTH];
+	const char * text;
+	boolean text_in_flash;
+	uint32 due_ms;				/*time of the next attempt*/
+	uint8 sequence;				/*posting order, for FIFO among equal priorities*/
+	uint8 reference;			/* +CMGS: <mr> */
+	uint8 attempts;
+	GSM_OutboxPriority priority;
+	GSM_OutboxState state;
+}GSM_OutboxEntry;
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static GSM_OutboxEntry g_outbox[GSM_OUTBOX_SIZE];
+static uint8 g_outbox_active = GSM_OUTBOX_NO_SLOT;	/*slot with an AT+CMGS in flight*/
+static uint8 g_outbox_sequence = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint8 GSM_outboxStore(const char * number, const char * text, boolean text_in_flash,
+		GSM_OutboxPriority priority);
+static uint8 GSM_outboxPickNext(void);
+static uint8 GSM_outboxLatestRoutine(void);
+static boolean GSM_outboxCmgsLine(void);
+static void GSM_outboxSendDone(GSM_CmdStatus status);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+uint8 GSM_outboxPost(const char * number, const char * text, GSM_OutboxPriority priority){
+	return GSM_outboxStore(number, text, FALSE, priority);
+}
+
+uint8 GSM_outboxPost_P(const char * number, PGM_P text, GSM_OutboxPriority priority){
+	return GSM_outboxStore(number, text, TRUE, priority);
+}
+
+void GSM_outboxTask(void){
+	static const char cmgs_format[] PROGMEM = SEND_MSG_CMD "\"%s\"\r";	/*formatted in the engine queue*/
+	uint8 slot;
+
+	if(g_outbox_active != GSM_OUTBOX_NO_SLOT){
+		return;
+	}
+	slot = GSM_outboxPickNext();
+	if(slot == GSM_OUTBOX_NO_SLOT){
+		return;
+	}
+	if(g_outbox[slot].text_in_flash ?
+			GSM_submitCmdText_P(g_outbox[slot].text, GSM_SMS_TIMEOUT_MS, GSM_outboxCmgsLine, GSM_outboxSendDone,
+					cmgs_format, g_outbox[slot].number) :
+			GSM_submitCmdFormat_P(g_outbox[slot].text, GSM_SMS_TIMEOUT_MS, GSM_outboxCmgsLine, GSM_outboxSendDone,
+					cmgs_format, g_outbox[slot].number)){
+		g_outbox[slot].state = GSM_OUTBOX_SENDING;
+		g_outbox[slot].attempts++;
+		g_outbox_active = slot;
+	}
+}
+
+GSM_OutboxState GSM_outboxGetState(uint8 slot){
+	return (slot < GSM_OUTBOX_SIZE) ? g_outbox[slot].state : GSM_OUTBOX_FREE;
+}
+
+uint8 GSM_outboxGetReference(uint8 slot){
+	return (slot < GSM_OUTBOX_SIZE) ? g_outbox[slot].reference : 0;
+}
+
+uint8 GSM_outboxPendingCount(void){
+	uint8 slot, count = 0;
+
+	for(slot = 0; slot < GSM_OUTBOX_SIZE; slot++){
+		if((g_outbox[slot].state == GSM_OUTBOX_PENDING) || (g_outbox[slot].state == GSM_OUTBOX_SENDING)){
+			count++;
+		}
+	}
+	return count;
+}
+
+boolean GSM_outboxIsReferenced(const char * text){
+	uint8 slot;
+
+	for(slot = 0; slot < GSM_OUTBOX_SIZE; slot++){
+		if((g_outbox[slot].text == text) && !g_outbox[slot].text_in_flash &&
+				((g_outbox[slot].state == GSM_OUTBOX_PENDING) || (g_outbox[slot].state == GSM_OUTBOX_SENDING))){
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+void GSM_outboxCancel(const char * text){
+	uint8 slot;
+
+	for(slot = 0; slot < GSM_OUTBOX_SIZE; slot++){
+		if((g_outbox[slot].text == text) && !g_outbox[slot].text_in_flash && (g_outbox[slot].state == GSM_OUTBOX_PENDING)){
+			g_outbox[slot].state = GSM_OUTBOX_FREE;
+		}
+	}
+}
+
+static uint8 GSM_outboxStore(const char * number, const char * text, boolean text_in_flash,
+		GSM_OutboxPriority priority){
+	uint8 slot;
+	GSM_OutboxEntry * entry;
+
+	/*reuse free slots first, then finished ones, an emergency then takes a routine one*/
+	for(slot = 0; slot < GSM_OUTBOX_SIZE; slot++){
+		if(g_outbox[slot].state == GSM_OUTBOX_FREE){
+			break;
+		}
+	}
+	if(slot == GSM_OUTBOX_SIZE){
+		for(slot = 0; slot < GSM_OUTBOX_SIZE; slot++){
+			if((g_outbox[slot].state == GSM_OUTBOX_SENT) || (g_outbox[slot].state == GSM_OUTBOX_FAILED)){
+				break;
+			}
+		}
+	}
+	if((slot == GSM_OUTBOX_SIZE) && (priority == GSM_PRIORITY_EMERGENCY)){
+		slot = GSM_outboxLatestRoutine();
+	}
+	if((slot >= GSM_OUTBOX_SIZE) || (strlen(number) >= DIAL_NO_LENGTH)){
+		return GSM_OUTBOX_NO_SLOT;
+	}
+
+	entry = &g_outbox[slot];
+	strcpy(entry->number, number);
+	entry->text = text;
+	entry->text_in_flash = text_in_flash;
+	entry->priority = priority;
+	entry->attempts = 0;
+	entry->sequence = g_outbox_sequence++;
+	entry->due_ms = SYSTICK_getMs();
+	entry->state = GSM_OUTBOX_PENDING; /*submitted by the next GSM_outboxTask() call*/
+	return slot;
+}
+/*
+ * Description :
+ * Highest priority due entry, the oldest posted one among equal priorities.
+ */
+static uint8 GSM_outboxPickNext(void){
+	uint8 slot, best = GSM_OUTBOX_NO_SLOT;
+	uint32 now = SYSTICK_getMs();
+
+	for(slot = 0; slot < GSM_OUTBOX_SIZE; slot++){
+		if((g_outbox[slot].state != GSM_OUTBOX_PENDING) || ((sint32)(now - g_outbox[slot].due_ms) < 0)){
+			continue;
+		}
+		if((best == GSM_OUTBOX_NO_SLOT) || (g_outbox[slot].priority > g_outbox[best].priority) ||
+				((g_outbox[slot].priority == g_outbox[best].priority) &&
+				((sint8)(g_outbox[slot].sequence - g_outbox[best].sequence) < 0))){
+			best = slot;
+		}
+	}
+	return best;
+}
+
+/*
+ * Description :
+ * Latest posted routine entry still PENDING, given up for an emergency when the outbox is
+ * full (the one being sent is left alone).
+ */
+static uint8 GSM_outboxLatestRoutine(void){
+	uint8 slot, latest = GSM_OUTBOX_NO_SLOT;
+
+	for(slot = 0; slot < GSM_OUTBOX_SIZE; slot++){
+		if((g_outbox[slot].state != GSM_OUTBOX_PENDING) || (g_outbox[slot].priority != GSM_PRIORITY_ROUTINE)){
+			continue;
+		}
+		if((latest == GSM_OUTBOX_NO_SLOT) || ((sint8)(g_outbox[slot].sequence - g_outbox[latest].sequence) > 0)){
+			latest = slot;
+		}
+	}
+	return latest;
+}
+
+/*
+ * Description :
+ * Response line of AT+CMGS: +CMGS: <mr>
+ */
+static boolean GSM_outboxCmgsLine(void){
+	char reference[4];
+
+	if(GSM_lineStartsWith_P(PSTR("+CMGS:"))){
+		GSM_lineGetField(0, reference, sizeof(reference));
+		g_outbox[g_outbox_active].reference = (uint8)atoi(reference);
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static void GSM_outboxSendDone(GSM_CmdStatus status){
+	GSM_OutboxEntry * entry = &g_outbox[g_outbox_active];
+
+	g_outbox_active = GSM_OUTBOX_NO_SLOT;
+	if(status == GSM_CMD_OK){
+		entry->state = GSM_OUTBOX_SENT;
+	}
+	else if(entry->attempts >= GSM_OUTBOX_MAX_ATTEMPTS){
+		entry->state = GSM_OUTBOX_FAILED;
+	}
+	else{
+		entry->state = GSM_OUTBOX_PENDING;
+		entry->due_ms = SYSTICK_getMs() + ((uint32)GSM_OUTBOX_BACKOFF_MS << (entry->attempts - 1));
+	}
+	/*the next recipient is submitted by the next GSM_outboxTask() call*/
+}
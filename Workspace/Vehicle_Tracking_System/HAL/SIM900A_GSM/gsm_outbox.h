@@ -0,0 +1,71 @@
+/*
+ * gsm_outbox.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Outbound SMS queue on top of the AT transaction engine.
+ */
+
+#ifndef GSM_OUTBOX_H_
+#define GSM_OUTBOX_H_
+
+#include "../../Utils/std_types.h"
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define GSM_OUTBOX_SIZE				4		/*recipients waiting or recently handled (26 bytes of RAM each)*/
+#define GSM_OUTBOX_MAX_ATTEMPTS		3		/*AT+CMGS attempts per recipient before giving up*/
+#define GSM_OUTBOX_BACKOFF_MS		2000	/*first retry delay, doubled after every failure*/
+#define GSM_OUTBOX_NO_SLOT			0xFF
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef enum{
+	GSM_OUTBOX_FREE, GSM_OUTBOX_PENDING, GSM_OUTBOX_SENDING, GSM_OUTBOX_SENT, GSM_OUTBOX_FAILED
+}GSM_OutboxState;
+
+/*Higher priorities are sent first, equal priorities in posting order*/
+typedef enum{
+	GSM_PRIORITY_ROUTINE, GSM_PRIORITY_EMERGENCY
+}GSM_OutboxPriority;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Queue one message for one recipient and return its slot (GSM_OUTBOX_NO_SLOT if full).
+ * When every slot is in use, an emergency message replaces the latest routine one still
+ * pending, which is dropped.
+ * The number is copied, the text is not: it must stay valid until the slot is SENT or
+ * FAILED, which lets one alert text be fanned out to many recipients.
+ */
+uint8 GSM_outboxPost(const char * number, const char * text, GSM_OutboxPriority priority);
+
+/*Same as GSM_outboxPost() with a fixed text kept in the flash (PSTR())*/
+uint8 GSM_outboxPost_P(const char * number, PGM_P text, GSM_OutboxPriority priority);
+
+/*Send the next due message when the modem is free. Call from the main loop.*/
+void GSM_outboxTask(void);
+
+GSM_OutboxState GSM_outboxGetState(uint8 slot);
+
+/*Message reference returned by +CMGS: <mr> for a SENT slot*/
+uint8 GSM_outboxGetReference(uint8 slot);
+
+/*Number of recipients still PENDING or SENDING*/
+uint8 GSM_outboxPendingCount(void);
+
+/*TRUE while a PENDING or SENDING recipient uses this RAM text, which must then not change*/
+boolean GSM_outboxIsReferenced(const char * text);
+
+/*Give up the PENDING recipients of this RAM text, the one being sent (if any) goes on*/
+void GSM_outboxCancel(const char * text);
+
+#endif /* GSM_OUTBOX_H_ */
@@ -0,0 +1,97 @@
+/*
+ * gsm_urc.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Lines are tokenised by the USART receive ring (one pending line counter per '\n'),
+ *  so the dispatcher only runs once per complete line. The first character of the line
+ *  selects the candidates, then the prefix is compared in place in the ring. The table is
+ *  kept in the flash.
+ */
+
+#include "gsm.h"
+#include "gsm_urc.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define GSM_URC_PREFIX_LENGTH	18	/*"NORMAL POWER DOWN" and its null terminator*/
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef struct{
+	char prefix[GSM_URC_PREFIX_LENGTH];
+	uint8 text_field;		/*index of the field copied to GSM_UrcData.text*/
+	uint8 value_field;		/*index of the field converted to GSM_UrcData.value*/
+}GSM_UrcEntry;
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+/*indexed by GSM_UrcId*/
+static const GSM_UrcEntry g_urc_table[GSM_URC_COUNT] PROGMEM = {
+		{"+CMTI:",			0,					1},
+		{"RING",			GSM_URC_NO_FIELD,	GSM_URC_NO_FIELD},
+		{"+CLIP:",			0,					1},
+		{"+CREG:",			GSM_URC_NO_FIELD,	0},
+		{"+CPIN:",			0,					GSM_URC_NO_FIELD},
+		{"Call Ready",		GSM_URC_NO_FIELD,	GSM_URC_NO_FIELD},
+		{"NO CARRIER",		GSM_URC_NO_FIELD,	GSM_URC_NO_FIELD},
+		{"UNDER-VOLTAGE",	GSM_URC_NO_FIELD,	GSM_URC_NO_FIELD},
+		{"NORMAL POWER DOWN",GSM_URC_NO_FIELD,	GSM_URC_NO_FIELD},
+		{"CONNECT OK",		GSM_URC_NO_FIELD,	GSM_URC_NO_FIELD},
+		{"ALREADY CONNECT",	GSM_URC_NO_FIELD,	GSM_URC_NO_FIELD},
+		{"CONNECT FAIL",	GSM_URC_NO_FIELD,	GSM_URC_NO_FIELD},
+		{"CLOSED",			GSM_URC_NO_FIELD,	GSM_URC_NO_FIELD},
+		{"+PDP: DEACT",		GSM_URC_NO_FIELD,	GSM_URC_NO_FIELD},
+		{"+HTTPACTION:",	GSM_URC_NO_FIELD,	1},
+};
+
+static GSM_UrcHandler g_urc_handlers[GSM_URC_COUNT];
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void GSM_setUrcHandler(GSM_UrcId id, GSM_UrcHandler handler){
+	if(id < GSM_URC_COUNT){
+		g_urc_handlers[id] = handler;
+	}
+}
+
+boolean GSM_dispatchUrc(void){
+	uint8 id;
+	uint8 first = USART_rxPeek(0);
+	uint8 text_field;
+	uint8 value_field;
+	GSM_UrcData urc;
+	char number[7];
+
+	for(id = 0; id < GSM_URC_COUNT; id++){
+		if((pgm_read_byte(&g_urc_table[id].prefix[0]) != first) || !GSM_lineStartsWith_P(g_urc_table[id].prefix)){
+			continue;
+		}
+		if(g_urc_handlers[id] != NULL_PTR){
+			text_field = pgm_read_byte(&g_urc_table[id].text_field);
+			value_field = pgm_read_byte(&g_urc_table[id].value_field);
+			urc.id = id;
+			urc.text[0] = '\0';
+			urc.value = -1;
+			if(text_field != GSM_URC_NO_FIELD){
+				GSM_lineGetField(text_field, urc.text, GSM_URC_TEXT_LENGTH);
+			}
+			if((value_field != GSM_URC_NO_FIELD) &&
+					GSM_lineGetField(value_field, number, sizeof(number))){
+				urc.value = atoi(number);
+			}
+			g_urc_handlers[id](&urc);
+		}
+		return TRUE;
+	}
+	return FALSE;
+}
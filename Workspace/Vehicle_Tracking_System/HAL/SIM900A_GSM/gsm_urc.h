@@ -0,0 +1,69 @@
+/*
+ * gsm_urc.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Dispatcher for the unsolicited result codes (URCs) of the SIM900A.
+ */
+
+#ifndef GSM_URC_H_
+#define GSM_URC_H_
+
+#include "../../Utils/std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define GSM_URC_TEXT_LENGTH		16	/*longest text field kept from a URC (phone numbers, storage names)*/
+#define GSM_URC_NO_FIELD		0xFF
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+/*Recognised URCs, the order must match the prefix table in gsm_urc.c*/
+typedef enum{
+	GSM_URC_CMTI,				/* +CMTI: "SM",<index>        new message stored           */
+	GSM_URC_RING,				/* RING                         incoming call                */
+	GSM_URC_CLIP,				/* +CLIP: "<number>",<type>    caller id                    */
+	GSM_URC_CREG,				/* +CREG: <stat>                network registration change  */
+	GSM_URC_CPIN,				/* +CPIN: <code>                SIM state                    */
+	GSM_URC_CALL_READY,			/* Call Ready                                                */
+	GSM_URC_NO_CARRIER,			/* NO CARRIER                   call ended                   */
+	GSM_URC_UNDER_VOLTAGE,		/* UNDER-VOLTAGE ...            supply warning / power down  */
+	GSM_URC_POWER_DOWN,			/* NORMAL POWER DOWN                                         */
+	GSM_URC_CONNECT_OK,			/* CONNECT OK                   TCP connection established   */
+	GSM_URC_ALREADY_CONNECT,	/* ALREADY CONNECT                                           */
+	GSM_URC_CONNECT_FAIL,		/* CONNECT FAIL                                              */
+	GSM_URC_CLOSED,				/* CLOSED                       TCP connection closed        */
+	GSM_URC_PDP_DEACT,			/* +PDP: DEACT                  GPRS bearer lost             */
+	GSM_URC_HTTPACTION,			/* +HTTPACTION: <method>,<status>,<length>  request finished */
+	GSM_URC_COUNT
+}GSM_UrcId;
+
+/*Fields parsed out of the URC line before the handler is called*/
+typedef struct{
+	GSM_UrcId id;
+	char text[GSM_URC_TEXT_LENGTH];	/*empty if the URC has no text field*/
+	sint16 value;					/*-1 if the URC has no numeric field*/
+}GSM_UrcData;
+
+typedef void (*GSM_UrcHandler)(const GSM_UrcData * urc);
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*Register (or clear with NULL_PTR) the handler of a URC. URCs without a handler are dropped.*/
+void GSM_setUrcHandler(GSM_UrcId id, GSM_UrcHandler handler);
+
+/*
+ * Match the oldest complete line of the receive ring against the URC table and call the
+ * registered handler with the parsed fields. Returns TRUE if the line is a known URC.
+ * Called by GSM_task() for lines that do not belong to the active command.
+ */
+boolean GSM_dispatchUrc(void);
+
+#endif /* GSM_URC_H_ */
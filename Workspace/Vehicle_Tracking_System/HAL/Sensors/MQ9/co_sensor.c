@@ -6,9 +6,40 @@
  */
 
 
-#include <util/delay.h>
+#include <avr/pgmspace.h>
 #include "co_sensor.h"
 
+// CO curve of the datasheet, in log10 coordinates: two points are taken point1:(200,1.6) point2(10000,0.62)
+// take log of each point (lg200, lg1.6)=(2.3,0.20)  (lg10000,lg0.62)=(4,-0.20)
+// find the slope using these points, take point1 as reference: { x, y, slope } = { 2.3, 0.20, -0.45 }
+// ppm = 10^(((log10(Rs/Ro) - y) / slope) + x)
+//
+// The curve is tabulated (MQ_CO_TABLE_SIZE points, 8 per octave of Rs/Ro from 0.27 to 17.3)
+// and interpolated linearly, no float or libm. Error against the curve, host check of every
+// ADC code with Ro from 1 kohm to 100 kohm (integer Rs and Rs/Ro included, Host_Tests/co_table_accuracy.c):
+//     50 .. 10000 ppm     within 1.8 %
+//     10 .. 50 ppm        within 6.2 % (mostly the integer ppm)
+//      1 .. 10 ppm        within 1 ppm
+// Rs/Ro below 0.27 reads the first entry (about 10000 ppm, past the sensor range), above
+// 17.3 it reads 0 (under 1 ppm).
+
+typedef struct{
+    uint16 ratio;                       // Rs/Ro, Q10
+    uint16 ppm;
+}MQ_CurvePoint;
+
+static const MQ_CurvePoint MQ_CO_TABLE[MQ_CO_TABLE_SIZE] PROGMEM = {
+    {  276, 10227}, {  302,  8373}, {  329,  6922}, {  359,  5702}, {  391,  4716}, {  426,  3898},
+    {  465,  3209}, {  507,  2648}, {  553,  2183}, {  603,  1801}, {  658,  1483}, {  717,  1226},
+    {  782,  1011}, {  853,   833}, {  930,   688}, { 1014,   567}, { 1106,   468}, { 1206,   386},
+    { 1315,   318}, { 1434,   263}, { 1564,   217}, { 1706,   179}, { 1860,   147}, { 2028,   122},
+    { 2212,   100}, { 2412,    83}, { 2630,    68}, { 2868,    56}, { 3128,    46}, { 3411,    38},
+    { 3720,    32}, { 4057,    26}, { 4424,    21}, { 4824,    18}, { 5261,    15}, { 5737,    12},
+    { 6256,    10}, { 6822,     8}, { 7440,     7}, { 8113,     6}, { 8847,     5}, { 9648,     4},
+    {10521,     3}, {11474,     3}, {12512,     2}, {13644,     2}, {14879,     1}, {16226,     1},
+    {17695,     1}
+};
+
 void MQ_init(void){
     GPIO_setupPinDirection(MQ_PORT_ID, MQ_PIN_ID, PIN_INPUT);
     GPIO_setupPinDirection(PORTA_ID, SENSOR_OUTPUT_CHANNEL_ID, PIN_INPUT);
@@ -19,50 +50,58 @@ boolean MQ_getDigIP(void){
     return GPIO_readPin(MQ_PORT_ID, MQ_PIN_ID);
 }
 
-float32 g_COCurve[3] ={2.3,0.20,-0.45};  //two points from smoke COCurve are taken point1:(200,1.6) point2(10000,0.62) 
-                                        //take log of each point (lg200, lg3.4)=(2.3,0.53)  (lg10000,lg0.63)=(4,-0.20)
-                                        //find the slope using these points. take point1 as reference   
-                                        //data format:{ x, y, slope};
-
 // sensor and load resistor forms a voltage divider. so using analog value and load value
 // we will find sensor resistor.
-
-static ResistanceCalculation(uint8 raw_adc){ 
-    return ( ((float32)RL_VALUE*(1023-raw_adc)/raw_adc));   // we will find sensor resistor.
+uint32 MQ_resistance(uint16 raw_adc){
+    if (raw_adc == 0){
+        raw_adc = 1;                                            // open sensor, avoids the division by zero
+    }
+    return (RL_OHMS * (1023 - raw_adc)) / raw_adc;              // at most 10.23 Mohm
 }
 
-float32 MQ_sensorCalibration(){
-    uint8 i;                                   // This function assumes that sensor is in clean air.
-    float32 val=0;
-    
-    for (i=0;i<50;i++){                   //take multiple samples and calculate the average value
-        val += ResistanceCalculation(ADC_readChannel(SENSOR_OUTPUT_CHANNEL_ID));
-        _delay_ms(500);
-    }
+// latest averaged conversion of the sensor channel, sampled in the background by the ADC driver
+static uint16 MQ_readRaw(void){
+    uint16 raw_adc;
 
-    val = val/50;                  
-    val = val/RO_CLEAN_AIR_FACTOR;           //divided by RO_CLEAN_AIR_FACTOR yields the Ro according to the chart in the datasheet 
-    
-    return val;
+    while (!ADC_getSample(SENSOR_OUTPUT_CHANNEL_ID, &raw_adc));  // only waits for the first result after boot
+    return raw_adc;
 }
 
-float32 MQ_readSensor(){
-    uint8 i;
-    float32 rs=0;
-    for (i=0;i<5;i++) {                                 // take multiple readings and average it.
-        rs += ResistanceCalculation(ADC_readChannel(SENSOR_OUTPUT_CHANNEL_ID));   // rs changes according to gas concentration.
-        _delay_ms(50);
-    }
-
-    rs = rs/5;
-    
-    return rs;  
+uint32 MQ_readSensor(){
+    return MQ_resistance(MQ_readRaw());         // rs changes according to gas concentration, already averaged by the ADC
 }
 
+// Rs/Ro in Q10 (Ro >> 2 keeps Rs << 8 in 32 bits), then the table entries around it are
+// found by bisection and interpolated.
+uint16 MQ_getCOppm(uint32 rs, uint32 ro){
+    uint32 ratio;
+    uint16 ratio_low, ratio_high, ppm_low, ppm_high;
+    uint8 low = 0, high = MQ_CO_TABLE_SIZE - 1, middle;
 
-//Using slope,ratio(y2) and another point(x1,y1) on line we will find
-// gas concentration(x2) using x2 = [((y2-y1)/slope)+x1]
-// as in curves are on logarithmic coordinate, power of 10 is taken to convert result to non-logarithmic.
-uint8  MQ_getCOPercentage(float32 rs_ro_ratio){                                                                          
-    return (pow(10,( ((log(rs_ro_ratio)-g_COCurve[1])/g_COCurve[2]) + g_COCurve[0]))); 
-}
\ No newline at end of file
+    ro >>= 2;
+    if (ro == 0){
+        return 0;                                               // not calibrated
+    }
+    ratio = (rs << 8) / ro;
+    if (ratio <= pgm_read_word(&MQ_CO_TABLE[0].ratio)){
+        return pgm_read_word(&MQ_CO_TABLE[0].ppm);
+    }
+    if (ratio >= pgm_read_word(&MQ_CO_TABLE[MQ_CO_TABLE_SIZE - 1].ratio)){
+        return 0;
+    }
+    while ((high - low) > 1){
+        middle = (low + high) / 2;
+        if (pgm_read_word(&MQ_CO_TABLE[middle].ratio) <= ratio){
+            low = middle;
+        }
+        else{
+            high = middle;
+        }
+    }
+    ratio_low = pgm_read_word(&MQ_CO_TABLE[low].ratio);
+    ratio_high = pgm_read_word(&MQ_CO_TABLE[high].ratio);
+    ppm_low = pgm_read_word(&MQ_CO_TABLE[low].ppm);
+    ppm_high = pgm_read_word(&MQ_CO_TABLE[high].ppm);
+    return ppm_low - (uint16)(((uint32)(ppm_low - ppm_high) * (ratio - ratio_low) + (ratio_high - ratio_low) / 2)
+            / (ratio_high - ratio_low));
+}
@@ -13,14 +13,16 @@
 
 #define MQ_PORT_ID 				    PORTD_ID
 #define MQ_PIN_ID					PIN3_ID
-#define RL_VALUE                    10               //define the load resistance on the board, in kilo ohms
-#define RO_CLEAN_AIR_FACTOR         9.83            //(Sensor resistance in clean air)
-#define SENSOR_OUTPUT_CHANNEL_ID 	ADC_ch0
+#define RL_OHMS                     10000UL          //define the load resistance on the board, in ohms
+#define RO_CLEAN_AIR_FACTOR_X100    983             //(Sensor resistance in clean air) / Ro = 9.83, see APP/co_calibration
+#define MQ_CO_TABLE_SIZE            49              //points of the CO curve table (flash)
+#define SENSOR_OUTPUT_CHANNEL_ID 	ADC_ch0         //must be in the background sampling of the ADC (ADC_startSampling)
 
 									                                                 
-uint8 MQ_getCOPercentage(float32);
-float32 MQ_ReadSensor();
-float32 MQ_resistanceCalculation(uint8);
-float32 MQ_sensorCalibration();
+void MQ_init(void);
+boolean MQ_getDigIP(void);                          //module comparator output, high over its potentiometer threshold
+uint16 MQ_getCOppm(uint32 rs, uint32 ro);          //CO concentration from the sensor resistance and Ro (ohms)
+uint32 MQ_readSensor();                             //Rs (ohms), never waits
+uint32 MQ_resistance(uint16 raw_adc);               //Rs (ohms) from an ADC code
 
 #endif /* HAL_SENSORS_MQ9_CO_SENSOR_H_ */
@@ -0,0 +1,197 @@
+/*
+ * uart_arbiter.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ */
+
+#include "uart_arbiter.h"
+#include "../SIM900A_GSM/gsm.h"
+#include "../../MCAL/USART/usart.h"
+#include "../../MCAL/GPIO/gpio.h"
+#include "../../MCAL/Timer/systick.h"
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+static const ARBITER_ConfigType * g_arbiter_config;	/*in the flash*/
+static ARBITER_Channel g_owner = ARBITER_GSM;
+static uint32 g_owner_ms = 0;						/*time the owner was selected*/
+static uint32 g_accounted_ms = 0;					/*owned_ms counted up to this time*/
+static boolean g_settling = FALSE;
+static boolean g_waiting[ARBITER_CHANNELS];
+static uint32 g_wait_ms[ARBITER_CHANNELS];			/*time each waiting channel started waiting*/
+static boolean g_gps_requested = FALSE;
+static uint8 g_urc_awaited = 0;						/*ARBITER_URC_* of the drivers waiting for a URC*/
+static ARBITER_Stats g_stats;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static boolean ARBITER_gpsDue(void);
+static boolean ARBITER_gsmDue(void);
+static void ARBITER_select(ARBITER_Channel channel);
+static void ARBITER_attach(void);
+static void ARBITER_discardByte(uint8 data);
+
+/*******************************************************************************
+ *                     		 Functions Definitions                             *
+ *******************************************************************************/
+
+void ARBITER_init(const ARBITER_ConfigType * a_configPtr){
+	g_arbiter_config = a_configPtr;
+	GPIO_setupPinDirection(ARBITER_RELAY_PORT, ARBITER_RELAY_PIN, PIN_OUTPUT);
+	GPIO_writePin(ARBITER_RELAY_PORT, ARBITER_RELAY_PIN, LOGIC_HIGH);
+	g_owner = ARBITER_GSM;
+	g_owner_ms = SYSTICK_getMs();
+	g_accounted_ms = g_owner_ms;
+	g_settling = FALSE;
+	g_gps_requested = FALSE;
+	g_waiting[ARBITER_GSM] = FALSE;
+	g_waiting[ARBITER_GPS] = FALSE;
+	USART_setRxHandler(NULL_PTR);
+	USART_rxFlush();
+	GSM_hold(FALSE);
+	ARBITER_resetStats();
+}
+
+void ARBITER_request(ARBITER_Channel channel){
+	if(channel != ARBITER_GPS){
+		return; /*the modem asks for the line by queueing commands*/
+	}
+	if(!g_gps_requested && (g_owner != ARBITER_GPS)){
+		g_waiting[ARBITER_GPS] = TRUE;
+		g_wait_ms[ARBITER_GPS] = SYSTICK_getMs();
+	}
+	g_gps_requested = TRUE;
+}
+
+void ARBITER_release(ARBITER_Channel channel){
+	if(channel == ARBITER_GPS){
+		g_gps_requested = FALSE;
+		g_waiting[ARBITER_GPS] = FALSE;
+	}
+}
+
+void ARBITER_awaitUrc(uint8 driver, boolean waiting){
+	if(waiting){
+		g_urc_awaited |= driver;
+	}
+	else{
+		g_urc_awaited &= (uint8)~driver;
+	}
+}
+
+boolean ARBITER_isGranted(ARBITER_Channel channel){
+	return (g_owner == channel) && !g_settling;
+}
+
+void ARBITER_task(void){
+	if(g_arbiter_config == NULL_PTR){
+		return;
+	}
+	if(g_settling){
+		if(SYSTICK_elapsedMs(g_owner_ms) >= ARBITER_SETTLE_MS){
+			ARBITER_attach();
+		}
+		return;
+	}
+	if(g_owner == ARBITER_GPS){
+		if(!g_waiting[ARBITER_GSM] && (GSM_queuedCmds() > 0)){
+			g_waiting[ARBITER_GSM] = TRUE; /*held until the modem is selected again*/
+			g_wait_ms[ARBITER_GSM] = SYSTICK_getMs();
+		}
+		if(ARBITER_gsmDue()){
+			ARBITER_select(ARBITER_GSM);
+		}
+	}
+	else if(ARBITER_gpsDue()){
+		GSM_hold(TRUE);
+		GSM_task(); /*hand the complete lines left in the ring to the modem driver first*/
+		if(USART_rxCount() > 0){
+			GSM_hold(FALSE); /*a line is still arriving*/
+			return;
+		}
+		ARBITER_select(ARBITER_GPS);
+	}
+}
+
+void ARBITER_getStats(ARBITER_Stats * stats){
+	*stats = g_stats;
+	stats->owned_ms[g_owner] += SYSTICK_elapsedMs(g_accounted_ms); /*current slice included*/
+}
+
+void ARBITER_resetStats(void){
+	uint8 channel;
+
+	for(channel = 0; channel < ARBITER_CHANNELS; channel++){
+		g_stats.owned_ms[channel] = 0;
+		g_stats.grants[channel] = 0;
+		g_stats.max_wait_ms[channel] = 0;
+	}
+	g_accounted_ms = SYSTICK_getMs();
+}
+
+/*the modem is left only between two commands, and not while a URC is awaited*/
+static boolean ARBITER_gpsDue(void){
+	return g_gps_requested && !GSM_cmdInProgress() && (g_urc_awaited == 0)
+			&& (SYSTICK_elapsedMs(g_owner_ms) >= pgm_read_word(&g_arbiter_config->gsm_min_slice_ms))
+			&& ((GSM_queuedCmds() == 0)
+					|| (SYSTICK_elapsedMs(g_wait_ms[ARBITER_GPS]) >= pgm_read_word(&g_arbiter_config->gps_max_wait_ms)));
+}
+
+static boolean ARBITER_gsmDue(void){
+	uint32 slice_ms = SYSTICK_elapsedMs(g_owner_ms);
+
+	return !g_gps_requested || (slice_ms >= pgm_read_word(&g_arbiter_config->gps_slice_ms))
+			|| ((GSM_queuedCmds() > 0) && (slice_ms >= pgm_read_word(&g_arbiter_config->gps_min_slice_ms)));
+}
+
+/*
+ * Route the line to the given channel. The bytes already queued reach the current peer
+ * first, and everything received while the relay bounces is discarded.
+ */
+static void ARBITER_select(ARBITER_Channel channel){
+	uint32 wait_ms;
+
+	USART_flush();
+	USART_setRxHandler(ARBITER_discardByte);
+	GPIO_writePin(ARBITER_RELAY_PORT, ARBITER_RELAY_PIN, (channel == ARBITER_GSM) ? LOGIC_HIGH : LOGIC_LOW);
+	g_stats.owned_ms[g_owner] += SYSTICK_elapsedMs(g_accounted_ms);
+	g_stats.grants[channel]++;
+	if(g_waiting[channel]){
+		wait_ms = SYSTICK_elapsedMs(g_wait_ms[channel]);
+		if(wait_ms > g_stats.max_wait_ms[channel]){
+			g_stats.max_wait_ms[channel] = (wait_ms > 0xFFFF) ? 0xFFFF : (uint16)wait_ms;
+		}
+		g_waiting[channel] = FALSE;
+	}
+	g_owner = channel;
+	g_owner_ms = SYSTICK_getMs();
+	g_accounted_ms = g_owner_ms;
+	g_settling = TRUE;
+}
+
+/*connect the receive path of the new owner once the relay has settled*/
+static void ARBITER_attach(void){
+	void (*on_gsm_resume)(void);
+
+	g_settling = FALSE;
+	if(g_owner == ARBITER_GPS){
+		return; /*the receiver output is also wired to the software UART, discarded here*/
+	}
+	USART_setRxHandler(NULL_PTR);
+	USART_rxFlush(); /*guard, the ring was empty when the modem was left*/
+	GSM_hold(FALSE);
+	on_gsm_resume = pgm_read_ptr(&g_arbiter_config->on_gsm_resume);
+	if(on_gsm_resume != NULL_PTR){
+		on_gsm_resume();
+	}
+}
+
+static void ARBITER_discardByte(uint8 data){
+	(void)data; /*bytes received while the relay moves are dropped*/
+}
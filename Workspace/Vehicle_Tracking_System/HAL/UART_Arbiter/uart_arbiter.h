@@ -0,0 +1,98 @@
+/*
+ * uart_arbiter.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Omar
+ *
+ *  Owner of the single USART and of the relay on PB3 that connects it either to the SIM900A
+ *  (relay high) or to the NEO-6 (relay low). The receiver output is read by the software
+ *  UART on its own pin, so the GPS only needs a slice to be sent commands (configuration).
+ *
+ *  The modem is the default owner and has priority: the GPS is given a slice only while no
+ *  AT command is in flight, and is taken back for queued commands once it had its minimum
+ *  slice. Commands queued while the GPS owns the line are held in the AT engine queue
+ *  (GSM_hold()) and start as soon as the modem is selected again. Nothing the modem sends
+ *  while the GPS is selected can be received, the on_gsm_resume callback lets the
+ *  application look again for what it may have missed (new SMS). A modem driver waiting for
+ *  the URC that completes an operation (CONNECT OK, +HTTPACTION) keeps the line with
+ *  ARBITER_awaitUrc() until it arrives or the driver gives up on it.
+ */
+
+#ifndef UART_ARBITER_H_
+#define UART_ARBITER_H_
+
+#include "../../Utils/std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define ARBITER_RELAY_PORT		PORTB_ID
+#define ARBITER_RELAY_PIN		PIN3_ID
+#define ARBITER_SETTLE_MS		10		/*relay bounce, bytes received meanwhile are discarded*/
+
+/*modem drivers waiting for a URC, ARBITER_awaitUrc()*/
+#define ARBITER_URC_GPRS		0x01
+#define ARBITER_URC_HTTP		0x02
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef enum{
+	ARBITER_GSM, ARBITER_GPS, ARBITER_CHANNELS
+}ARBITER_Channel;
+
+/*
+ * gps_slice_ms:		longest time the GPS keeps the line once granted.
+ * gps_min_slice_ms:	time the GPS keeps the line even if modem commands are waiting
+ * 						(at least one fix period).
+ * gsm_min_slice_ms:	time the modem keeps the line after being selected again, to flush
+ * 						the held commands and receive its pending notifications.
+ * gps_max_wait_ms:		a GPS request waits this long for the modem queue to empty, then it
+ * 						is granted at the next command boundary even if commands are queued.
+ * on_gsm_resume:		called once the modem is selected again (may be NULL_PTR).
+ */
+typedef struct{
+	uint16 gps_slice_ms;
+	uint16 gps_min_slice_ms;
+	uint16 gsm_min_slice_ms;
+	uint16 gps_max_wait_ms;
+	void (*on_gsm_resume)(void);
+}ARBITER_ConfigType;
+
+/*
+ * owned_ms:	time each channel was selected (utilisation = owned_ms / uptime).
+ * grants:		number of times each channel was selected.
+ * max_wait_ms:	longest time a channel waited for the line (GPS request, held modem command).
+ */
+typedef struct{
+	uint32 owned_ms[ARBITER_CHANNELS];
+	uint16 grants[ARBITER_CHANNELS];
+	uint16 max_wait_ms[ARBITER_CHANNELS];
+}ARBITER_Stats;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*Configure the relay pin and select the modem. Call before GSM_init(), with a configuration in PROGMEM.*/
+void ARBITER_init(const ARBITER_ConfigType * a_configPtr);
+
+/*Ask for the line. The GPS request stays active until released.*/
+void ARBITER_request(ARBITER_Channel channel);
+void ARBITER_release(ARBITER_Channel channel);
+
+/*Keep the GPS from being given the line while the driver waits for a URC*/
+void ARBITER_awaitUrc(uint8 driver, boolean waiting);
+
+/*TRUE while the channel is selected and the relay has settled*/
+boolean ARBITER_isGranted(ARBITER_Channel channel);
+
+/*Move the line between the channels when due. Call from the main loop, before GSM_task().*/
+void ARBITER_task(void);
+
+void ARBITER_getStats(ARBITER_Stats * stats);
+void ARBITER_resetStats(void);
+
+#endif /* UART_ARBITER_H_ */
@@ -12,11 +12,122 @@
  *
  *******************************************************************************/
 
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
 #include "adc.h"
 
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define ADC_NO_CHANNEL		0xFF
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+/*accumulation and filter of a sampled channel, written by the conversion complete ISR*/
+typedef struct{
+	uint32 accumulator;
+	uint32 filter;				/*filtered result x 2^filter_shift*/
+	uint16 count;				/*conversions in the accumulator*/
+	uint16 result;
+	uint8 countdown;			/*triggers until the channel is due*/
+	boolean ready;				/*a result is complete*/
+}ADC_ChannelState;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static const ADC_SamplingConfigType * volatile g_sampling_config = NULL_PTR;	/*in the flash, with its channels*/
+static volatile ADC_ChannelState g_channel_state[ADC_MAX_SAMPLED_CHANNELS];
+static volatile uint8 g_sampled_index = ADC_NO_CHANNEL;	/*channel of the conversion in progress, none between slots*/
+static volatile uint8 g_muxed_index = 0;				/*channel on the multiplexer, the last one served*/
+static volatile uint8 g_settle_left = 0;				/*conversions still dropped after the multiplexer change*/
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+
+/*
+ * Add the conversion to its channel, then choose the channel of the next trigger (the
+ * multiplexer only changes between two conversions).
+ */
+ISR(ADC_vect){
+	const ADC_SamplingConfigType * config = g_sampling_config;
+	const ADC_ChannelConfigType * channels = pgm_read_ptr(&config->channels);
+	const ADC_ChannelConfigType * channel;
+	volatile ADC_ChannelState * state;
+	uint16 conversion = ADC;
+	uint16 result;
+	uint8 count = pgm_read_byte(&config->channel_count);
+	uint8 filter_shift;
+	uint8 next;
+	uint8 i;
+
+	if(g_sampled_index != ADC_NO_CHANNEL){
+		if(g_settle_left > 0){
+			g_settle_left--;
+		}
+		else{
+			channel = &channels[g_sampled_index];
+			state = &g_channel_state[g_sampled_index];
+			state->accumulator += conversion;
+			state->count++;
+			if(state->count == ((uint16)1 << pgm_read_byte(&channel->oversampling_shift))){
+				result = (uint16)(state->accumulator >> pgm_read_byte(&channel->decimation_shift));
+				filter_shift = pgm_read_byte(&channel->filter_shift);
+				if(state->ready){
+					state->filter += result - (state->filter >> filter_shift);
+				}
+				else{
+					state->filter = (uint32)result << filter_shift;
+				}
+				state->result = (uint16)(state->filter >> filter_shift);
+				state->accumulator = 0;
+				state->count = 0;
+				state->ready = TRUE;
+			}
+			g_sampled_index = ADC_NO_CHANNEL;
+		}
+	}
+	for(i = 0; i < count; i++){
+		if(g_channel_state[i].countdown > 0){
+			g_channel_state[i].countdown--;
+		}
+	}
+	if(g_sampled_index != ADC_NO_CHANNEL){
+		return; /*still settling*/
+	}
+
+	next = g_muxed_index;
+	for(i = 0; i < count; i++){
+		next++;
+		if(next == count){
+			next = 0;
+		}
+		if(g_channel_state[next].countdown == 0){
+			g_channel_state[next].countdown = pgm_read_byte(&channels[next].period);
+			g_sampled_index = next;
+			if(next != g_muxed_index){
+				ADMUX = (ADMUX & 0xE0) | (pgm_read_byte(&channels[next].channel) & 0x07);
+				g_muxed_index = next;
+				g_settle_left = pgm_read_byte(&channels[next].settle_conversions);
+			}
+			return;
+		}
+	}
+}
+
+/*******************************************************************************
+ *                    	  Functions Definitions                                *
+ *******************************************************************************/
+
 /*
  * Description :
  * Function responsible for initialize the ADC driver.
+ * The configuration is read from the flash (PROGMEM).
  */
 void ADC_init(const ADC_ConfigType * Config_Ptr){
 	/* ADMUX Register Bits Description:
@@ -24,7 +135,7 @@ void ADC_init(const ADC_ConfigType * Config_Ptr){
 	 * ADLAR   = 0 right adjusted
 	 * MUX4:0  = 00000 to choose channel 0 as initialization
 	 */
-	ADMUX = (Config_Ptr->ref_volt<<6);
+	ADMUX = (pgm_read_byte(&Config_Ptr->ref_volt)<<6);
 
 	/* ADCSRA Register Bits Description:
 	 * ADEN    = 1 Enable ADC
@@ -33,7 +144,7 @@ void ADC_init(const ADC_ConfigType * Config_Ptr){
 	 */
 	ADCSRA = (1<<ADEN);
 	/*Setting ADC clock. The Clock must be between 50KHz to 200KHz*/
-	ADCSRA |= (Config_Ptr->prescaler);
+	ADCSRA |= pgm_read_byte(&Config_Ptr->prescaler);
 
 }
 
@@ -49,3 +160,84 @@ uint16 ADC_readChannel(const ADC_SingleEndedIp channel_number){
 	SET_BIT(ADCSRA,ADIF); 				/*clear the interrupt flag*/
 	return ADC;
 }
+
+/*
+ * Description :
+ * Function responsible for starting the background conversions of the configured channels.
+ * ADC_TRIGGER_FREE_RUNNING converts back to back and is only suited to a single channel: the
+ * next conversion has already started on the old channel when the ISR selects the next one.
+ * The first channel of the list is converted first.
+ */
+void ADC_startSampling(const ADC_SamplingConfigType * Config_Ptr){
+	const ADC_ChannelConfigType * channels = pgm_read_ptr(&Config_Ptr->channels);
+	ADC_TriggerSource trigger = pgm_read_byte(&Config_Ptr->trigger);
+	uint8 i;
+
+	ADC_stopSampling();
+	for(i = 0; i < pgm_read_byte(&Config_Ptr->channel_count); i++){
+		g_channel_state[i].accumulator = 0;
+		g_channel_state[i].count = 0;
+		g_channel_state[i].ready = FALSE;
+		g_channel_state[i].countdown = 0;
+	}
+	g_channel_state[0].countdown = pgm_read_byte(&channels[0].period);
+	g_sampled_index = 0;
+	g_muxed_index = 0;
+	g_settle_left = pgm_read_byte(&channels[0].settle_conversions);
+	g_sampling_config = Config_Ptr;
+	ADMUX = (ADMUX & 0xE0) | (pgm_read_byte(&channels[0].channel) & 0x07);
+
+	/* SFIOR Register Bits Description:
+	 * ADTS2:0 = auto trigger source
+	 */
+	SFIOR = (SFIOR & 0x1F) | (trigger << ADTS0);
+
+	/* ADCSRA Register Bits Description:
+	 * ADATE   = 1 Enable Auto Trigger
+	 * ADIE    = 1 Enable ADC Interrupt
+	 * ADIF    = 1 clear a pending conversion complete flag
+	 */
+	ADCSRA |= (1<<ADATE) | (1<<ADIE) | (1<<ADIF);
+	if(trigger == ADC_TRIGGER_FREE_RUNNING){
+		SET_BIT(ADCSRA,ADSC);
+	}
+}
+
+/*
+ * Description :
+ * Function responsible for stopping the background conversions (the one in progress ends first).
+ */
+void ADC_stopSampling(void){
+	ADCSRA &= ~((1<<ADATE) | (1<<ADIE));
+	while(BIT_IS_SET(ADCSRA,ADSC));
+	SET_BIT(ADCSRA,ADIF);
+	g_sampling_config = NULL_PTR;
+}
+
+/*
+ * Description :
+ * Function responsible for returning the latest filtered result of a sampled channel.
+ */
+boolean ADC_getSample(const ADC_SingleEndedIp channel_number, uint16 * value){
+	const ADC_SamplingConfigType * config = g_sampling_config;
+	const ADC_ChannelConfigType * channels;
+	boolean ready = FALSE;
+	uint8 sreg;
+	uint8 i;
+
+	if(config == NULL_PTR){
+		return FALSE;
+	}
+	channels = pgm_read_ptr(&config->channels);
+	for(i = 0; i < pgm_read_byte(&config->channel_count); i++){
+		if(pgm_read_byte(&channels[i].channel) == channel_number){
+			sreg = SREG;
+			cli(); /*16-bit result written by the ISR*/
+			ready = g_channel_state[i].ready;
+			*value = g_channel_state[i].result;
+			SREG = sreg;
+			break;
+		}
+	}
+	return ready;
+}
@@ -26,6 +26,7 @@
 #define ADMUX 	(*( (volatile uint8 * const) 	0x27))
 #define ADCSRA 	(*( (volatile uint8 * const) 	0x26))
 #define ADC 	(*( (volatile uint16 * const) 	0x24))
+#define SFIOR 	(*( (volatile uint8 * const) 	0x50))
 
 /*Bits Definitions */
 /* ADCSRA */
@@ -48,9 +49,18 @@
 #define MUX1    1
 #define MUX0    0
 
+/* SFIOR */
+#define ADTS2   7
+#define ADTS1   6
+#define ADTS0   5
+
 #define ADC_MAXIMUM_VALUE    1023
 #define ADC_REF_VOLT_VALUE   5
 
+#define ADC_MAX_SAMPLED_CHANNELS	4		/*channels converted in the background*/
+#define ADC_MAX_OVERSAMPLING_SHIFT	12		/*4096 conversions of 1023 fit the 32-bit accumulator*/
+#define ADC_MAX_FILTER_SHIFT		8		/*a 16-bit result x 2^8 fits the 32-bit filter state*/
+
 /*******************************************************************************
  *                         Types Declaration                                   *
  *******************************************************************************/
@@ -73,6 +83,48 @@ typedef enum{
 	ADC_ch0, ADC_ch1, ADC_ch2, ADC_ch3, ADC_ch4, ADC_ch5, ADC_ch6, ADC_ch7
 }ADC_SingleEndedIp;
 
+/*Auto trigger sources of the background conversions (SFIOR ADTS2:0)*/
+typedef enum{
+	ADC_TRIGGER_FREE_RUNNING, ADC_TRIGGER_ANALOG_COMPARATOR, ADC_TRIGGER_INT0,
+	ADC_TRIGGER_TIMER0_COMPARE, ADC_TRIGGER_TIMER0_OVERFLOW, ADC_TRIGGER_TIMER1_COMPARE_B,
+	ADC_TRIGGER_TIMER1_OVERFLOW, ADC_TRIGGER_TIMER1_CAPTURE
+}ADC_TriggerSource;
+
+/*
+ * One channel of the background conversions:
+ * 2^oversampling_shift conversions are summed into one result, which is the sum shifted
+ * right by decimation_shift. Equal shifts give the plain average (10 bits), a decimation
+ * shift of half the oversampling shift gives oversampling_shift / 2 extra bits of resolution
+ * (the input must carry at least 1 LSB of noise).
+ * The channel is converted once every period triggers (0 and 1: on every trigger). When the
+ * multiplexer moves to it, settle_conversions conversions are dropped first, for inputs behind
+ * a high impedance divider that charge the sample and hold capacitor slowly.
+ * The results then go through an exponential average of weight 1 / 2^filter_shift (0: none).
+ */
+typedef struct{
+	ADC_SingleEndedIp channel;
+	uint8 oversampling_shift;
+	uint8 decimation_shift;
+	uint8 period;
+	uint8 settle_conversions;
+	uint8 filter_shift;				/*up to ADC_MAX_FILTER_SHIFT*/
+}ADC_ChannelConfigType;
+
+/*
+ * Background conversions: one conversion per trigger. With ADC_TRIGGER_TIMER0_COMPARE the
+ * millisecond tick (systick.h) starts them.
+ * Scan scheduling, in the conversion complete ISR: the channels whose period elapsed are
+ * served in turn, in the order of the list, starting after the last one served. A trigger with
+ * no channel due converts the channel left on the multiplexer and drops the result. The ISR
+ * does the same bounded work on every trigger (one pass over the list), and every period is
+ * kept as long as the sum of (1 + settle_conversions) / period over the list stays below 1.
+ */
+typedef struct{
+	ADC_TriggerSource trigger;
+	const ADC_ChannelConfigType * channels;
+	uint8 channel_count;			/*up to ADC_MAX_SAMPLED_CHANNELS*/
+}ADC_SamplingConfigType;
+
 /*Structure contains the configuration of ADC: Pre-scaler and reference voltage choice*/
 typedef struct{
 	ADC_ReferenceVolatge ref_volt;
@@ -87,7 +139,7 @@ typedef struct{
 
 /*
  * Description :
- * Function to initialize the ADC driver.
+ * Function to initialize the ADC driver, the configuration is read from the flash (PROGMEM).
  */
 void ADC_init(const ADC_ConfigType * Config_Ptr);
 
@@ -98,5 +150,22 @@ void ADC_init(const ADC_ConfigType * Config_Ptr);
  */
 uint16 ADC_readChannel(const ADC_SingleEndedIp channel_number);
 
+/*
+ * Description :
+ * Start converting the configured channels in the background on the conversion complete
+ * interrupt (global interrupts must be enabled). ADC_readChannel() must not be used until
+ * ADC_stopSampling() is called. The configuration and its channel list are read from the
+ * flash (PROGMEM).
+ */
+void ADC_startSampling(const ADC_SamplingConfigType * Config_Ptr);
+void ADC_stopSampling(void);
+
+/*
+ * Description :
+ * Latest (filtered) result of a sampled channel, never waits.
+ * Returns FALSE if the channel is not sampled or its first result is not complete yet.
+ */
+boolean ADC_getSample(const ADC_SingleEndedIp channel_number, uint16 * value);
+
 
 #endif
@@ -17,12 +17,28 @@
 #include "GPIO.h"
 #include "std_types.h"
 
+/*******************************************************************************
+ *                     	   	  Global Variables                                 *
+ *******************************************************************************/
+
+typedef enum{
+	EEPROMINTENAL_STAGE_FREE, EEPROMINTENAL_STAGE_CLAIMED, EEPROMINTENAL_STAGE_WRITING
+}EEPROMINTENAL_StageState;
+
+static uint8 g_stage[EEPROMINTENAL_STAGE_SIZE];
+static EEPROMINTENAL_StageState g_stage_state = EEPROMINTENAL_STAGE_FREE;
+static uint16 g_stage_address;
+static uint8 g_stage_length;
+static uint8 g_stage_index;
+
 /*
  * Description :
  * Write byte in the internal EEPROM of ATMEGA32
  */
 void EEPROMINTENAL_writeByte (const uint16 address, const uint8 data)
 {
+	uint8 sreg;
+
 	/* polling on the EEWE until it becomes zero
 	 * EECR: The EEPROM Control Register
 	 * EEWE: EEPROM Write Enable
@@ -34,11 +50,16 @@ void EEPROMINTENAL_writeByte (const uint16 address, const uint8 data)
 	/* Setting the data in the EEDR: EEPROM Data Register */
 	EEDR = data;
 
-	/* start EEPROM write by setting EEWE. */
+	/* start EEPROM write by setting EEWE within 4 cycles of EEMWE: an interrupt in between
+	 * would let EEMWE expire and the byte would silently not be written.
+	 * */
+	sreg = SREG;
+	asm("CLI");
 	SET_BIT(EECR,EEMWE); /* Write logical one to EEPROM Master Write Enable */
 
 	/* Start Writing */
 	asm("SBI 0x1C,1"); /*Equivalent in C: SET_BIT(EECR,EEWE) */
+	SREG = sreg; /* interrupts back on if they were enabled */
 }
 
 /*
@@ -65,3 +86,76 @@ uint8 EEPROMINTENAL_readByte (const uint16 address)
 	/* Return the read Data from EEPROM by returning the EEPROM Data Register (EEDR) */
 	return EEDR;
 }
+
+/*
+ * Description :
+ * Check that no write is in progress, so the next read/write starts without waiting
+ */
+boolean EEPROMINTENAL_isReady (void)
+{
+	/* EEWE is cleared by hardware when the write (about 8.5 ms) completes */
+	return BIT_IS_CLEAR(EECR,EEWE);
+}
+
+/*
+ * Description :
+ * Take the shared staging buffer, NULL_PTR while it is held or being written
+ */
+uint8 * EEPROMINTENAL_claim (void)
+{
+	if (g_stage_state != EEPROMINTENAL_STAGE_FREE)
+	{
+		return NULL_PTR;
+	}
+	g_stage_state = EEPROMINTENAL_STAGE_CLAIMED;
+	return g_stage;
+}
+
+/*
+ * Description :
+ * Write the first length bytes of the claimed buffer at address, in the background
+ */
+void EEPROMINTENAL_commit (const uint16 address, const uint8 length)
+{
+	g_stage_address = address;
+	g_stage_length = length;
+	g_stage_index = 0;
+	g_stage_state = EEPROMINTENAL_STAGE_WRITING;
+}
+
+/*
+ * Description :
+ * Give the claimed buffer back without writing it
+ */
+void EEPROMINTENAL_release (void)
+{
+	g_stage_state = EEPROMINTENAL_STAGE_FREE;
+}
+
+/*
+ * Description :
+ * Write the next committed byte if the previous write completed, the buffer is free
+ * again after the last one
+ */
+void EEPROMINTENAL_task (void)
+{
+	if ((g_stage_state != EEPROMINTENAL_STAGE_WRITING) || !EEPROMINTENAL_isReady())
+	{
+		return;
+	}
+	EEPROMINTENAL_writeByte(g_stage_address + g_stage_index, g_stage[g_stage_index]);
+	g_stage_index++;
+	if (g_stage_index == g_stage_length)
+	{
+		g_stage_state = EEPROMINTENAL_STAGE_FREE;
+	}
+}
+
+/*
+ * Description :
+ * Check whether committed bytes are still waiting to be written
+ */
+boolean EEPROMINTENAL_isWriting (void)
+{
+	return (g_stage_state == EEPROMINTENAL_STAGE_WRITING);
+}
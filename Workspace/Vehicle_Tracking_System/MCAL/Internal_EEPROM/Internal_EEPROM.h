@@ -20,6 +20,7 @@
 /*******************************************************************************
  *                                Definitions                                  *
  *******************************************************************************/
+#define EEPROMINTENAL_STAGE_SIZE	77	/*largest record written in the background (GPS health block)*/
 
 /*******************************************************************************
  *                              Functions Prototypes                           *
@@ -36,4 +37,28 @@ void EEPROMINTENAL_writeByte (const uint16 address, const uint8 data);
  */
 uint8 EEPROMINTENAL_readByte (const uint16 address);
 
+/*
+ * Description :
+ * Check that no write is in progress, so the next read/write starts without waiting
+ */
+boolean EEPROMINTENAL_isReady (void);
+
+/*
+ * Description :
+ * Background writer shared by the modules saving records while the program runs, so that
+ * only one staging buffer is kept in RAM:
+ * EEPROMINTENAL_claim() returns the EEPROMINTENAL_STAGE_SIZE byte buffer, or NULL_PTR while
+ * another record holds it or is still being written. The owner fills it, then either
+ * EEPROMINTENAL_commit() writes its first length bytes at address, or EEPROMINTENAL_release()
+ * gives it back unwritten.
+ * EEPROMINTENAL_task() writes one byte whenever the EEPROM is ready, never waits. Call it
+ * from the main loop.
+ * EEPROMINTENAL_isWriting() is TRUE until the last committed byte is written.
+ */
+uint8 * EEPROMINTENAL_claim (void);
+void EEPROMINTENAL_commit (const uint16 address, const uint8 length);
+void EEPROMINTENAL_release (void);
+void EEPROMINTENAL_task (void);
+boolean EEPROMINTENAL_isWriting (void);
+
 #endif /* MCAL_INTERNAL_EEPROM_H_ */
@@ -0,0 +1,202 @@
+/******************************************************************************
+ *
+ * [FILE NAME]:     sw_uart.c
+ *
+ * [AUTHOR]:        Omar Amr
+ *
+ * [DATE]:          18-10-2026
+ *
+ * [Description]:   Source file for the receive only software UART (Timer1 input capture)
+ *
+ * [TARGET HW]:		ATmega32
+ *
+ *******************************************************************************/
+
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include "sw_uart.h"
+#include "../ICU/icu.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define SWUART_STOP_BIT			(SWUART_DATA_BITS + 1)	/*bit position of the stop bit, start bit is 0*/
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/*
+ * g_bounds[i]: ticks from the start bit edge to the middle of bit i, an edge before it
+ * starts bit i at the latest. g_bounds[SWUART_STOP_BIT] is where the frame is closed.
+ */
+static uint16 g_bounds[SWUART_STOP_BIT + 1];
+
+/*frame being received, only touched by the two Timer1 interrupts*/
+static boolean g_receiving = FALSE;
+static uint16 g_start_time;
+static uint8 g_position;			/*first bit not yet assigned a level*/
+static uint8 g_level;				/*line level since the last edge*/
+static uint8 g_data;
+
+/*Receive ring buffer (single producer: Timer1 interrupts, single consumer: main loop)*/
+static volatile uint8 g_rx_buffer[SWUART_RX_BUFFER_SIZE];
+static volatile uint8 g_rx_head = 0;
+static volatile uint8 g_rx_tail = 0;
+static volatile uint16 g_rx_overflow_count = 0;
+static volatile uint16 g_framing_error_count = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void SWUART_edgeCaptured(void);
+static void SWUART_startFrame(uint16 time);
+static void SWUART_fillBits(uint8 position);
+static void SWUART_closeFrame(void);
+static void SWUART_selectEdge(ICU_EdgeSelect edge);
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+
+/*middle of the stop bit: no edge since the last one, the remaining bits keep its level*/
+ISR(TIMER1_COMPB_vect){
+	if(g_receiving){
+		SWUART_closeFrame();
+	}
+}
+
+/*******************************************************************************
+ *                    	  Functions Definitions                                *
+ *******************************************************************************/
+
+void SWUART_init(const SWUART_ConfigType * a_configPtr){
+	ICU_ConfigType icu_config = {F_CPU_8, FALLING_EDGE};
+	uint32 bit_ticks_x2 = (2UL * F_CPU / SWUART_TIMER_DIVIDER) / pgm_read_dword(&a_configPtr->baud_rate);
+	uint8 i;
+
+	for(i = 0; i <= SWUART_STOP_BIT; i++){
+		g_bounds[i] = (uint16)(((2UL * i + 1) * bit_ticks_x2) / 4);
+	}
+	g_receiving = FALSE;
+	g_rx_head = 0;
+	g_rx_tail = 0;
+	ICU_setCallBackFunc(SWUART_edgeCaptured);
+	ICU_init(&icu_config); /*idle line is high, a frame starts with a falling edge*/
+}
+
+void SWUART_deInit(void){
+	CLEAR_BIT(TIMSK,OCIE1B);
+	ICU_deInit();
+	g_receiving = FALSE;
+}
+
+uint8 SWUART_rxCount(void){
+	return (uint8)(g_rx_head - g_rx_tail) & SWUART_RX_BUFFER_MASK;
+}
+
+boolean SWUART_readByte(uint8 * a_dataPtr){
+	if(g_rx_head == g_rx_tail){
+		return FALSE;
+	}
+	*a_dataPtr = g_rx_buffer[g_rx_tail];
+	g_rx_tail = (g_rx_tail + 1) & SWUART_RX_BUFFER_MASK;
+	return TRUE;
+}
+
+uint16 SWUART_getRxOverflowCount(void){
+	uint16 count;
+	uint8 sreg = SREG;
+
+	cli();
+	count = g_rx_overflow_count;
+	SREG = sreg;
+	return count;
+}
+
+uint16 SWUART_getFramingErrorCount(void){
+	uint16 count;
+	uint8 sreg = SREG;
+
+	cli();
+	count = g_framing_error_count;
+	SREG = sreg;
+	return count;
+}
+
+/*input capture callback (ISR context), ICR1 holds the time of the edge*/
+static void SWUART_edgeCaptured(void){
+	uint16 time = ICU_getInputCaptureValue();
+	uint16 elapsed;
+	uint8 position = 0;
+
+	if(!g_receiving){
+		SWUART_startFrame(time);
+		return;
+	}
+	elapsed = time - g_start_time; /*Timer1 wraps every 32 ms, longer than a frame*/
+	if(elapsed >= g_bounds[SWUART_STOP_BIT]){
+		/*compare B is still pending: this is the start bit of the next frame*/
+		SWUART_closeFrame();
+		if(g_level){
+			SWUART_startFrame(time);
+		}
+		return;
+	}
+	while(elapsed >= g_bounds[position]){
+		position++;
+	}
+	SWUART_fillBits(position);
+	g_level ^= 1;
+	SWUART_selectEdge(g_level ? FALLING_EDGE : RISING_EDGE);
+}
+
+static void SWUART_startFrame(uint16 time){
+	g_start_time = time;
+	g_position = 0;
+	g_level = 0;
+	g_data = 0;
+	g_receiving = TRUE;
+	OCR1B = time + g_bounds[SWUART_STOP_BIT];
+	TIFR = (1<<OCF1B); /*drop a match of the previous frame*/
+	SET_BIT(TIMSK,OCIE1B);
+	SWUART_selectEdge(RISING_EDGE);
+}
+
+/*bits from the current position up to (excluding) the given one had the current level*/
+static void SWUART_fillBits(uint8 position){
+	for( ; g_position < position; g_position++){
+		if(g_level && (g_position >= 1) && (g_position <= SWUART_DATA_BITS)){
+			g_data |= (uint8)(1 << (g_position - 1)); /*LSB first*/
+		}
+	}
+}
+
+static void SWUART_closeFrame(void){
+	uint8 next_head;
+
+	SWUART_fillBits(SWUART_STOP_BIT);
+	g_receiving = FALSE;
+	CLEAR_BIT(TIMSK,OCIE1B);
+	SWUART_selectEdge(FALLING_EDGE);
+	if(!g_level){
+		g_framing_error_count++; /*stop bit low, the line is resynchronized on the next start*/
+		return;
+	}
+	next_head = (g_rx_head + 1) & SWUART_RX_BUFFER_MASK;
+	if(next_head == g_rx_tail){
+		g_rx_overflow_count++; /*ring is full, the byte is lost*/
+	}
+	else{
+		g_rx_buffer[g_rx_head] = g_data;
+		g_rx_head = next_head;
+	}
+}
+
+/*changing the edge can raise a false capture flag, cleared as the datasheet requires*/
+static void SWUART_selectEdge(ICU_EdgeSelect edge){
+	ICU_setEdgeDetectionType(edge);
+	TIFR = (1<<ICF1);
+}
@@ -0,0 +1,98 @@
+/******************************************************************************
+ *
+ * [FILE NAME]:     sw_uart.h
+ *
+ * [AUTHOR]:        Omar Amr
+ *
+ * [DATE]:          18-10-2026
+ *
+ * [Description]:   Header file for the receive only software UART (Timer1 input capture)
+ *
+ * [TARGET HW]:		ATmega32
+ *
+ *******************************************************************************/
+
+/*
+ * The line is wired to ICP1 (PD6). Timer1 runs free at F_CPU/8 (0.5 us per tick) and every
+ * edge is timestamped in ICR1 by the hardware, so the interrupt latency does not move the
+ * sampling point: the bit positions are computed from the edge times relative to the start
+ * bit edge. Bits after the last edge of a frame are closed by the compare B match set in
+ * the middle of the stop bit. Two interrupts per transition instead of one per sampled bit,
+ * and no busy wait.
+ *
+ * Timer1 is owned by this driver (normal mode, compare A and overflow left unused).
+ */
+
+#ifndef SW_UART_H_
+#define SW_UART_H_
+
+#include "../../Utils/std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define SWUART_TIMER_DIVIDER		8UL			/*Timer1 prescaler*/
+#define SWUART_DATA_BITS			8
+/*
+ * Size of the receive ring buffer (must be a power of two, 256 at most). The GPS parsers take
+ * the bytes one by one, the ring only covers the main loop: 64 bytes are 66 ms at 9600 baud.
+ */
+#define SWUART_RX_BUFFER_SIZE		64
+#define SWUART_RX_BUFFER_MASK		(SWUART_RX_BUFFER_SIZE - 1)
+
+#if ((SWUART_RX_BUFFER_SIZE & SWUART_RX_BUFFER_MASK) != 0) || (SWUART_RX_BUFFER_SIZE > 256)
+#error "SWUART_RX_BUFFER_SIZE must be a power of two not exceeding 256"
+#endif
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+/*8 data bits, no parity, one stop bit, LSB first*/
+typedef struct{
+	uint32 baud_rate;		/*F_CPU / SWUART_TIMER_DIVIDER / baud_rate ticks per bit, 38400 at most*/
+}SWUART_ConfigType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Start Timer1 and the input capture interrupt on the falling edge of the start bit.
+ * The configuration is read from the flash (PROGMEM).
+ */
+void SWUART_init(const SWUART_ConfigType * a_configPtr);
+
+/*
+ * Description :
+ * Stop Timer1 and both of its interrupts.
+ */
+void SWUART_deInit(void);
+
+/*
+ * Description :
+ * Return the number of bytes waiting in the receive ring buffer.
+ */
+uint8 SWUART_rxCount(void);
+
+/*
+ * Description :
+ * Take the oldest received byte. Returns FALSE if the ring is empty.
+ */
+boolean SWUART_readByte(uint8 * a_dataPtr);
+
+/*
+ * Description :
+ * Return the number of bytes lost because the ring buffer was full.
+ */
+uint16 SWUART_getRxOverflowCount(void);
+
+/*
+ * Description :
+ * Return the number of frames dropped because the stop bit was low.
+ */
+uint16 SWUART_getFramingErrorCount(void);
+
+#endif /* SW_UART_H_ */
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ * [FILE NAME]:     systick.c
+ *
+ * [AUTHOR]:        Omar Amr
+ *
+ * [DATE]:          18-10-2026
+ *
+ * [Description]:   Source file for the millisecond system tick (Timer0 compare match)
+ *
+ * [TARGET HW]:		ATmega32
+ *
+ *******************************************************************************/
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "systick.h"
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static volatile uint32 g_systick_ms = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void SYSTICK_increment(void);
+
+/*******************************************************************************
+ *                    	  Functions Definitions                                *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Start Timer0 as a free running 1ms tick. Global interrupts must be enabled by the caller.
+ */
+void SYSTICK_init(void){
+	TIMER_ConfigType timer0_config = {
+			.timer_id = TIMER0_ID,
+			.timer_mode = COMPARE_MODE,
+			.timer_mode_data.ctc_compare_value = SYSTICK_COMPARE_VALUE,
+			.timer_prescaler.timer0 = TIMER0_F_CPU_64,
+			.timer_ocx_pin_behavior = DISCONNECT_OCX /*PB3 is used by the UART relay*/
+	};
+
+	TIMER_setCallBackFunc(TIMER0_ID, SYSTICK_increment);
+	TIMER_init(&timer0_config);
+}
+
+/*
+ * Description :
+ * Return the number of milliseconds elapsed since SYSTICK_init().
+ * The 32-bit counter is read with interrupts held off so it can not tear.
+ */
+uint32 SYSTICK_getMs(void){
+	uint32 ms;
+	uint8 sreg = SREG;
+	cli();
+	ms = g_systick_ms;
+	SREG = sreg;
+	return ms;
+}
+
+/*
+ * Description :
+ * Return the number of milliseconds elapsed since the given SYSTICK_getMs() time stamp.
+ */
+uint32 SYSTICK_elapsedMs(uint32 a_startMs){
+	return SYSTICK_getMs() - a_startMs;
+}
+
+static void SYSTICK_increment(void){
+	g_systick_ms++;
+}
@@ -0,0 +1,50 @@
+/******************************************************************************
+ *
+ * [FILE NAME]:     systick.h
+ *
+ * [AUTHOR]:        Omar Amr
+ *
+ * [DATE]:          18-10-2026
+ *
+ * [Description]:   Header file for the millisecond system tick (Timer0 compare match)
+ *
+ * [TARGET HW]:		ATmega32
+ *
+ *******************************************************************************/
+
+#ifndef SYSTICK_H_
+#define SYSTICK_H_
+
+#include "../../Utils/std_types.h"
+#include "timer.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*Timer0 in CTC mode with F_CPU/64: 16MHz / 64 / 250 = 1KHz*/
+#define SYSTICK_COMPARE_VALUE		249
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Start Timer0 as a free running 1ms tick. Global interrupts must be enabled by the caller.
+ */
+void SYSTICK_init(void);
+
+/*
+ * Description :
+ * Return the number of milliseconds elapsed since SYSTICK_init() (wraps after ~49 days).
+ */
+uint32 SYSTICK_getMs(void);
+
+/*
+ * Description :
+ * Return the number of milliseconds elapsed since the given SYSTICK_getMs() time stamp.
+ */
+uint32 SYSTICK_elapsedMs(uint32 a_startMs);
+
+#endif /* SYSTICK_H_ */
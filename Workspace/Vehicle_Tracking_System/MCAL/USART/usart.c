@@ -13,19 +13,85 @@
  *******************************************************************************/
 
 #include "usart.h"
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
 
 static volatile void (*g_USART_Call_Back_Ptr)(void) = NULL_PTR;
+static void (* volatile g_USART_Rx_Handler_Ptr)(uint8 data) = NULL_PTR;
 
-void USART_setCallBackFunction(void (*Fun_Ptr)(void)){
-	g_USART_Call_Back_Ptr = Fun_Ptr;
-}
+/*
+ * Receive ring buffer (single producer: RX ISR, single consumer: main loop).
+ * The head is only written by the ISR and the tail only by the consumer, so no locking
+ * is needed on the byte path. Complete lines are tracked with two free running counters
+ * (same ownership rule) and their difference gives the number of pending lines.
+ */
+static volatile uint8 g_rx_buffer[USART_RX_BUFFER_SIZE];
+static volatile uint8 g_rx_head = 0;
+static volatile uint8 g_rx_tail = 0;
+static volatile uint8 g_rx_lines_in = 0;
+static volatile uint8 g_rx_lines_out = 0;
+static volatile uint16 g_rx_overflow_count = 0;
+static volatile uint16 g_rx_overrun_count = 0;
+
+/*
+ * Transmit queue (single producer: main loop, single consumer: UDRE ISR).
+ * The producer only writes the head and the ISR only writes the tail.
+ */
+static volatile uint8 g_tx_buffer[USART_TX_BUFFER_SIZE];
+static volatile uint8 g_tx_head = 0;
+static volatile uint8 g_tx_tail = 0;
+static uint8 g_tx_high_water_mark = 0;
+static volatile boolean g_tx_started = FALSE; /*TXC is meaningless until the first byte is sent*/
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
 
 ISR(USART_RXC_vect){
+	uint8 next_head;
+	uint8 data;
+
+	if(BIT_IS_SET(UCSRA,DOR)){
+		g_rx_overrun_count++;
+	}
+	data = UDR; /*RXC is cleared after reading*/
+
+	if(g_USART_Rx_Handler_Ptr != NULL_PTR){
+		(*g_USART_Rx_Handler_Ptr)(data); /*byte stream consumed in ISR context, the ring is bypassed*/
+		return;
+	}
+
+	next_head = (g_rx_head + 1) & USART_RX_BUFFER_MASK;
+	if(next_head == g_rx_tail){
+		g_rx_overflow_count++; /*ring is full, the byte is lost*/
+	}
+	else{
+		g_rx_buffer[g_rx_head] = data;
+		g_rx_head = next_head;
+		if(data == USART_LINE_TERMINATOR){
+			g_rx_lines_in++;
+		}
+	}
+
 	if (g_USART_Call_Back_Ptr != NULL_PTR){
 		(*g_USART_Call_Back_Ptr)();
 	}
 }
 
+ISR(USART_UDRE_vect){
+	if(g_tx_head != g_tx_tail){
+		UDR = g_tx_buffer[g_tx_tail];
+		g_tx_tail = (g_tx_tail + 1) & USART_TX_BUFFER_MASK;
+		SET_BIT(UCSRA,TXC); /*writing one clears TXC, it is raised again once this byte is shifted out*/
+		g_tx_started = TRUE;
+	}
+	else{
+		CLEAR_BIT(UCSRB,UDRIE); /*nothing left to send*/
+	}
+}
 
 /*******************************************************************************
  *                     		 Functions Definitions                             *
@@ -37,6 +103,7 @@ ISR(USART_RXC_vect){
  * 1. Setup the Frame format like number of data bits, parity bit type and number of stop bits.
  * 2. Enable the USART.
  * 3. Setup the USART baud rate.
+ * The configuration is read from the flash (PROGMEM).
  */
 void USART_init(const USART_ConfigType * const a_usartConfigPtr){
 	uint16 reg_UBRR_value = 0;
@@ -53,8 +120,9 @@ void USART_init(const USART_ConfigType * const a_usartConfigPtr){
 	 * UCSZ2 = 1/0 For 9/other data bit mode
 	 * RXB8 & TXB8 not used for 8-bit data mode
 	 ***********************************************************************/
-	UCSRB = ((a_usartConfigPtr->usart_bit_mode & 0x04)) | (1<<TXEN) | (1<<RXEN) | (a_usartConfigPtr->usart_rx_interrupt<<RXCIE)\
-			|(a_usartConfigPtr->usart_tx_interrupt<<TXCIE);
+	UCSRB = ((pgm_read_byte(&a_usartConfigPtr->usart_bit_mode) & 0x04)) | (1<<TXEN) | (1<<RXEN)\
+			| (pgm_read_byte(&a_usartConfigPtr->usart_rx_interrupt)<<RXCIE)\
+			| (pgm_read_byte(&a_usartConfigPtr->usart_tx_interrupt)<<TXCIE);
 
 	/************************** UCSRC Description **************************
 	 * URSEL   = 1 The URSEL must be one when writing the UCSRC
@@ -63,16 +131,18 @@ void USART_init(const USART_ConfigType * const a_usartConfigPtr){
 	 * USBS    = 0/1 One/Two stop bit(s)
 	 * UCSZ1:0  (data bits mode config.)
 	 ***********************************************************************/
-	UCSRC = (1 << URSEL) | (a_usartConfigPtr->usart_mode << UMSEL) | (a_usartConfigPtr->usart_parity << UPM0)\
-			| ( a_usartConfigPtr->usart_stop_bits << USBS) | ((a_usartConfigPtr->usart_bit_mode & 0x03) << UCSZ0);
+	UCSRC = (1 << URSEL) | (pgm_read_byte(&a_usartConfigPtr->usart_mode) << UMSEL)\
+			| (pgm_read_byte(&a_usartConfigPtr->usart_parity) << UPM0)\
+			| (pgm_read_byte(&a_usartConfigPtr->usart_stop_bits) << USBS)\
+			| ((pgm_read_byte(&a_usartConfigPtr->usart_bit_mode) & 0x03) << UCSZ0);
 
-	if(a_usartConfigPtr->usart_mode == SYNCHRONOUS){
+	if(pgm_read_byte(&a_usartConfigPtr->usart_mode) == SYNCHRONOUS){
 		/* UCPOL   	(clock configuration for Async. mode)*/
-		UCSRC |= (a_usartConfigPtr->usart_clock_config << UCPOL);
+		UCSRC |= (pgm_read_byte(&a_usartConfigPtr->usart_clock_config) << UCPOL);
 	}
 
 	/* Calculate the UBRR register value */
-	reg_UBRR_value = (uint16)( ( F_CPU / (8UL * a_usartConfigPtr->usart_baud_rate) ) - 1 );
+	reg_UBRR_value = (uint16)( ( F_CPU / (8UL * pgm_read_dword(&a_usartConfigPtr->usart_baud_rate)) ) - 1 );
 
 	/*Clear URSEL to write in UBRRH Register*/
 	CLEAR_BIT(UBRRH,URSEL);
@@ -87,11 +157,8 @@ void USART_init(const USART_ConfigType * const a_usartConfigPtr){
  */
 void USART_sendByte(uint8 a_data){
 
-	/*Wait until the uart transmitter buffer is ready to recieve a new data*/
-	while(BIT_IS_CLEAR(UCSRA,UDRE));
-
-	/*Write data to UDR register (in transmission buffer) to be sent*/
-	UDR = a_data;
+	/*Wait only if the transmit queue is full, the UDRE ISR writes the data to UDR*/
+	while(!USART_queueByte(a_data));
 }
 
 /*
@@ -120,6 +187,194 @@ void USART_sendString(const uint8 * a_txStrPtr){
 	}
 }
 
+/*
+ * Description :
+ * Queue one byte for transmission without waiting. Returns FALSE if the queue is full.
+ */
+boolean USART_queueByte(uint8 a_data){
+	uint8 next_head = (g_tx_head + 1) & USART_TX_BUFFER_MASK;
+	uint8 count;
+
+	if(next_head == g_tx_tail){
+		return FALSE;
+	}
+	g_tx_buffer[g_tx_head] = a_data;
+	g_tx_head = next_head;
+	SET_BIT(UCSRB,UDRIE); /*(re)start the UDRE ISR*/
+
+	count = (next_head - g_tx_tail) & USART_TX_BUFFER_MASK;
+	if(count > g_tx_high_water_mark){
+		g_tx_high_water_mark = count;
+	}
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Queue as much of the string as fits without waiting and return the number of queued bytes.
+ */
+uint8 USART_queueString(const uint8 * a_txStrPtr){
+	uint8 i = 0;
+
+	while((a_txStrPtr[i] != '\0') && USART_queueByte(a_txStrPtr[i])){
+		i++;
+	}
+	return i;
+}
+
+/*
+ * Description :
+ * Return the number of free bytes in the transmit queue.
+ */
+uint8 USART_txFree(void){
+	return (USART_TX_BUFFER_MASK - ((g_tx_head - g_tx_tail) & USART_TX_BUFFER_MASK));
+}
+
+/*
+ * Description :
+ * Wait until the transmit queue is empty and the last byte has left the shift register.
+ */
+void USART_flush(void){
+	while(BIT_IS_SET(UCSRB,UDRIE));
+	while(g_tx_started && BIT_IS_CLEAR(UCSRA,TXC));
+}
+
+/*
+ * Description :
+ * Return the highest transmit queue occupancy seen since initialization.
+ */
+uint8 USART_getTxHighWaterMark(void){
+	return g_tx_high_water_mark;
+}
+
+/*
+ * Description :
+ * Set a function to be notified (from ISR context) after every received byte.
+ */
+void USART_setCallBackFunction(void (*Fun_Ptr)(void)){
+	g_USART_Call_Back_Ptr = Fun_Ptr;
+}
+
+/*
+ * Description :
+ * Hand every received byte to the given function from the RX ISR instead of the ring.
+ */
+void USART_setRxHandler(void (*a_handlerPtr)(uint8 data)){
+	g_USART_Rx_Handler_Ptr = a_handlerPtr;
+}
+
+/*
+ * Description :
+ * Return the number of bytes waiting in the receive ring buffer.
+ */
+uint8 USART_rxCount(void){
+	return (g_rx_head - g_rx_tail) & USART_RX_BUFFER_MASK;
+}
+
+/*
+ * Description :
+ * Return the byte at the given offset from the oldest unread byte without consuming it.
+ */
+uint8 USART_rxPeek(uint8 a_offset){
+	return g_rx_buffer[(g_rx_tail + a_offset) & USART_RX_BUFFER_MASK];
+}
+
+/*
+ * Description :
+ * Consume (discard) the given number of bytes from the receive ring buffer.
+ * Line terminators passed over are accounted so the pending lines count stays coherent.
+ */
+void USART_rxDrop(uint8 a_count){
+	uint8 tail = g_rx_tail;
+	uint8 available = USART_rxCount();
+
+	if(a_count > available){
+		a_count = available;
+	}
+	while(a_count--){
+		if(g_rx_buffer[tail] == USART_LINE_TERMINATOR){
+			g_rx_lines_out++;
+		}
+		tail = (tail + 1) & USART_RX_BUFFER_MASK;
+	}
+	g_rx_tail = tail;
+}
+
+/*
+ * Description :
+ * Return the number of complete lines waiting in the ring.
+ */
+uint8 USART_rxLinesPending(void){
+	return (uint8)(g_rx_lines_in - g_rx_lines_out);
+}
+
+/*
+ * Description :
+ * Return the length of the oldest complete line including its terminator, 0 if there is none.
+ */
+uint8 USART_rxLineLength(void){
+	uint8 i;
+	uint8 available;
+
+	if(USART_rxLinesPending() == 0){
+		return 0;
+	}
+	available = USART_rxCount();
+	for(i = 0; i < available; i++){
+		if(USART_rxPeek(i) == USART_LINE_TERMINATOR){
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Description :
+ * Consume the oldest complete line (including its terminator) from the ring.
+ */
+void USART_rxConsumeLine(void){
+	USART_rxDrop(USART_rxLineLength());
+}
+
+/*
+ * Description :
+ * Discard everything received so far. Interrupts are held off for the two stores
+ * so the ISR can not slip a line terminator in between them.
+ */
+void USART_rxFlush(void){
+	uint8 sreg = SREG;
+	cli();
+	g_rx_tail = g_rx_head;
+	g_rx_lines_out = g_rx_lines_in;
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * Return the number of bytes lost because the ring buffer was full.
+ */
+uint16 USART_getRxOverflowCount(void){
+	uint16 count;
+	uint8 sreg = SREG;
+	cli();
+	count = g_rx_overflow_count;
+	SREG = sreg;
+	return count;
+}
+
+/*
+ * Description :
+ * Return the number of hardware data overrun (DOR) errors seen by the receiver.
+ */
+uint16 USART_getRxOverrunCount(void){
+	uint16 count;
+	uint8 sreg = SREG;
+	cli();
+	count = g_rx_overrun_count;
+	SREG = sreg;
+	return count;
+}
+
 /*
  * Description :
  * Receive the required string until the terminator symbol.
@@ -28,6 +28,31 @@
 #define USART_SENDER_READY_BYTE			0x06 /*Byte sent from sender when it is ready to receive*/
 #define USART_RECEIVER_READY_BYTE		0x06 /*Byte sent from receiver when it is ready to receive*/
 
+/*
+ * Size of the receive ring buffer filled by the RX complete ISR (must be a power of two, 256 at most).
+ * It holds about 130 ms of modem output at 9600 baud. Less the longest line it keeps (an AT+CMGL
+ * header, about 62 bytes), the main loop must come back within about 70 ms while the modem
+ * streams: Host_Tests/gsm_stress.c loses bytes from 80 ms.
+ */
+#define USART_RX_BUFFER_SIZE			128
+#define USART_RX_BUFFER_MASK			(USART_RX_BUFFER_SIZE - 1)
+#define USART_LINE_TERMINATOR			'\n' /*Byte that closes a line in the receive stream*/
+
+#if ((USART_RX_BUFFER_SIZE & USART_RX_BUFFER_MASK) != 0) || (USART_RX_BUFFER_SIZE > 256)
+#error "USART_RX_BUFFER_SIZE must be a power of two not exceeding 256"
+#endif
+
+/*
+ * Size of the transmit queue drained by the data register empty ISR (must be a power of two, 256 at most).
+ * The GSM engine queues longer commands and payloads in parts as it drains.
+ */
+#define USART_TX_BUFFER_SIZE			32
+#define USART_TX_BUFFER_MASK			(USART_TX_BUFFER_SIZE - 1)
+
+#if ((USART_TX_BUFFER_SIZE & USART_TX_BUFFER_MASK) != 0) || (USART_TX_BUFFER_SIZE > 256)
+#error "USART_TX_BUFFER_SIZE must be a power of two not exceeding 256"
+#endif
+
 /*Mapped Peripheral registers addresses definitions*/
 #define UCSRA (*( (volatile uint8 * const) 	0x2B))
 #define UCSRB (*( (volatile uint8 * const) 	0x2A))
@@ -119,12 +144,14 @@ typedef struct{
  * 1. Setup the Frame format like number of data bits, parity bit type and number of stop bits.
  * 2. Enable the USART.
  * 3. Setup the USART baud rate.
+ * The configuration is read from the flash (PROGMEM).
  */
 void USART_init(const USART_ConfigType * const a_usartConfig);
 
 /*
  * Description :
  * Functional responsible for send byte to another UART device.
+ * The byte is queued for the UDRE interrupt, the call only waits while the queue is full.
  */
 void USART_sendByte(uint8 a_data);
 
@@ -134,10 +161,118 @@ void USART_sendByte(uint8 a_data);
  */
 uint8 USART_receiveByte(void);
 
+/*
+ * Description :
+ * Send the required string through UART to the other UART device.
+ * The string is queued for the UDRE interrupt, the call only waits while the queue is full.
+ */
+void USART_sendString(const uint8 * a_txStrPtr);
+
+/*
+ * Description :
+ * Queue one byte for transmission without waiting. Returns FALSE if the queue is full.
+ */
+boolean USART_queueByte(uint8 a_data);
+
+/*
+ * Description :
+ * Queue as much of the string as fits without waiting and return the number of queued bytes.
+ */
+uint8 USART_queueString(const uint8 * a_txStrPtr);
+
+/*
+ * Description :
+ * Return the number of free bytes in the transmit queue.
+ */
+uint8 USART_txFree(void);
+
+/*
+ * Description :
+ * Wait until the transmit queue is empty and the last byte has left the shift register.
+ */
+void USART_flush(void);
+
+/*
+ * Description :
+ * Return the highest transmit queue occupancy seen since initialization.
+ */
+uint8 USART_getTxHighWaterMark(void);
+
 /*
  * Description :
  * Receive the required string until the terminator symbol.
  */
 void USART_receiveString(uint8 * const a_rxStrPtr);
 
+/*
+ * Description :
+ * Set a function to be notified (from ISR context) after every received byte has been
+ * pushed into the receive ring buffer. The byte itself is read from the ring, not from UDR.
+ */
+void USART_setCallBackFunction(void (*Fun_Ptr)(void));
+
+/*
+ * Description :
+ * Hand every received byte to the given function (from ISR context) instead of pushing
+ * it into the receive ring, for byte stream parsers such as the GPS one. The handler must
+ * be short and bounded. Pass NULL_PTR to go back to the ring.
+ */
+void USART_setRxHandler(void (*a_handlerPtr)(uint8 data));
+
+/*
+ * Description :
+ * Return the number of bytes waiting in the receive ring buffer.
+ */
+uint8 USART_rxCount(void);
+
+/*
+ * Description :
+ * Return the byte at the given offset from the oldest unread byte without consuming it.
+ * The offset must be less than USART_rxCount().
+ */
+uint8 USART_rxPeek(uint8 a_offset);
+
+/*
+ * Description :
+ * Consume (discard) the given number of bytes from the receive ring buffer.
+ */
+void USART_rxDrop(uint8 a_count);
+
+/*
+ * Description :
+ * Return the number of complete lines (closed by USART_LINE_TERMINATOR) waiting in the ring.
+ */
+uint8 USART_rxLinesPending(void);
+
+/*
+ * Description :
+ * Return the length of the oldest complete line including its terminator, 0 if there is none.
+ * The line stays in the ring and is read in place with USART_rxPeek().
+ */
+uint8 USART_rxLineLength(void);
+
+/*
+ * Description :
+ * Consume the oldest complete line (including its terminator) from the ring.
+ */
+void USART_rxConsumeLine(void);
+
+/*
+ * Description :
+ * Discard everything received so far. Safe to call while reception is running.
+ */
+void USART_rxFlush(void);
+
+/*
+ * Description :
+ * Return the number of bytes lost because the ring buffer was full.
+ */
+uint16 USART_getRxOverflowCount(void);
+
+/*
+ * Description :
+ * Return the number of hardware data overrun (DOR) errors seen by the receiver.
+ */
+uint16 USART_getRxOverrunCount(void);
+
 #endif /*USART_H_*/
@@ -0,0 +1,324 @@
+/******************************************************************************
+ *
+ * [FILE NAME]:     geo.c
+ *
+ * [AUTHOR]:        Omar Amr
+ *
+ * [DATE]:          18-10-2026
+ *
+ * [Description]:   Integer geodesic math on 1e-7 degree coordinates (GPS_Fix format)
+ *
+ *******************************************************************************/
+
+#include "geo.h"
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define GEO_DEG_90				(90L * GEO_DEG)
+#define GEO_DEG_180				(180L * GEO_DEG)
+#define GEO_COS_FRACTION_Q16	3436UL			/*(units >> 7) * 3436 >> 16 = units / 1e7 in Q12*/
+#define GEO_ATAN_SHIFT			8				/*Q15 ratio to table index, 128 steps*/
+#define GEO_ATAN_SCALE			100				/*table unit (1e-5 degree) to coordinate unit*/
+#define GEO_HYPOT_BITS			15				/*operands kept below 2^15 so the squares add up in 32 bits*/
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/*cos(i degrees), Q15*/
+static const uint16 g_cos_table[91] PROGMEM = {
+		32768, 32763, 32748, 32723, 32688, 32643, 32588, 32524, 32449, 32365,
+		32270, 32166, 32052, 31928, 31795, 31651, 31499, 31336, 31164, 30983,
+		30792, 30592, 30382, 30163, 29935, 29698, 29452, 29197, 28932, 28660,
+		28378, 28088, 27789, 27482, 27166, 26842, 26510, 26170, 25822, 25466,
+		25102, 24730, 24351, 23965, 23571, 23170, 22763, 22348, 21926, 21498,
+		21063, 20622, 20174, 19720, 19261, 18795, 18324, 17847, 17364, 16877,
+		16384, 15886, 15384, 14876, 14365, 13848, 13328, 12803, 12275, 11743,
+		11207, 10668, 10126, 9580, 9032, 8481, 7927, 7371, 6813, 6252,
+		5690, 5126, 4560, 3993, 3425, 2856, 2286, 1715, 1144, 572,
+		0
+};
+
+/*atan(i / 128) in 1e-5 degrees*/
+static const uint32 g_atan_table[129] PROGMEM = {
+		0, 44761, 89517, 134262, 178991, 223698, 268378, 313024,
+		357633, 402199, 446716, 491179, 535583, 579922, 624191, 668386,
+		712502, 756532, 800473, 844319, 888066, 931709, 975242, 1018663,
+		1061966, 1105146, 1148199, 1191122, 1233909, 1276557, 1319061, 1361418,
+		1403624, 1445676, 1487568, 1529299, 1570864, 1612260, 1653484, 1694532,
+		1735402, 1776091, 1816596, 1856913, 1897041, 1936976, 1976717, 2016260,
+		2055605, 2094747, 2133686, 2172419, 2210945, 2249261, 2287367, 2325259,
+		2362938, 2400401, 2437647, 2474675, 2511483, 2548072, 2584439, 2620583,
+		2656505, 2692203, 2727676, 2762925, 2797947, 2832744, 2867315, 2901658,
+		2935775, 2969665, 3003328, 3036764, 3069972, 3102954, 3135709, 3168237,
+		3200538, 3232614, 3264464, 3296089, 3327489, 3358665, 3389617, 3420346,
+		3450852, 3481137, 3511201, 3541045, 3570669, 3600075, 3629263, 3658234,
+		3686990, 3715530, 3743857, 3771971, 3799873, 3827565, 3855047, 3882320,
+		3909386, 3936246, 3962901, 3989352, 4015600, 4041647, 4067494, 4093142,
+		4118593, 4143847, 4168906, 4193771, 4218444, 4242926, 4267218, 4291322,
+		4315239, 4338970, 4362517, 4385880, 4409062, 4432064, 4454886, 4477531,
+		4500000
+};
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static sint32 GEO_cosFirstQuadrant(uint32 angle);
+static sint32 GEO_atanRatio(uint16 ratio);
+static sint32 GEO_deltaLongitude(sint32 from, sint32 to);
+static sint32 GEO_abs(sint32 x);
+
+/*******************************************************************************
+ *                    	  Functions Definitions                                *
+ *******************************************************************************/
+
+sint32 GEO_cos(sint32 angle){
+	uint32 magnitude = (uint32)GEO_abs(angle) % (2UL * GEO_DEG_180);
+
+	if(magnitude > (uint32)GEO_DEG_180){
+		magnitude = 2UL * GEO_DEG_180 - magnitude; /*cos(360 - a) = cos(a)*/
+	}
+	if(magnitude > (uint32)GEO_DEG_90){
+		return -GEO_cosFirstQuadrant(GEO_DEG_180 - magnitude);
+	}
+	return GEO_cosFirstQuadrant(magnitude);
+}
+
+sint32 GEO_sin(sint32 angle){
+	uint32 magnitude = (uint32)GEO_abs(angle) % (2UL * GEO_DEG_180);
+	sint32 value;
+
+	if(magnitude > (uint32)GEO_DEG_180){
+		value = -GEO_cos(GEO_DEG_90 - (sint32)(magnitude - GEO_DEG_180)); /*sin(a) = -sin(a - 180)*/
+	}
+	else{
+		value = GEO_cos(GEO_DEG_90 - (sint32)magnitude);
+	}
+	return (angle < 0) ? -value : value;
+}
+
+sint32 GEO_atan2(sint32 y, sint32 x){
+	uint32 ax = (uint32)GEO_abs(x);
+	uint32 ay = (uint32)GEO_abs(y);
+	sint32 angle;
+
+	if((ax == 0) && (ay == 0)){
+		return 0;
+	}
+	while((ax | ay) >= 0x10000UL){ /*the smaller operand is shifted into Q15 below*/
+		ax >>= 1;
+		ay >>= 1;
+	}
+	if(ay <= ax){
+		angle = GEO_atanRatio((uint16)((ay << 15) / ax));
+	}
+	else{
+		angle = GEO_DEG_90 - GEO_atanRatio((uint16)((ax << 15) / ay));
+	}
+	if(x < 0){
+		angle = GEO_DEG_180 - angle;
+	}
+	return (y < 0) ? -angle : angle;
+}
+
+sint32 GEO_mulQ15(sint32 x, uint16 q){
+	uint32 magnitude = (uint32)GEO_abs(x);
+	uint32 product = (magnitude >> 15) * q + (((magnitude & 0x7FFFUL) * q + 0x4000) >> 15); /*rounded*/
+
+	return (x < 0) ? -(sint32)product : (sint32)product;
+}
+
+uint16 GEO_sqrt(uint32 x){
+	uint32 root = 0;
+	uint32 bit = 1UL << 30;
+
+	while(bit > x){
+		bit >>= 2;
+	}
+	while(bit != 0){
+		if(x >= root + bit){
+			x -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint16)root;
+}
+
+void GEO_offset(const GEO_Point * origin, const GEO_Point * point, sint32 * east_cm, sint32 * north_cm){
+	sint32 delta_latitude = point->latitude - origin->latitude;
+	sint32 delta_longitude = GEO_deltaLongitude(origin->longitude, point->longitude);
+	sint32 cos_latitude = GEO_cos(origin->latitude + delta_latitude / 2);
+
+	/*one rounding: cm per unit of longitude at this latitude, below 1.112 so still Q15*/
+	*east_cm = GEO_mulQ15(delta_longitude, (uint16)GEO_mulQ15(cos_latitude, GEO_CM_PER_UNIT_Q15));
+	*north_cm = GEO_mulQ15(delta_latitude, GEO_CM_PER_UNIT_Q15);
+}
+
+uint32 GEO_hypot(sint32 x, sint32 y){
+	uint32 ax = (uint32)GEO_abs(x);
+	uint32 ay = (uint32)GEO_abs(y);
+	uint32 square;
+	uint32 root;
+	uint8 shift = 0;
+
+	while((ax | ay) >= (1UL << GEO_HYPOT_BITS)){
+		ax >>= 1;
+		ay >>= 1;
+		shift++;
+	}
+	square = ax * ax + ay * ay;
+	root = GEO_sqrt(square);
+	if(square - root * root > root){
+		root++; /*rounded to the nearest*/
+	}
+	return root << shift;
+}
+
+uint32 GEO_equirectDistance(const GEO_Point * from, const GEO_Point * to){
+	sint32 east_cm;
+	sint32 north_cm;
+
+	GEO_offset(from, to, &east_cm, &north_cm);
+	return GEO_hypot(east_cm, north_cm);
+}
+
+/*
+ * hav = sin^2(dlat / 2) + cos(lat1) cos(lat2) sin^2(dlon / 2) in Q30, the central angle is
+ * 2 atan2(sqrt(hav), sqrt(1 - hav)) (no arcsine table needed).
+ */
+uint32 GEO_haversineDistance(const GEO_Point * from, const GEO_Point * to){
+	sint32 sin_latitude = GEO_sin((to->latitude - from->latitude) / 2);
+	sint32 sin_longitude = GEO_sin(GEO_deltaLongitude(from->longitude, to->longitude) / 2);
+	uint16 cos_product = (uint16)((GEO_cos(from->latitude) * GEO_cos(to->latitude) + 0x4000) >> 15);
+	uint32 hav = (uint32)(sin_latitude * sin_latitude)
+			+ (uint32)GEO_mulQ15(sin_longitude * sin_longitude, cos_product);
+	sint32 half_angle;
+
+	if(hav > (1UL << 30)){
+		hav = 1UL << 30;
+	}
+	half_angle = GEO_atan2(GEO_sqrt(hav), GEO_sqrt((1UL << 30) - hav));
+	return (uint32)GEO_mulQ15(2 * half_angle, GEO_CM_PER_UNIT_Q15);
+}
+
+uint32 GEO_distance(const GEO_Point * from, const GEO_Point * to){
+	if((GEO_abs(to->latitude - from->latitude) < GEO_EQUIRECT_MAX_DELTA) &&
+			(GEO_abs(GEO_deltaLongitude(from->longitude, to->longitude)) < GEO_EQUIRECT_MAX_DELTA)){
+		return GEO_equirectDistance(from, to);
+	}
+	return GEO_haversineDistance(from, to);
+}
+
+/*
+ * Close points: direction of the local offset. Distant points: great circle initial
+ * bearing atan2(sin dlon cos lat2, cos lat1 sin lat2 - sin lat1 cos lat2 cos dlon).
+ */
+uint16 GEO_bearing(const GEO_Point * from, const GEO_Point * to){
+	sint32 delta_longitude = GEO_deltaLongitude(from->longitude, to->longitude);
+	sint32 east;
+	sint32 north;
+	sint32 cos_to;
+	sint32 cos_delta;
+	sint32 sin_mean;
+	sint32 bearing;
+	sint32 convergence = 0;
+
+	if((GEO_abs(to->latitude - from->latitude) < GEO_EQUIRECT_MAX_DELTA) &&
+			(GEO_abs(delta_longitude) < GEO_EQUIRECT_MAX_DELTA)){
+		GEO_offset(from, to, &east, &north);
+		/*the offset gives the bearing at the midpoint, the meridians converge by dlon sin(lat)*/
+		sin_mean = GEO_sin(from->latitude + (to->latitude - from->latitude) / 2);
+		convergence = GEO_mulQ15(delta_longitude / 2, (uint16)GEO_abs(sin_mean));
+		convergence = (sin_mean < 0) ? -convergence : convergence;
+	}
+	else{
+		/*Q29 so the difference can not overflow*/
+		cos_to = GEO_cos(to->latitude);
+		cos_delta = GEO_cos(delta_longitude);
+		east = (GEO_sin(delta_longitude) * cos_to) >> 1;
+		north = GEO_mulQ15((GEO_sin(from->latitude) * cos_to) >> 1, (uint16)GEO_abs(cos_delta));
+		north = ((GEO_cos(from->latitude) * GEO_sin(to->latitude)) >> 1) - ((cos_delta < 0) ? -north : north);
+	}
+	bearing = (GEO_atan2(east, north) - convergence) / (GEO_DEG / 100); /*clockwise from north*/
+	return (uint16)((bearing < 0) ? bearing + 36000 : bearing);
+}
+
+void GEO_odometerInit(GEO_Odometer * odometer, uint16 min_step_cm){
+	odometer->total_m = 0;
+	odometer->remainder_cm = 0;
+	odometer->min_step_cm = min_step_cm;
+	odometer->started = FALSE;
+}
+
+uint32 GEO_odometerUpdate(GEO_Odometer * odometer, const GEO_Point * position){
+	uint32 step_cm;
+
+	if(!odometer->started){
+		odometer->anchor = *position;
+		odometer->started = TRUE;
+		return 0;
+	}
+	step_cm = GEO_distance(&odometer->anchor, position);
+	if(step_cm < odometer->min_step_cm){
+		return 0;
+	}
+	odometer->anchor = *position;
+	step_cm += odometer->remainder_cm;
+	odometer->total_m += step_cm / 100;
+	odometer->remainder_cm = (uint16)(step_cm % 100);
+	return step_cm - odometer->remainder_cm;
+}
+
+/*angle in [0, 90] degrees, linear interpolation between the table entries (Q12 fraction)*/
+static sint32 GEO_cosFirstQuadrant(uint32 angle){
+	uint8 index = (uint8)(angle / GEO_DEG);
+	sint32 fraction = (sint32)((((angle % GEO_DEG) >> 7) * GEO_COS_FRACTION_Q16) >> 16);
+	sint32 low;
+	sint32 high;
+
+	if(index >= 90){
+		return 0;
+	}
+	low = pgm_read_word(&g_cos_table[index]);
+	high = pgm_read_word(&g_cos_table[index + 1]);
+	return low + (((high - low) * fraction + 2048) >> 12); /*rounded*/
+}
+
+/*atan of a Q15 ratio in [0, 1], in coordinate units*/
+static sint32 GEO_atanRatio(uint16 ratio){
+	uint8 index = (uint8)(ratio >> GEO_ATAN_SHIFT);
+	uint8 fraction = (uint8)ratio;
+	sint32 low = (sint32)pgm_read_dword(&g_atan_table[index]);
+	sint32 high;
+
+	if(index >= 128){
+		return low * GEO_ATAN_SCALE;
+	}
+	high = (sint32)pgm_read_dword(&g_atan_table[index + 1]);
+	return (low + (((high - low) * fraction) >> 8)) * GEO_ATAN_SCALE;
+}
+
+/*to - from wrapped into -180 .. 180 degrees, computed on halves so it can not overflow*/
+static sint32 GEO_deltaLongitude(sint32 from, sint32 to){
+	sint32 half = to / 2 - from / 2;
+
+	if(half > GEO_DEG_90){
+		half -= GEO_DEG_180;
+	}
+	else if(half < -GEO_DEG_90){
+		half += GEO_DEG_180;
+	}
+	return 2 * half + (to % 2) - (from % 2);
+}
+
+static sint32 GEO_abs(sint32 x){
+	return (x < 0) ? -x : x;
+}
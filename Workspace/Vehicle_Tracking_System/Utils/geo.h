@@ -0,0 +1,111 @@
+/******************************************************************************
+ *
+ * [FILE NAME]:     geo.h
+ *
+ * [AUTHOR]:        Omar Amr
+ *
+ * [DATE]:          18-10-2026
+ *
+ * [Description]:   Integer geodesic math on 1e-7 degree coordinates (GPS_Fix format)
+ *
+ *******************************************************************************/
+
+/*
+ * Spherical earth (mean radius 6371008.8 m), distances in cm, angles in 1e-7 degrees.
+ * No float, no libm: cosine and arctangent come from small PROGMEM tables with linear
+ * interpolation, every product stays within 32 bits (split Q15 multiplies).
+ *
+ * Error against a double precision haversine on the same sphere (Host_Tests/geo_accuracy.c,
+ * random pairs up to 85 degrees of latitude, output in Host_Tests/results):
+ *   GEO_equirectDistance()   below 0.06 % + 2 cm up to GEO_EQUIRECT_MAX_DELTA apart (0.02 %
+ *                            up to 200 km below 60 degrees of latitude), grows with the square
+ *                            of the distance beyond it.
+ *   GEO_haversineDistance()  within 2 km (Q15 table resolution) up to 90 degrees apart, 5 km up
+ *                            to 150 degrees, tens of km near the antipode. Only used by
+ *                            GEO_distance() beyond GEO_EQUIRECT_MAX_DELTA, which keeps it within
+ *                            0.5 % + 2 cm.
+ *   GEO_bearing()            within 0.05 degree for points 10 m to 100 km apart below 70 degrees
+ *                            of latitude, 0.25 degree for any points over 10 m apart.
+ *   GEO_hypot()              below 0.02 %.
+ *   GEO_odometerUpdate()     0.03 % short over 36000 steps of 25 m.
+ * The sphere itself differs from WGS-84 by up to 0.5 %.
+ */
+
+#ifndef GEO_H_
+#define GEO_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define GEO_DEG					10000000L		/*one degree in coordinate units*/
+#define GEO_CM_PER_UNIT_Q15		36436U			/*arc length of 1e-7 degree, 1.11195 cm in Q15*/
+#define GEO_EQUIRECT_MAX_DELTA	(4L * GEO_DEG)	/*about 440 km, haversine beyond it*/
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef struct{
+	sint32 latitude;		/*1e-7 degrees, north positive*/
+	sint32 longitude;		/*1e-7 degrees, east positive*/
+}GEO_Point;
+
+/*
+ * Distance travelled: steps shorter than min_step_cm are not counted and do not move the
+ * anchor, so position noise while parked does not add up (slow moves are counted once
+ * they exceed it).
+ */
+typedef struct{
+	GEO_Point anchor;		/*last counted position*/
+	uint32 total_m;
+	uint16 remainder_cm;	/*part of the total below one metre*/
+	uint16 min_step_cm;
+	boolean started;
+}GEO_Odometer;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*cosine and sine of any angle, Q15 (-32768 .. 32768), within 2.5 LSB*/
+sint32 GEO_cos(sint32 angle);
+sint32 GEO_sin(sint32 angle);
+
+/*angle of the vector (x, y) from the x axis, counter clockwise, -180 .. 180 degrees (0.004 degree)*/
+sint32 GEO_atan2(sint32 y, sint32 x);
+
+/*x * q / 32768 without 64-bit arithmetic, the result must fit in 32 bits*/
+sint32 GEO_mulQ15(sint32 x, uint16 q);
+
+/*integer square root (floor)*/
+uint16 GEO_sqrt(uint32 x);
+
+/*
+ * Local east/north offset of the point from the origin in cm (equirectangular projection
+ * at the mean latitude). Accurate within GEO_EQUIRECT_MAX_DELTA, used to turn fixes into
+ * plane coordinates (geofences, track simplification).
+ */
+void GEO_offset(const GEO_Point * origin, const GEO_Point * point, sint32 * east_cm, sint32 * north_cm);
+
+/*length of the vector (x, y), relative error below 0.02 %*/
+uint32 GEO_hypot(sint32 x, sint32 y);
+
+/*great circle distance in cm, see the error bounds above*/
+uint32 GEO_equirectDistance(const GEO_Point * from, const GEO_Point * to);
+uint32 GEO_haversineDistance(const GEO_Point * from, const GEO_Point * to);
+
+/*equirectangular for close points, haversine for the others*/
+uint32 GEO_distance(const GEO_Point * from, const GEO_Point * to);
+
+/*initial bearing from north, clockwise, in 1e-2 degrees (0 .. 35999), 0 for equal points*/
+uint16 GEO_bearing(const GEO_Point * from, const GEO_Point * to);
+
+void GEO_odometerInit(GEO_Odometer * odometer, uint16 min_step_cm);
+
+/*count the move to the given position, returns the distance added in cm*/
+uint32 GEO_odometerUpdate(GEO_Odometer * odometer, const GEO_Point * position);
+
+#endif /* GEO_H_ */
@@ -15,58 +15,195 @@
 
 int main(void){
 
-	char sender_number [DIAL_NO_LENGTH];
-	char received_msg [REC_MSG_MAX_LENGTH];
+	char * sender_number;
+	char * received_msg;
 	/********** Peripherals configurations **********/
-	USART_ConfigType uart_config =
+	static const USART_ConfigType uart_config PROGMEM =
 	{
 			.usart_baud_rate = 9600,
 			.usart_bit_mode = DATA_BITS_8,
 			.usart_stop_bits = ONE_BIT,
 			.usart_mode = ASYNCHRONOUS,
-			.usart_parity = PARITY_DISABLED
+			.usart_parity = PARITY_DISABLED,
+			.usart_rx_interrupt = RX_INTERRUPT_ENABLED /*received bytes are queued in the RX ring buffer*/
 	};
 	
-	TIMER_ConfigType timer1_config = {
-			.timer_id = TIMER1_ID,
-			.timer_mode = COMPARE_MODE,
-			.timer_mode_data.ctc_compare_value = TIMER1_COMPARE_VALUE_3SEC,
-			.timer_prescaler.timer1 = TIMER1_F_CPU_1024,
-			.timer_ocx_pin_behavior = DISCONNECT_OCX
+	/*GPS output on ICP1 (PD6), Timer1 is used by the software UART*/
+	static const SWUART_ConfigType gps_uart_config PROGMEM = {
+			.baud_rate = 9600
 	};
-	
-	ADC_ConfigType adc_configuration = {
-			.prescaler = F_CPU_8,
+
+
+	/*
+	 * Every configuration stays in the flash (PROGMEM), the ones kept by their modules are read
+	 * from there while the program runs.
+	 */
+
+	/*telemetry server (a TCP listener on the LAN address works the same during bring-up)*/
+	static const char server_apn[] PROGMEM = "internet";
+	static const char server_host[] PROGMEM = "192.168.1.10";
+	static const char server_url[] PROGMEM = "http://192.168.1.10:8080/t";
+
+	static const GPRS_ConfigType gprs_config PROGMEM = {
+			.apn = server_apn,
+			.host = server_host,
+			.port = 5000
+	};
+
+	/*same server reached through the modem HTTP stack*/
+	static const HTTP_ConfigType http_config PROGMEM = {
+			.apn = server_apn,
+			.url = server_url
+	};
+
+	/*binary navigation messages, one fix per second*/
+	static const GPS_ConfigType gps_config PROGMEM = {
+			.protocol = GPS_PROTOCOL_UBX,
+			.fix_period_ms = 1000
+	};
+
+	/*GPS slices on the shared USART, the modem keeps priority for its commands*/
+	static const ARBITER_ConfigType arbiter_config PROGMEM = {
+			.gps_slice_ms = 3000,
+			.gps_min_slice_ms = 1200,
+			.gsm_min_slice_ms = 500,
+			.gps_max_wait_ms = 2000,
+			.on_gsm_resume = APP_modemResumed
+	};
+
+	/*cached position, refreshed by every fix received*/
+	static const LOCATION_ConfigType location_config PROGMEM = {
+			.wait_hook = APP_serviceModem
+	};
+
+	/*enter/exit alerts to the contact book*/
+	static const GEOFENCE_ConfigType geofence_config PROGMEM = {
+			.on_transition = APP_geofenceTransition
+	};
+
+	/*driving events to the contact book, the engine running is seen on the battery voltage*/
+	static const EVENTS_ConfigType events_config PROGMEM = {
+			.overspeed_cms = 2500,				/*90 km/h*/
+			.overspeed_hold_s = 10,
+			.idle_s = 300,
+			.harsh_acceleration_cms2 = 300,
+			.harsh_braking_cms2 = 400,
+			.harsh_cornering_cms2 = 400,
+			.rate_limit_s = 600,
+			.ignition_on = APP_ignitionOn,
+			.on_event = APP_drivingEvent
+	};
+
+	static const TELEMETRY_ConfigType telemetry_config PROGMEM = {
+			.transport = TELEMETRY_OVER_TCP,
+			.batch_records = 5,
+			.batch_age_ms = 60000
+	};
+
+	/*fixes reported to the server: Douglas-Peucker over the last fixes, 15 m tolerance*/
+	static const TRACK_ConfigType track_config PROGMEM = {
+			.mode = TRACK_MODE_WINDOW_DP,
+			.tolerance_m = 15,
+			.heading_change_cdeg = 1000,
+			.speed_change_cms = 500,
+			.max_interval_s = 120,
+			.on_point = APP_trackPoint
+	};
+
+	/*
+	 * CO alarms: 200 ppm (cleared below 150), a rise of 100 ppm within 16 s, and an 8 h average
+	 * exposure of 35 ppm (NIOSH limit). Readings smoothed over 8 samples after the median.
+	 */
+	static const COALARM_ConfigType co_alarm_config PROGMEM = {
+			.filter_shift = 3,
+			.alarm_ppm = 200,
+			.clear_ppm = 150,
+			.rise_ppm = 100,
+			.twa_ppm = 35
+	};
+
+	/*125 KHz ADC clock (50-200 KHz for the full 10 bit resolution)*/
+	static const ADC_ConfigType adc_configuration PROGMEM = {
+			.prescaler = F_CPU_128,
 			.ref_volt = ADC_InternalVoltageRef
 	};
 
-	/*set timer1 call back function*/
-	TIMER_setCallBackFunc(TIMER1_ID, APP_timerTickIncrement);
+	/*
+	 * One conversion per millisecond tick: battery every 10 ms, auxiliary every 20 ms and supply
+	 * every 50 ms, each after one settling conversion behind its divider. The CO sensor takes the
+	 * remaining two thirds of the ticks, averaged over 64 conversions.
+	 */
+	static const ADC_ChannelConfigType adc_channels[] PROGMEM = {
+			{.channel = SENSOR_OUTPUT_CHANNEL_ID, .oversampling_shift = 6, .decimation_shift = 6, .period = 1},
+			/*vehicle battery, 12 bits every 160 ms, smoothed over 8 results (cranking dips)*/
+			{.channel = ADC_ch1, .oversampling_shift = 4, .decimation_shift = 2, .period = 10,
+					.settle_conversions = 1, .filter_shift = 3},
+			/*board supply, 4 conversions every 200 ms*/
+			{.channel = ADC_ch2, .oversampling_shift = 2, .decimation_shift = 2, .period = 50,
+					.settle_conversions = 1},
+			/*fuel sender, 16 conversions every 320 ms, smoothed over 32 results (slosh)*/
+			{.channel = ADC_ch3, .oversampling_shift = 4, .decimation_shift = 4, .period = 20,
+					.settle_conversions = 1, .filter_shift = 5}
+	};
+
+	static const ADC_SamplingConfigType adc_sampling_config PROGMEM = {
+			.trigger = ADC_TRIGGER_TIMER0_COMPARE,
+			.channels = adc_channels,
+			.channel_count = sizeof(adc_channels) / sizeof(adc_channels[0])
+	};
+
+	/*2.56 V reference: 11:1 battery divider (28 V), 2:1 supply divider, fuel sender wired directly*/
+	static const AIN_ConfigType ain_config PROGMEM = {
+			.inputs = {
+					[AIN_BATTERY] = {.adc_channel = &adc_channels[1], .full_scale_mv = 28160},
+					[AIN_SUPPLY] = {.adc_channel = &adc_channels[2], .full_scale_mv = 5120},
+					[AIN_AUXILIARY] = {.adc_channel = &adc_channels[3], .full_scale_mv = 2560}
+			}
+	};
 
 	USART_init(&uart_config);
+	SWUART_init(&gps_uart_config);
+	SYSTICK_init();
+	sei(); /*enable global interrupts (USART and software UART ring buffers, timer ticks)*/
 	BUZZER_init();
 	LCD_init();
-	GPIO_setupPinDirection(PORTB_ID, PIN3_ID, PIN_OUTPUT); /*Initialize Relay Pin*/
+	ARBITER_init(&arbiter_config); /*relay pin, modem selected*/
+	AIDING_init();
+	APP_configureGPS(&gps_config); /*first, the receiver acquires while the sensor warms up and the modem registers*/
 	ADC_init(&adc_configuration);
+	ADC_startSampling(&adc_sampling_config);
+	AIN_init(&ain_config);
 	MQ_init();
-	APP_MQSenCalibration();
+	COCAL_init(); /*stored Ro, calibrated in the background if there is none*/
+	COALARM_init(&co_alarm_config);
 	APP_init();
+	if(pgm_read_byte(&telemetry_config.transport) == TELEMETRY_OVER_HTTP){
+		HTTP_init(&http_config);
+	}
+	else{
+		GPRS_init(&gprs_config);
+	}
+	TELEMETRY_init(&telemetry_config);
+	TRACK_init(&track_config);
+	LOCATION_init(&location_config);
+	GEOFENCE_init(&geofence_config);
+	EVENTS_init(&events_config);
 
 	LCD_clearScreen();
-	LCD_displayString("GSM Mod Detected");
+	LCD_displayString_P(PSTR("GSM Mod Detected"));
 	_delay_ms(1000);
 	LCD_clearScreen();
 	while(1){
-		if (APP_isMsgReceived(sender_number, received_msg)){
-			APP_decodeMsg(sender_number, received_msg, &timer1_config);
+		APP_serviceModem(); /*advance modem transactions, notifications and queued messages*/
+		LOCATION_task();
+		APP_checkPosition();
+		APP_reportTelemetry();
+		if (APP_isMsgReceived(&sender_number, &received_msg)){
+			APP_decodeMsg(sender_number, received_msg);
 		}
 		
 		// do sensor stuff here
-		LCD_displayString("CO =    PPM");
-		LCD_moveCursor(0,5);
-		LCD_intgerToString(APP_getCOVal());
-		if (APP_COThresholdExceeded()){
-			APP_fireEmergency(&timer1_config);
-		}
+		APP_displayCO(); /*20 ms at most, a pass must not outlast the GPS receive ring (66 ms)*/
+		APP_emergencyTask(); /*CO alerts and the buzzer*/
 	}
 }